@@ -0,0 +1,49 @@
+// Purpose: the few Arduino core functions the sketch calls directly, for the
+// host build. Hardware access goes through hal_host.cpp instead.
+
+#include <Arduino.h>
+#include "hal_host.h"
+#include <unistd.h>
+
+uint8_t SREG = 0;
+
+int analogRead(uint8_t) {
+    return 0;
+}
+
+// On the virtual clock the wait is a jump; on the real one, a sleep.
+void delay(unsigned long ms) {
+    uint64_t until = hal_host_timeUs() + (uint64_t)ms * 1000u;
+    hal_host_setTimeUs(until);
+    while (hal_host_timeUs() < until) usleep(1000);
+}
+
+// Same generator as avr-libc's random(), so a host run with a given seed
+// makes the same choices the board would.
+static uint32_t s_seed = 1;
+
+static long nextRandom() {
+    // Park-Miller "minimal standard" via Schrage's method.
+    int32_t x = (int32_t)s_seed;
+    if (x == 0) x = 123459876L;
+    int32_t hi = x / 127773L;
+    int32_t lo = x % 127773L;
+    x = 16807L * lo - 2836L * hi;
+    if (x < 0) x += 0x7FFFFFFFL;
+    s_seed = (uint32_t)x;
+    return x;
+}
+
+void randomSeed(unsigned long seed) {
+    if (seed != 0) s_seed = (uint32_t)seed;
+}
+
+long random(long howBig) {
+    if (howBig == 0) return 0;
+    return nextRandom() % howBig;
+}
+
+long random(long howSmall, long howBig) {
+    if (howSmall >= howBig) return howSmall;
+    return random(howBig - howSmall) + howSmall;
+}
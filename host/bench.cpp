@@ -0,0 +1,444 @@
+// Purpose: micro-benchmarks of the firmware's hot paths on the host HAL.
+// Each case runs in batches; the JSON report gives the median and fastest
+// batch as nanoseconds per call, plus heap allocations per call, so two
+// commits can be compared with tools/bench_compare.py.
+//
+// Usage: screen_tapper_bench [--out FILE] [--label TEXT] [--filter TEXT]
+//                            [--batches N]
+//   --out FILE     JSON report (default: stdout)
+//   --label TEXT   stored in the report, e.g. the commit id
+//   --filter TEXT  only run cases whose name contains TEXT
+//   --batches N    timed batches per case (default 31)
+//
+// The LCD is the host HAL's text recorder, not U8g2, so the display cases
+// measure view layout, formatting and HAL traffic but not rasterising.
+// Host timings track relative changes; they are not AVR cycle counts.
+
+#include "hal_host.h"
+#include "config.h"
+#include "display.h"
+#include "menu.h"
+#include "format.h"
+#include "clock.h"
+#include "eeprom_queue.h"
+#include "gem_store.h"
+#include "stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// Allocation counting
+// ---------------------------------------------------------------------------
+// The firmware never touches the heap; these catch anything that starts to
+// (including libc calls that allocate behind the scenes).
+
+extern "C" void* __libc_malloc(size_t);
+extern "C" void* __libc_calloc(size_t, size_t);
+extern "C" void* __libc_realloc(void*, size_t);
+extern "C" void  __libc_free(void*);
+
+static bool     s_countAllocs = false;
+static uint64_t s_allocs      = 0;
+
+extern "C" void* malloc(size_t n) {
+    if (s_countAllocs) s_allocs++;
+    return __libc_malloc(n);
+}
+
+extern "C" void* calloc(size_t n, size_t size) {
+    if (s_countAllocs) s_allocs++;
+    return __libc_calloc(n, size);
+}
+
+extern "C" void* realloc(void* p, size_t n) {
+    if (s_countAllocs) s_allocs++;
+    return __libc_realloc(p, n);
+}
+
+extern "C" void free(void* p) {
+    __libc_free(p);
+}
+
+// ---------------------------------------------------------------------------
+// Harness
+// ---------------------------------------------------------------------------
+
+struct Case {
+    const char* name;
+    void     (*setup)();            // before every batch, not timed; may be null
+    void     (*body)(uint32_t i);   // the call being measured
+    uint32_t   callsPerBatch;
+};
+
+struct Result {
+    const char* name;
+    uint64_t    calls;
+    double      nsMedian;
+    double      nsMin;
+    double      allocsPerCall;
+};
+
+static volatile uint32_t g_sink;    // keeps results alive past the optimizer
+
+static uint64_t nowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static Result run(const Case& c, uint32_t batches) {
+    // One untimed batch warms caches and any lazy state.
+    if (c.setup) c.setup();
+    for (uint32_t i = 0; i < c.callsPerBatch; ++i) c.body(i);
+
+    std::vector<double> perCall;
+    uint64_t allocs = 0;
+    for (uint32_t b = 0; b < batches; ++b) {
+        if (c.setup) c.setup();
+        s_allocs      = 0;
+        s_countAllocs = true;
+        uint64_t t0 = nowNs();
+        for (uint32_t i = 0; i < c.callsPerBatch; ++i) c.body(i);
+        uint64_t t1 = nowNs();
+        s_countAllocs = false;
+        allocs += s_allocs;
+        perCall.push_back((double)(t1 - t0) / c.callsPerBatch);
+    }
+    std::sort(perCall.begin(), perCall.end());
+
+    Result r;
+    r.name          = c.name;
+    r.calls         = (uint64_t)batches * c.callsPerBatch;
+    r.nsMedian      = perCall[perCall.size() / 2];
+    r.nsMin         = perCall.front();
+    r.allocsPerCall = (double)allocs / r.calls;
+    return r;
+}
+
+// Small LCG so the scripted inputs are the same on every run.
+static uint32_t s_rng = 1;
+static uint32_t nextRand() {
+    s_rng = s_rng * 1103515245u + 12345u;
+    return s_rng >> 16;
+}
+
+// ---------------------------------------------------------------------------
+// Display: one full frame per view kind
+// ---------------------------------------------------------------------------
+
+static const char* const kListItems[] = {
+    "Home", "Enable/Disable", "Reset Next Tap", "Tap Duration",
+    "Tap Duty", "Sleep Time", "Wake Time", "Gem Count",
+    "Test Mode", "Override Sleep", "Diagnostics",
+};
+
+static DiagnosticsData s_diag;
+static MenuView        s_view;
+
+static void viewBase() {
+    s_view = {};
+    s_view.deviceEnabled = true;
+    s_view.tapDuration   = 160;
+    s_view.sleepHour     = 23;
+    s_view.sleepMinute   = 59;
+    s_view.wakeHour      = 7;
+    s_view.wakeMinute    = 30;
+}
+
+static void setupHome() {
+    viewBase();
+    s_view.kind         = ViewKind::Home;
+    s_view.title        = "Home";
+    s_view.lifetimeGems = 1234567;
+}
+
+static void setupList() {
+    viewBase();
+    s_view.kind      = ViewKind::List;
+    s_view.title     = "Settings";
+    s_view.items     = kListItems;
+    s_view.itemCount = sizeof(kListItems) / sizeof(kListItems[0]);
+}
+
+static void setupEditNumber() {
+    viewBase();
+    s_view.kind    = ViewKind::EditNumber;
+    s_view.title   = "Gem Count";
+    s_view.value   = 1234567;
+    s_view.minVal  = GEMS_MIN;
+    s_view.maxVal  = GEMS_MAX;
+    s_view.editing = true;
+}
+
+static void setupEditTime() {
+    viewBase();
+    s_view.kind        = ViewKind::EditTime;
+    s_view.title       = "Sleep Time";
+    s_view.hh          = 23;
+    s_view.mm          = 59;
+    s_view.editingTime = true;
+}
+
+static void setupDiagnostics() {
+    viewBase();
+    s_diag.uptimeSec      = 987654;
+    s_diag.loopsPerSec    = 41000;
+    s_diag.maxLoopUs      = 3412;
+    s_diag.framesRendered = 123456;
+    s_diag.eepromWrites   = 54321;
+    s_diag.tapCycles      = 9876;
+    s_diag.ramMinFree     = 5120;
+    s_diag.heatPercent[1] = 37;
+    s_view.kind  = ViewKind::Diagnostics;
+    s_view.title = "Diagnostics";
+    s_view.diag  = &s_diag;
+}
+
+// Daily bins: every frame reads the EEPROM ring, the costlier of the two.
+static void setupStats() {
+    viewBase();
+    stats_begin(hal_millis());
+    for (uint8_t i = 0; i < 40; ++i) {
+        stats_cycleFired((uint8_t)(i % 7));
+        stats_cycleEnded(15000);
+    }
+    stats_flush();
+    eeprom_queue_flush();
+    s_view.kind     = ViewKind::Stats;
+    s_view.title    = "Yield";
+    s_view.selected = 1;
+}
+
+static void drawHome(uint32_t i) {
+    s_view.msLeft = 600000 - i * 100;     // the countdown changes every frame
+    display_renderNow(s_view);
+}
+
+static void drawList(uint32_t i) {
+    s_view.selected = (uint8_t)(i % s_view.itemCount);
+    display_renderNow(s_view);
+}
+
+static void drawView(uint32_t) {
+    display_renderNow(s_view);
+}
+
+// ---------------------------------------------------------------------------
+// Formatting
+// ---------------------------------------------------------------------------
+
+static void fmtCommas(uint32_t i) {
+    char buf[16];
+    fmt_commas(i * 2654435761u, buf, sizeof(buf));
+    g_sink = g_sink + (uint8_t)buf[0];
+}
+
+static void fmtMmSs(uint32_t i) {
+    char buf[8];
+    fmt_mm_ss(i * 977u, buf, sizeof(buf));
+    g_sink = g_sink + (uint8_t)buf[4];
+}
+
+// ---------------------------------------------------------------------------
+// Menu: scripted encoder streams
+// ---------------------------------------------------------------------------
+
+static void menuIdleSetup() {
+    menu_begin();
+}
+
+// The common case: a pass with no input on the home screen.
+static void menuIdle(uint32_t) {
+    MenuAction a;
+    g_sink = g_sink + menu_update(0, false, a);
+}
+
+static void menuScrollSetup() {
+    menu_begin();
+    MenuAction a;
+    menu_update(0, true, a);             // into Settings
+}
+
+// Spinning the knob through the settings list, no presses.
+static void menuScroll(uint32_t i) {
+    MenuAction a;
+    g_sink = g_sink + menu_update((i & 8) ? -1 : 1, false, a);
+}
+
+static void menuMixedSetup() {
+    menu_begin();
+    s_rng = 1;
+}
+
+// Random turns and presses, opening editors the way the sketch does, so
+// every screen's update path is exercised.
+static void menuMixed(uint32_t) {
+    uint32_t r = nextRand();
+    int  d       = (int)(r % 5) - 2;
+    bool pressed = (r & 0x70) == 0;
+    MenuAction a;
+    if (!menu_update(d, pressed, a) || a.committed) return;
+    switch (a.type) {
+        case MenuActionType::SetTapDuration:       menu_openTapDurationEditor(160); break;
+        case MenuActionType::SetTapDuty:           menu_openTapDutyEditor(255);     break;
+        case MenuActionType::EnterSleepTimeEditor: menu_openSleepTimeEditor(23, 59); break;
+        case MenuActionType::EnterWakeTimeEditor:  menu_openWakeTimeEditor(7, 30);  break;
+        case MenuActionType::SetGemCount:          menu_openGemCountEditor(12345);  break;
+        default: break;
+    }
+}
+
+static void menuView(uint32_t) {
+    MenuView v;
+    menu_getView(v);
+    g_sink = g_sink + (uint32_t)v.kind;
+}
+
+// ---------------------------------------------------------------------------
+// Clock
+// ---------------------------------------------------------------------------
+
+static SleepSchedule s_sched;
+
+static void clockAwake(uint32_t) {
+    g_sink = g_sink + clock_isAwake(s_sched);
+}
+
+// ---------------------------------------------------------------------------
+// Gem store at several fill levels of the active bitmap
+// ---------------------------------------------------------------------------
+// scan  = gem_store_begin(): resolve the base slot and count the bitmap
+// flush = the gem_store_add_session() call that crosses kGemSaveThreshold;
+//         at 100% it rebases (erases the other bitmap, writes a new slot)
+
+static constexpr uint16_t kBitmapBits = 512;   // gem_store.cpp BITMAP_BITS
+static uint16_t s_fillBits = 0;
+
+static void fillStore() {
+    gem_store_clear_all();
+    if (s_fillBits) gem_store_add_session((uint32_t)s_fillBits * kGemUnit);
+    eeprom_queue_flush();
+}
+
+static void gemScan(uint32_t) {
+    gem_store_begin();
+    g_sink = g_sink + gem_store_total();
+}
+
+static void gemFlush(uint32_t) {
+    g_sink = g_sink + gem_store_add_session(kGemSaveThreshold);
+    eeprom_queue_flush();
+}
+
+template <uint16_t Percent>
+static void fillSetup() {
+    s_fillBits = (uint16_t)((uint32_t)kBitmapBits * Percent / 100);
+    fillStore();
+}
+
+// ---------------------------------------------------------------------------
+// Report
+// ---------------------------------------------------------------------------
+
+static void writeJson(FILE* f, const char* label, const std::vector<Result>& results) {
+    fprintf(f, "{\n  \"schema\": 1,\n  \"label\": \"");
+    for (const char* p = label; *p; ++p) {
+        if (*p == '"' || *p == '\\') fputc('\\', f);
+        if ((unsigned char)*p >= 0x20) fputc(*p, f);
+    }
+    fprintf(f, "\",\n  \"unit\": \"ns/call\",\n  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        fprintf(f, "    {\"name\": \"%s\", \"calls\": %llu, \"median\": %.1f, "
+                   "\"min\": %.1f, \"allocs_per_call\": %.3f}%s\n",
+                r.name, (unsigned long long)r.calls, r.nsMedian, r.nsMin,
+                r.allocsPerCall, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s [--out FILE] [--label TEXT] [--filter TEXT] [--batches N]\n", argv0);
+}
+
+int main(int argc, char** argv) {
+    const char* outPath = nullptr;
+    const char* label   = "";
+    const char* filter  = nullptr;
+    uint32_t    batches = 31;
+    for (int i = 1; i < argc; ++i) {
+        bool more = i + 1 < argc;
+        if (strcmp(argv[i], "--out") == 0 && more) {
+            outPath = argv[++i];
+        } else if (strcmp(argv[i], "--label") == 0 && more) {
+            label = argv[++i];
+        } else if (strcmp(argv[i], "--filter") == 0 && more) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--batches") == 0 && more) {
+            batches = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (batches == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // Fixed clock and a silent console, so runs are repeatable. The RTC
+    // reads 2025-01-06 12:00, inside the default awake window.
+    hal_host_setSerialOutput(nullptr);
+    hal_host_useVirtualTime(1736164800);
+    eeprom_queue_begin();
+    clock_begin();
+    display_begin();
+    menu_begin();
+    gem_store_begin();
+
+    const Case cases[] = {
+        { "display/home",        setupHome,        drawHome,  2000 },
+        { "display/list",        setupList,        drawList,  2000 },
+        { "display/edit_number", setupEditNumber,  drawView,  2000 },
+        { "display/edit_time",   setupEditTime,    drawView,  2000 },
+        { "display/diagnostics", setupDiagnostics, drawView,  2000 },
+        { "display/stats",       setupStats,       drawView,  2000 },
+        { "format/commas",       nullptr,          fmtCommas, 20000 },
+        { "format/mm_ss",        nullptr,          fmtMmSs,   20000 },
+        { "menu/idle",           menuIdleSetup,    menuIdle,  100000 },
+        { "menu/scroll",         menuScrollSetup,  menuScroll, 100000 },
+        { "menu/mixed",          menuMixedSetup,   menuMixed, 100000 },
+        { "menu/get_view",       menuMixedSetup,   menuView,  100000 },
+        { "clock/is_awake",      nullptr,          clockAwake, 20000 },
+        { "gem/scan_0",          fillSetup<0>,     gemScan,   200 },
+        { "gem/scan_50",         fillSetup<50>,    gemScan,   200 },
+        { "gem/scan_100",        fillSetup<100>,   gemScan,   200 },
+        { "gem/flush_0",         fillSetup<0>,     gemFlush,  1 },
+        { "gem/flush_25",        fillSetup<25>,    gemFlush,  1 },
+        { "gem/flush_50",        fillSetup<50>,    gemFlush,  1 },
+        { "gem/flush_75",        fillSetup<75>,    gemFlush,  1 },
+        { "gem/flush_100",       fillSetup<100>,   gemFlush,  1 },
+    };
+
+    std::vector<Result> results;
+    for (const Case& c : cases) {
+        if (filter && !strstr(c.name, filter)) continue;
+        Result r = run(c, batches);
+        fprintf(stderr, "%-22s %10.1f ns/call (min %.1f)  %.3f allocs/call\n",
+                r.name, r.nsMedian, r.nsMin, r.allocsPerCall);
+        results.push_back(r);
+    }
+
+    FILE* out = outPath ? fopen(outPath, "w") : stdout;
+    if (!out) {
+        perror(outPath);
+        return 2;
+    }
+    writeJson(out, label, results);
+    if (out != stdout) fclose(out);
+    return 0;
+}
@@ -0,0 +1,25 @@
+#pragma once
+// Host stand-in for the Arduino core header: just the parts of the core the
+// sketch still uses directly (flash strings, the SREG/cli() critical-section
+// idiom, random(), delay()). Hardware goes through hal.h.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+#define HIGH 1
+#define LOW  0
+
+typedef uint8_t byte;
+
+int  analogRead(uint8_t pin);   // always 0: host runs start from a fixed seed
+void delay(unsigned long ms);
+
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
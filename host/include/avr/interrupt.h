@@ -0,0 +1,5 @@
+#pragma once
+// Host stand-in: nothing interrupts the host build, so these do nothing.
+
+inline void cli() {}
+inline void sei() {}
@@ -0,0 +1,8 @@
+#pragma once
+// Host stand-in: SREG exists so the save/cli()/restore idiom compiles. There
+// are no interrupts on the host, so it carries no meaning.
+#include <stdint.h>
+
+extern uint8_t SREG;
+
+#define _BV(bit) (1u << (bit))
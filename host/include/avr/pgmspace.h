@@ -0,0 +1,24 @@
+#pragma once
+// Host stand-in: flash and RAM share one address space, so the _P
+// functions are the plain ones.
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P   const char*
+#define PSTR(s) (s)
+
+#define pgm_read_byte(p)  (*(const uint8_t*)(p))
+#define pgm_read_word(p)  (*(const uint16_t*)(p))
+#define pgm_read_dword(p) (*(const uint32_t*)(p))
+#define pgm_read_ptr(p)   (*(void* const*)(p))
+
+#define strcpy_P    strcpy
+#define strncpy_P   strncpy
+#define strcmp_P    strcmp
+#define strlen_P    strlen
+#define memcpy_P    memcpy
+#define snprintf_P  snprintf
+#define vsnprintf_P vsnprintf
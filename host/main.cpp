@@ -0,0 +1,53 @@
+// Purpose: run the firmware on Linux. setup() once, then loop() until
+// interrupted, on the in-memory HAL. The serial console is stdin/stdout.
+//
+// Usage: screen_tapper_host [--lcd] [--seconds N]
+//   --lcd        print each LCD frame to stderr as text
+//   --seconds N  exit after N seconds of run time
+
+#include "hal_host.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+void setup();
+void loop();
+
+static void printFrame() {
+    fprintf(stderr, "--- frame %lu at %lu ms\n",
+            (unsigned long)hal_host_lcdFrames(), (unsigned long)hal_millis());
+    for (uint8_t i = 0; i < hal_host_lcdRunCount(); ++i) {
+        const LcdRun& r = hal_host_lcdRun(i);
+        fprintf(stderr, "%4d %3d  %s\n", r.x, r.y, r.text);
+    }
+}
+
+int main(int argc, char** argv) {
+    bool     showLcd = false;
+    uint32_t runMs   = 0;   // 0 = forever
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--lcd") == 0) {
+            showLcd = true;
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            runMs = (uint32_t)strtoul(argv[++i], nullptr, 10) * 1000u;
+        } else {
+            fprintf(stderr, "usage: %s [--lcd] [--seconds N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    setup();
+    uint32_t start      = hal_millis();
+    uint32_t lastFrames = hal_host_lcdFrames();
+    for (;;) {
+        loop();
+        if (showLcd && hal_host_lcdFrames() != lastFrames) {
+            lastFrames = hal_host_lcdFrames();
+            printFrame();
+        }
+        if (runMs && hal_millis() - start >= runMs) break;
+        usleep(1000);   // the board loops flat out; no need to spin a core
+    }
+    return 0;
+}
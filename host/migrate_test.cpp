@@ -0,0 +1,238 @@
+// Purpose: checks of the persisted-format migrations on the host HAL's
+// in-memory EEPROM. Each case writes an older layout byte by byte, boots the
+// store on it and checks what comes back; most then boot again to check the
+// upgraded layout reads the same.
+//
+//   gem counter:  layout 1 (index at 0, slots from 256) -> layout 2, with
+//                 and without a torn last slot, with the live slot under
+//                 both bitmaps, and cut off after the new index; layout 2
+//                 read back as is
+//   settings:     schema 1 record -> schema 2; per-field layout -> record;
+//                 an unknown schema is rejected
+//
+// Usage: screen_tapper_migrate_test
+// Prints one line per check and exits 1 if any failed.
+
+#include "hal_host.h"
+#include "eeprom_queue.h"
+#include "gem_store.h"
+#include "settings_store.h"
+#include "crc16.h"
+#include "config.h"
+#include <stdio.h>
+#include <string.h>
+
+static int s_failed = 0;
+
+static void check(bool ok, const char* what) {
+    printf("  %-52s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) s_failed++;
+}
+
+static void eraseAll() {
+    for (uint16_t a = 0; a < eeprom_queue_length(); ++a) eeprom_queue_write(a, 0xFF);
+    eeprom_queue_flush();
+}
+
+// ---------------------------------------------------------------------------
+// Gem counter
+// ---------------------------------------------------------------------------
+
+static constexpr uint16_t LEGACY_INDEX_ADDR   = 0;
+static constexpr uint16_t LEGACY_SLOTS_START  = 256;
+static constexpr uint16_t LAYOUT_VERSION_ADDR = 255;
+
+static void putLegacySlot(uint16_t slot, uint32_t value, bool torn) {
+    uint16_t addr = (uint16_t)(LEGACY_SLOTS_START + slot * 5);
+    eeprom_queue_put(addr, value);
+    uint8_t chk = (uint8_t)(value ^ (value >> 8) ^ (value >> 16) ^ (value >> 24));
+    eeprom_queue_write(addr + 4, torn ? (uint8_t)~chk : chk);
+}
+
+static void legacyGems() {
+    eraseAll();
+    putLegacySlot(6, 123400, false);
+    putLegacySlot(7, 123456, false);
+    eeprom_queue_put(LEGACY_INDEX_ADDR, (uint16_t)7);
+    eeprom_queue_flush();
+
+    gem_store_begin();
+    eeprom_queue_flush();
+    check(gem_store_total() == 123456, "gems: layout 1 count carried over");
+    check(eeprom_queue_read(LAYOUT_VERSION_ADDR) == 2, "gems: layout byte written");
+
+    gem_store_begin();
+    check(gem_store_total() == 123456, "gems: migrated count reads back on reboot");
+}
+
+// Legacy slots 11..13 lie across the end of bitmap A and the start of B, so
+// neither bitmap can be left alone while the live slot and its fallback are.
+static void legacyGemsUnderBitmaps() {
+    static const uint16_t kSlots[] = {12, 13};
+    for (uint8_t i = 0; i < 2; ++i) {
+        uint16_t L = kSlots[i];
+        eraseAll();
+        putLegacySlot((uint16_t)(L - 1), 50000, false);
+        putLegacySlot(L, 50005, false);
+        eeprom_queue_put(LEGACY_INDEX_ADDR, L);
+        eeprom_queue_flush();
+
+        char what[56];
+        gem_store_begin();
+        eeprom_queue_flush();
+        snprintf(what, sizeof(what), "gems: layout 1 slot %u under both bitmaps kept", L);
+        check(gem_store_total() == 50005, what);
+
+        gem_store_begin();
+        snprintf(what, sizeof(what), "gems: layout 1 slot %u read back on reboot", L);
+        check(gem_store_total() == 50005, what);
+    }
+}
+
+// Power lost after the new index committed but before the layout byte: the
+// bitmap erase may have reached the legacy slots, so the rerun must not read
+// them again.
+static void legacyGemsInterrupted() {
+    eraseAll();
+    putLegacySlot(11, 50000, false);
+    putLegacySlot(12, 50005, false);
+    eeprom_queue_put(LEGACY_INDEX_ADDR, (uint16_t)12);
+    eeprom_queue_flush();
+
+    gem_store_begin();
+    eeprom_queue_flush();
+    eeprom_queue_write(LAYOUT_VERSION_ADDR, 0xFF);
+    for (uint16_t a = 256; a < 384; ++a) eeprom_queue_write(a, 0xFF);
+    eeprom_queue_flush();
+
+    gem_store_begin();
+    eeprom_queue_flush();
+    check(gem_store_total() == 50005, "gems: interrupted migration finishes from new base");
+    check(eeprom_queue_read(LAYOUT_VERSION_ADDR) == 2, "gems: layout byte written on the rerun");
+}
+
+static void legacyGemsTorn() {
+    eraseAll();
+    putLegacySlot(6, 123400, false);
+    putLegacySlot(7, 123456, true);
+    eeprom_queue_put(LEGACY_INDEX_ADDR, (uint16_t)7);
+    eeprom_queue_flush();
+
+    gem_store_begin();
+    eeprom_queue_flush();
+    check(gem_store_total() == 123400, "gems: torn layout 1 slot falls back one");
+}
+
+static void currentGems() {
+    eraseAll();
+    gem_store_begin();
+    gem_store_write_lifetime(98765);
+    gem_store_add_session(kGemSaveThreshold);   // flushed into the bitmap
+    eeprom_queue_flush();
+
+    gem_store_begin();
+    check(gem_store_total() == 98765 + kGemSaveThreshold, "gems: layout 2 base and bitmap read back");
+}
+
+// ---------------------------------------------------------------------------
+// Settings
+// ---------------------------------------------------------------------------
+
+static constexpr uint16_t ADDR_RECORD_A = 16;
+
+// A record as written by a given schema, byte for byte (see SettingsRecord).
+static void putRecord(uint8_t version, uint8_t sleepH, uint8_t sleepM, uint8_t wakeH,
+                      uint8_t wakeM, uint16_t duration, uint8_t duty) {
+    uint8_t r[24];
+    memset(r, 0, sizeof(r));
+    r[0] = version;
+    r[1] = 1;           // sequence
+    r[2] = sleepH;
+    r[3] = sleepM;
+    r[4] = wakeH;
+    r[5] = wakeM;
+    r[6] = (uint8_t)duration;
+    r[7] = (uint8_t)(duration >> 8);
+    r[8] = duty;
+    uint16_t crc = crc16(r, 22);
+    r[22] = (uint8_t)crc;
+    r[23] = (uint8_t)(crc >> 8);
+    for (uint8_t i = 0; i < sizeof(r); ++i) eeprom_queue_write(ADDR_RECORD_A + i, r[i]);
+    eeprom_queue_flush();
+}
+
+static void settingsV1() {
+    eraseAll();
+    putRecord(1, 22, 15, 6, 45, 210, 180);
+
+    Settings s;
+    s.adaptiveInterval = true;     // must come back off
+    s.intervals.count  = 3;
+    settings_load(s);
+    check(s.sched.sleepHour == 22 && s.sched.sleepMinute == 15 &&
+          s.sched.wakeHour == 6 && s.sched.wakeMinute == 45,
+          "settings: schema 1 schedule kept");
+    check(s.tapDuration == 210 && s.tapDuty == 180, "settings: schema 1 tap duration and duty kept");
+    check(!s.adaptiveInterval && s.intervals.count == 0,
+          "settings: schema 2 fields start off and empty");
+
+    // Commit and reload: the record is now schema 2.
+    settings_save(s);
+    settings_flush();
+    eeprom_queue_flush();
+    Settings again;
+    settings_load(again);
+    check(again.tapDuration == 210 && again.sched.sleepHour == 22,
+          "settings: rewritten record reads back");
+}
+
+static void settingsLegacy() {
+    eraseAll();
+    eeprom_queue_write(2, 23);      // sleep 23:30
+    eeprom_queue_write(3, 30);
+    eeprom_queue_write(4, 7);       // wake 07:05
+    eeprom_queue_write(5, 5);
+    eeprom_queue_put(6, (uint16_t)150);
+    eeprom_queue_write(8, 200);
+    eeprom_queue_flush();
+
+    Settings s;
+    settings_load(s);
+    check(s.sched.sleepHour == 23 && s.sched.wakeMinute == 5 &&
+          s.tapDuration == 150 && s.tapDuty == 200,
+          "settings: per-field layout loaded");
+
+    settings_flush();
+    eeprom_queue_flush();
+    check(eeprom_queue_read(ADDR_RECORD_A) == 2, "settings: per-field layout saved as a record");
+}
+
+static void settingsUnknown() {
+    eraseAll();
+    putRecord(3, 22, 15, 6, 45, 210, 180);
+
+    Settings s;
+    settings_load(s);
+    Settings defaults;
+    check(s.tapDuration == defaults.tapDuration && s.sched.sleepHour == defaults.sched.sleepHour,
+          "settings: unknown schema ignored");
+}
+
+int main() {
+    hal_host_setSerialOutput(nullptr);
+    hal_host_useVirtualTime(1736164800);
+    eeprom_queue_begin();
+
+    printf("persisted-format migrations\n");
+    legacyGems();
+    legacyGemsUnderBitmaps();
+    legacyGemsInterrupted();
+    legacyGemsTorn();
+    currentGems();
+    settingsV1();
+    settingsLegacy();
+    settingsUnknown();
+
+    printf("%s\n", s_failed ? "FAILED" : "all ok");
+    return s_failed ? 1 : 0;
+}
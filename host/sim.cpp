@@ -0,0 +1,370 @@
+// Purpose: accelerated-time simulation of the whole firmware. The unmodified
+// setup()/loop() run on the host HAL's virtual clock, which jumps from one
+// loop() pass straight to the next deadline the firmware announced through
+// hal_deadline() (or the next RTC minute, so sleep/wake edges are seen on
+// time). Weeks of operation take seconds.
+//
+// Usage: screen_tapper_sim [--days N] [--start "YYYY-MM-DD HH:MM"] [--seed N]
+//                          [--serial FILE] [--wear FILE] [--vcd FILE]
+//                          [--loop-us N] [--sd IMAGE]
+//   --days N      simulated time (default 14; fractions allowed)
+//   --start T     RTC time at power-on (default 2025-01-06 06:00)
+//   --seed N      random() seed (default 1, the board's seed after
+//                 randomSeed(analogRead(0)) is fixed by the host)
+//   --serial FILE keep the console output (default: discarded)
+//   --wear FILE   per-cell EEPROM counters as CSV: addr,programs,erases
+//   --vcd FILE    solenoid gate trace for GTKWave
+//   --loop-us N   how long one loop() pass takes (default 1000); passes
+//                 run on this grid, so a deadline is served at the first
+//                 pass after it, as on the board
+//   --sd IMAGE    card image with LOG.BIN for the event log (the sim is
+//                 built with SD_LOGGING; without --sd there is no card)
+//
+// Reports cycles, taps, gem totals, EEPROM wear by region, a schedule
+// check against an independent model of the sleep window, and a check of
+// every pulse width and pause in the gate trace. Exits 1 if the schedule,
+// the pulse timing or the gem accounting is wrong.
+//
+// SCREEN_TAPPER_EEPROM_IMAGE works as for screen_tapper_host, so a run can
+// start from (and leave behind) a given EEPROM.
+
+#include "hal_host.h"
+#include "config.h"
+#include "sd_logger.h"
+#include "tapper.h"
+#include "gem_store.h"
+#include "trace.h"
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+void setup();
+void loop();
+
+// Sketch state the checks read (screen_tapper.ino).
+extern SleepSchedule sched;
+extern ModeParams    activeMode;
+extern bool          deviceEnabled;
+extern bool          overrideClock;
+extern uint16_t      tapDuration;
+
+static constexpr uint64_t US_PER_S  = 1000000;
+static constexpr uint32_t SLACK_MS  = 1000;      // scheduling tolerance in the checks
+static constexpr uint32_t BREAK_MS  = 8UL * 60 * 1000;   // longest scheduleNextTap() break
+static constexpr uint32_t ENDURANCE = 100000;    // rated erase cycles per cell
+
+// EEPROM regions, from the layouts in gem_store.cpp and stats.cpp.
+struct Region {
+    const char* name;
+    uint16_t    first;
+    uint16_t    last;
+};
+static const Region kRegions[] = {
+    { "settings",    0,    250  },
+    { "gem records", 251,  255  },
+    { "bitmap A",    256,  319  },
+    { "bitmap B",    320,  383  },
+    { "base slots",  384,  3583 },
+    { "stats",       3584, 3943 },
+    { "reserved",    3944, 4095 },
+};
+
+// ---------------------------------------------------------------------------
+// Schedule model
+// ---------------------------------------------------------------------------
+
+// Awake window, written out independently of clock_isAwake().
+static bool modelAwake(uint16_t minuteOfDay) {
+    uint16_t wake = sched.wakeHour * 60u + sched.wakeMinute;
+    uint16_t bed  = sched.sleepHour * 60u + sched.sleepMinute;
+    if (wake == bed) return true;
+    if (wake < bed)  return minuteOfDay >= wake && minuteOfDay < bed;
+    return minuteOfDay >= wake || minuteOfDay < bed;
+}
+
+struct ScheduleStats {
+    uint32_t cycles          = 0;
+    uint32_t whileAsleep     = 0;   // violations
+    uint32_t gapsOutOfRange  = 0;   // violations
+    uint32_t lateAfterWake   = 0;   // violations
+    uint32_t gaps            = 0;
+    uint32_t gapMinMs        = UINT32_MAX;
+    uint32_t gapMaxMs        = 0;
+    uint64_t gapSumMs        = 0;
+    uint32_t wakes           = 0;
+    uint32_t firstAfterWakeMaxMs = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+static bool parseStart(const char* s, uint32_t& unixSec) {
+    tm t;
+    memset(&t, 0, sizeof(t));
+    if (sscanf(s, "%d-%d-%d %d:%d", &t.tm_year, &t.tm_mon, &t.tm_mday,
+               &t.tm_hour, &t.tm_min) != 5) return false;
+    t.tm_year -= 1900;
+    t.tm_mon  -= 1;
+    time_t v = timegm(&t);
+    if (v < 946684800 || v > 4102444799) return false;   // DS1307: 2000-2099
+    unixSec = (uint32_t)v;
+    return true;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s [--days N] [--start \"YYYY-MM-DD HH:MM\"] [--seed N]"
+                    " [--serial FILE] [--wear FILE] [--vcd FILE] [--loop-us N] [--sd IMAGE]\n",
+            argv0);
+}
+
+static void reportWear(double days, FILE* csv) {
+    printf("\nEEPROM wear (%.1f days)\n", days);
+    printf("  %-12s %11s %10s %10s %10s %10s\n",
+           "region", "addresses", "programs", "erases", "max erase", "at");
+    uint16_t worstAddr   = 0;
+    uint32_t worstErases = 0;
+    for (const Region& r : kRegions) {
+        uint64_t programs = 0, erases = 0;
+        uint32_t maxErase = 0;
+        uint16_t maxAt    = r.first;
+        for (uint32_t a = r.first; a <= r.last; ++a) {
+            programs += hal_host_eepromPrograms((uint16_t)a);
+            uint32_t e = hal_host_eepromErases((uint16_t)a);
+            erases += e;
+            if (e > maxErase) {
+                maxErase = e;
+                maxAt    = (uint16_t)a;
+            }
+        }
+        char range[16];
+        snprintf(range, sizeof(range), "%u-%u", r.first, r.last);
+        printf("  %-12s %11s %10llu %10llu %10u %10u\n", r.name, range,
+               (unsigned long long)programs, (unsigned long long)erases, maxErase, maxAt);
+        if (maxErase > worstErases) {
+            worstErases = maxErase;
+            worstAddr   = maxAt;
+        }
+    }
+    if (worstErases > 0 && days > 0) {
+        double perDay = worstErases / days;
+        printf("  worst cell %u: %.1f erases/day, %u-cycle endurance in %.1f years\n",
+               worstAddr, perDay, ENDURANCE, ENDURANCE / perDay / 365.0);
+    }
+
+    if (!csv) return;
+    fprintf(csv, "addr,programs,erases\n");
+    for (uint32_t a = 0; a < hal_eepromSize(); ++a) {
+        uint32_t p = hal_host_eepromPrograms((uint16_t)a);
+        if (p) fprintf(csv, "%u,%u,%u\n", a, p, hal_host_eepromErases((uint16_t)a));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Main
+// ---------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    double      days      = 14;
+    uint32_t    startUnix = 1736143200;   // 2025-01-06 06:00
+    unsigned long seed    = 1;
+    const char* serialPath = nullptr;
+    const char* wearPath   = nullptr;
+    const char* vcdPath    = nullptr;
+    const char* sdPath     = nullptr;
+    uint64_t    loopUs     = 1000;
+    for (int i = 1; i < argc; ++i) {
+        bool more = i + 1 < argc;
+        if (strcmp(argv[i], "--days") == 0 && more) {
+            days = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--start") == 0 && more) {
+            if (!parseStart(argv[++i], startUnix)) {
+                fprintf(stderr, "bad --start, want \"YYYY-MM-DD HH:MM\" in 2000-2099\n");
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--seed") == 0 && more) {
+            seed = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--serial") == 0 && more) {
+            serialPath = argv[++i];
+        } else if (strcmp(argv[i], "--wear") == 0 && more) {
+            wearPath = argv[++i];
+        } else if (strcmp(argv[i], "--vcd") == 0 && more) {
+            vcdPath = argv[++i];
+        } else if (strcmp(argv[i], "--loop-us") == 0 && more) {
+            loopUs = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--sd") == 0 && more) {
+            sdPath = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (days <= 0 || loopUs == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    FILE* serial = serialPath ? fopen(serialPath, "wb") : nullptr;
+    if (serialPath && !serial) {
+        perror(serialPath);
+        return 2;
+    }
+    hal_host_setSerialOutput(serial);
+    hal_host_useVirtualTime(startUnix);
+    setenv("SCREEN_TAPPER_SD_IMAGE", sdPath ? sdPath : "", 1);
+    randomSeed(seed);   // setup()'s randomSeed(analogRead(0)) sees 0 and keeps it
+
+    clock_t wallStart = clock();
+    setup();
+    uint32_t gemsAtStart = gem_store_total();
+
+    const uint64_t endUs = (uint64_t)(days * 86400.0 * US_PER_S);
+    ScheduleStats st;
+    bool     wasActive   = false;
+    bool     wasAwake    = false;
+    bool     waitingWake = true;    // boot counts as a wake
+    uint32_t wakeMs      = hal_millis();
+    uint32_t lastStartMs = 0;
+    bool     haveLast    = false;
+    uint64_t passes      = 0;
+
+    const uint32_t gapMin = activeMode.baseIntervalMs - activeMode.jitterRangeMs;
+    const uint32_t gapMax = activeMode.baseIntervalMs + activeMode.jitterRangeMs + BREAK_MS + SLACK_MS;
+
+    for (;;) {
+        loop();
+        passes++;
+
+        uint64_t nowUs   = hal_host_timeUs();
+        uint32_t nowMs   = hal_millis();
+        uint32_t rtcSec  = startUnix + (uint32_t)(nowUs / US_PER_S);
+        bool     awake   = overrideClock || modelAwake((uint16_t)(rtcSec % 86400 / 60));
+
+        if (awake && !wasAwake) {
+            waitingWake = true;
+            wakeMs      = nowMs;
+            haveLast    = false;   // intervals restart after sleep
+            st.wakes++;
+        }
+        wasAwake = awake;
+
+        bool active = tapper_isActive();
+        if (active && !wasActive) {
+            st.cycles++;
+            if (!awake) st.whileAsleep++;
+            if (waitingWake) {
+                uint32_t d = nowMs - wakeMs;
+                if (d > st.firstAfterWakeMaxMs) st.firstAfterWakeMaxMs = d;
+                if (d > gapMax) st.lateAfterWake++;
+                waitingWake = false;
+            } else if (haveLast) {
+                uint32_t gap = nowMs - lastStartMs;
+                st.gaps++;
+                st.gapSumMs += gap;
+                if (gap < st.gapMinMs) st.gapMinMs = gap;
+                if (gap > st.gapMaxMs) st.gapMaxMs = gap;
+                if (gap + SLACK_MS < gapMin || gap > gapMax) st.gapsOutOfRange++;
+            }
+            lastStartMs = nowMs;
+            haveLast    = true;
+        }
+        wasActive = active;
+
+        if (nowUs >= endUs) break;
+
+        // Next pass: the earliest announced deadline, the next RTC minute or
+        // the end of the run, rounded up to the pass grid.
+        uint64_t nextUs = nowUs + (60 - rtcSec % 60) * US_PER_S - nowUs % US_PER_S;
+        uint32_t atMs;
+        if (hal_host_takeDeadline(atMs)) {
+            int32_t dt = (int32_t)(atMs - nowMs);
+            uint64_t dlUs = dt > 0 ? (nowUs / 1000 + (uint64_t)dt) * 1000 : nowUs;
+            if (dlUs < nextUs) nextUs = dlUs;
+        }
+        if (nextUs > endUs) nextUs = endUs;
+        if (nextUs < nowUs + loopUs) nextUs = nowUs + loopUs;
+        nextUs = (nextUs + loopUs - 1) / loopUs * loopUs;
+        hal_host_setTimeUs(nextUs);
+    }
+    double wallSec = (double)(clock() - wallStart) / CLOCKS_PER_SEC;
+    if (serial) fclose(serial);
+
+    // --- Report ---
+    uint32_t n           = st.cycles;
+    uint32_t gems        = gem_store_total() - gemsAtStart;
+    uint32_t expectGems  = 5 * n + 2 * (n / 6);   // screen_tapper.ino's earning rule
+    bool     gemsOk      = gems == expectGems;
+    bool     scheduleOk  = st.whileAsleep == 0 && st.gapsOutOfRange == 0 && st.lateAfterWake == 0;
+
+    char startText[32];
+    time_t startT = startUnix;
+    strftime(startText, sizeof(startText), "%Y-%m-%d %H:%M", gmtime(&startT));
+    printf("simulated %.1f days from %s (seed %lu): %llu loop passes in %.2f s\n",
+           days, startText, seed, (unsigned long long)passes, wallSec);
+    printf("  sleep %02u:%02u  wake %02u:%02u  interval %lu +/- %lu ms  device %s\n",
+           sched.sleepHour, sched.sleepMinute, sched.wakeHour, sched.wakeMinute,
+           (unsigned long)activeMode.baseIntervalMs, (unsigned long)activeMode.jitterRangeMs,
+           deviceEnabled ? "on" : "off");
+
+    printf("\nCycles\n");
+    printf("  started %u, completed %lu, per day %.1f\n", n,
+           (unsigned long)tapper_cyclesCompleted(), n / days);
+    printf("  taps: ad %u, float %u\n",
+           hal_host_pwmPulses(AD_GEMS_MOSFET_GATE_PIN), hal_host_pwmPulses(FLOAT_GEMS_MOSFET_GATE_PIN));
+    printf("  gems: +%u (expected +%u), lifetime %lu  %s\n", gems, expectGems,
+           (unsigned long)gem_store_total(), gemsOk ? "ok" : "MISMATCH");
+
+    printf("\nSchedule\n");
+    printf("  wakes %u, first cycle after wake <= %.1f s\n", st.wakes, st.firstAfterWakeMaxMs / 1000.0);
+    if (st.gaps) {
+        printf("  gaps: %u, min %.1f s, mean %.1f s, max %.1f s (allowed %.1f-%.1f s)\n",
+               st.gaps, st.gapMinMs / 1000.0, st.gapSumMs / 1000.0 / st.gaps,
+               st.gapMaxMs / 1000.0, gapMin / 1000.0, gapMax / 1000.0);
+    }
+    printf("  cycles while asleep %u, gaps out of range %u, late after wake %u  %s\n",
+           st.whileAsleep, st.gapsOutOfRange, st.lateAfterWake, scheduleOk ? "ok" : "FAIL");
+
+    const TracePin gates[] = {
+        { AD_GEMS_MOSFET_GATE_PIN,    "ad_gate" },
+        { FLOAT_GEMS_MOSFET_GATE_PIN, "float_gate" },
+    };
+    PulseSpec spec;
+    spec.widthUs     = tapDuration * 1000u;
+    spec.pauseMaxUs  = activeMode.pauseBetweenTapsMs * 1000u;
+    spec.pauseMinUs  = (activeMode.pauseBetweenTapsMs < kTapPauseMinMs
+                        ? activeMode.pauseBetweenTapsMs : kTapPauseMinMs) * 1000u;
+    spec.toleranceUs = (uint32_t)loopUs + 1000;   // one pass late, plus millis() rounding
+    spec.cycleGapUs  = gapMin / 2 * 1000u;
+    PulseReport pulses = trace_checkPulses(gates, 2, spec);
+    printf("\nPulse timing\n");
+    trace_printReport(stdout, pulses, spec);
+
+    if (vcdPath) {
+        FILE* vcd = fopen(vcdPath, "w");
+        if (vcd) {
+            trace_writeVcd(vcd, gates, 2);
+            fclose(vcd);
+        } else {
+            perror(vcdPath);
+        }
+    }
+
+    if (sdPath) {
+        printf("\nSD log (%s)\n", sdPath);
+        if (sd_logger_active()) {
+            printf("  region %lu blocks, records dropped %u\n",
+                   (unsigned long)sd_logger_regionBlocks(), sd_logger_dropped());
+        } else {
+            printf("  no log region found\n");
+        }
+    }
+
+    FILE* wear = wearPath ? fopen(wearPath, "w") : nullptr;
+    if (wearPath && !wear) perror(wearPath);
+    reportWear(days, wear);
+    if (wear) fclose(wear);
+
+    return scheduleOk && gemsOk && pulses.ok() ? 0 : 1;
+}
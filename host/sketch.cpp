@@ -0,0 +1,5 @@
+// Purpose: compile the sketch file as an ordinary C++ translation unit for
+// the host build. The Arduino builder adds the Arduino.h include itself.
+
+#include <Arduino.h>
+#include "screen_tapper.ino"
@@ -0,0 +1,158 @@
+// Purpose: VCD export and pulse-timing checks over the host HAL's gate trace.
+
+#include "trace.h"
+#include "hal_host.h"
+#include <stdlib.h>
+#include <time.h>
+
+static constexpr uint8_t MAX_PINS = 8;
+
+static int indexOf(const TracePin* pins, uint8_t count, uint8_t pin) {
+    for (uint8_t i = 0; i < count; ++i) {
+        if (pins[i].pin == pin) return i;
+    }
+    return -1;
+}
+
+// ---------------------------------------------------------------------------
+// VCD export
+// ---------------------------------------------------------------------------
+
+// VCD identifiers: two printable characters per pin, gate then duty.
+static char gateId(uint8_t i) { return (char)('!' + 2 * i); }
+static char dutyId(uint8_t i) { return (char)('!' + 2 * i + 1); }
+
+static void writeDuty(FILE* f, uint8_t i, uint8_t duty) {
+    fputc('b', f);
+    for (int bit = 7; bit >= 0; --bit) fputc((duty >> bit) & 1 ? '1' : '0', f);
+    fprintf(f, " %c\n", dutyId(i));
+}
+
+void trace_writeVcd(FILE* f, const TracePin* pins, uint8_t count) {
+    if (count > MAX_PINS) count = MAX_PINS;
+
+    time_t now = time(nullptr);
+    char date[32];
+    strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", localtime(&now));
+    fprintf(f, "$date %s $end\n", date);
+    fprintf(f, "$version screen_tapper host trace $end\n");
+    fprintf(f, "$timescale 1us $end\n");
+    fprintf(f, "$scope module screen_tapper $end\n");
+    for (uint8_t i = 0; i < count; ++i) {
+        fprintf(f, "$var wire 1 %c %s $end\n", gateId(i), pins[i].name);
+        fprintf(f, "$var wire 8 %c %s_duty $end\n", dutyId(i), pins[i].name);
+    }
+    fprintf(f, "$upscope $end\n$enddefinitions $end\n");
+
+    fprintf(f, "#0\n$dumpvars\n");
+    for (uint8_t i = 0; i < count; ++i) {
+        fprintf(f, "0%c\n", gateId(i));
+        writeDuty(f, i, 0);
+    }
+    fprintf(f, "$end\n");
+
+    bool     on[MAX_PINS] = {};
+    uint64_t lastUs       = 0;
+    for (size_t n = 0; n < hal_host_traceCount(); ++n) {
+        const TraceEdge& e = hal_host_traceEdge(n);
+        int i = indexOf(pins, count, e.pin);
+        if (i < 0) continue;
+        if (e.us != lastUs) {
+            fprintf(f, "#%llu\n", (unsigned long long)e.us);
+            lastUs = e.us;
+        }
+        if (on[i] != (e.duty != 0)) {
+            on[i] = e.duty != 0;
+            fprintf(f, "%c%c\n", on[i] ? '1' : '0', gateId((uint8_t)i));
+        }
+        writeDuty(f, (uint8_t)i, e.duty);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Pulse checks
+// ---------------------------------------------------------------------------
+
+static void note(PulseReport& r, uint64_t us) {
+    if (r.firstFailUs == 0) r.firstFailUs = us;
+}
+
+static int32_t deviation(uint64_t actualUs, uint32_t expectedUs) {
+    return (int32_t)((int64_t)actualUs - (int64_t)expectedUs);
+}
+
+// Distance outside [minUs, maxUs]: negative below, positive above, else 0.
+static int32_t outside(uint64_t actualUs, uint32_t minUs, uint32_t maxUs) {
+    if (actualUs < minUs) return deviation(actualUs, minUs);
+    if (actualUs > maxUs) return deviation(actualUs, maxUs);
+    return 0;
+}
+
+PulseReport trace_checkPulses(const TracePin* pins, uint8_t count, const PulseSpec& spec) {
+    PulseReport r;
+    bool     on[MAX_PINS] = {};
+    uint64_t onSince      = 0;
+    uint64_t lastOff      = 0;
+    bool     haveOff      = false;
+    uint8_t  active       = 0;    // gates currently on
+
+    for (size_t n = 0; n < hal_host_traceCount(); ++n) {
+        const TraceEdge& e = hal_host_traceEdge(n);
+        int i = indexOf(pins, count, e.pin);
+        if (i < 0 || i >= MAX_PINS) continue;
+        bool level = e.duty != 0;
+        if (level == on[i]) continue;            // duty change within a pulse
+        on[i] = level;
+
+        if (level) {
+            if (active > 0) {
+                r.overlaps++;
+                note(r, e.us);
+            } else if (haveOff && e.us - lastOff <= spec.cycleGapUs) {
+                uint64_t pause = e.us - lastOff;
+                int32_t  d     = outside(pause, spec.pauseMinUs, spec.pauseMaxUs);
+                r.pauses++;
+                if (pause < r.shortestPauseUs) r.shortestPauseUs = (uint32_t)pause;
+                if (pause > r.longestPauseUs)  r.longestPauseUs  = (uint32_t)pause;
+                if ((uint32_t)abs(d) > (uint32_t)abs(r.worstPauseUs)) r.worstPauseUs = d;
+                if ((uint32_t)abs(d) > spec.toleranceUs) {
+                    r.badPauses++;
+                    note(r, e.us);
+                }
+            }
+            active++;
+            onSince = e.us;
+        } else {
+            active--;
+            if (active == 0) {
+                int32_t d = deviation(e.us - onSince, spec.widthUs);
+                r.pulses++;
+                if ((uint32_t)abs(d) > (uint32_t)abs(r.worstWidthUs)) r.worstWidthUs = d;
+                if ((uint32_t)abs(d) > spec.toleranceUs) {
+                    r.badWidths++;
+                    note(r, e.us);
+                }
+                lastOff = e.us;
+                haveOff = true;
+            }
+        }
+    }
+    return r;
+}
+
+void trace_printReport(FILE* f, const PulseReport& r, const PulseSpec& spec) {
+    fprintf(f, "  pulses %u (%.1f ms, worst %+.3f ms), tolerance %.1f ms\n",
+            r.pulses, spec.widthUs / 1000.0, r.worstWidthUs / 1000.0,
+            spec.toleranceUs / 1000.0);
+    if (r.pauses) {
+        fprintf(f, "  pauses %u (%.1f-%.1f ms allowed, seen %.1f-%.1f ms, worst %+.3f ms)\n",
+                r.pauses, spec.pauseMinUs / 1000.0, spec.pauseMaxUs / 1000.0,
+                r.shortestPauseUs / 1000.0, r.longestPauseUs / 1000.0,
+                r.worstPauseUs / 1000.0);
+    }
+    fprintf(f, "  bad widths %u, bad pauses %u, overlaps %u  %s\n",
+            r.badWidths, r.badPauses, r.overlaps, r.ok() ? "ok" : "FAIL");
+    if (!r.ok()) {
+        fprintf(f, "  first violation at %.3f s\n", r.firstFailUs / 1e6);
+    }
+}
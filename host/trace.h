@@ -0,0 +1,51 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+
+// Checks and export for the host HAL's gate trace (hal_host_traceEdge()).
+// Host only.
+
+// A traced pin and the name it gets in the VCD.
+struct TracePin {
+    uint8_t     pin;
+    const char* name;
+};
+
+// Writes the whole trace as a VCD file (1 us timescale) for GTKWave. Each
+// pin becomes a 1-bit "<name>" gate wire and an 8-bit "<name>_duty" value.
+// Edges on other pins are left out.
+void trace_writeVcd(FILE* f, const TracePin* pins, uint8_t count);
+
+// What the tapper should produce: every pulse tapDuration long and every
+// pause between pulses within [pauseMinUs, pauseMaxUs] (the thermal budget
+// moves it between kTapPauseMinMs and pauseBetweenTapsMs), within the
+// tolerance. A gap longer than cycleGapUs separates two cycles and is not
+// checked.
+struct PulseSpec {
+    uint32_t widthUs;
+    uint32_t pauseMinUs;
+    uint32_t pauseMaxUs;
+    uint32_t toleranceUs;
+    uint32_t cycleGapUs;
+};
+
+struct PulseReport {
+    uint32_t pulses       = 0;
+    uint32_t pauses       = 0;
+    uint32_t badWidths    = 0;
+    uint32_t badPauses    = 0;
+    uint32_t overlaps     = 0;    // a gate switched on while another was on
+    int32_t  worstWidthUs = 0;    // largest deviation from widthUs, signed
+    int32_t  worstPauseUs = 0;    // largest distance outside the pause range, signed
+    uint32_t shortestPauseUs = UINT32_MAX;
+    uint32_t longestPauseUs  = 0;
+    uint64_t firstFailUs  = 0;    // trace time of the first violation
+    bool ok() const { return badWidths == 0 && badPauses == 0 && overlaps == 0; }
+};
+
+// Walks the trace for the given gate pins and checks every pulse and pause
+// against spec. A pulse still on at the end of the trace is not counted.
+PulseReport trace_checkPulses(const TracePin* pins, uint8_t count, const PulseSpec& spec);
+
+// One-line summary, e.g. for a simulator report.
+void trace_printReport(FILE* f, const PulseReport& r, const PulseSpec& spec);
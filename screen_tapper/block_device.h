@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+
+// 512-byte block storage used by the SD logger. Writes are split so that no
+// call waits on the medium: writeBegin / writeData slices / writeEnd, then
+// poll until the device has finished programming.
+//
+// block_device_sd.cpp drives an SD card over SPI on the Arduino;
+// block_device_file.cpp backs the same API with an image file on a host.
+
+constexpr uint16_t BLOCK_SIZE = 512;
+
+enum class BlockStatus : uint8_t { Ready, Busy, Error };
+
+// Initialize the device. Blocking; call once at boot.
+bool     blockdev_begin();
+
+// Read one block. Blocking; intended for boot-time scans only.
+bool     blockdev_read(uint32_t block, uint8_t* buf);
+
+// Start a single-block write. Only valid while blockdev_poll() is Ready.
+bool     blockdev_writeBegin(uint32_t block);
+
+// Send the next slice of the block being written.
+bool     blockdev_writeData(const uint8_t* data, uint16_t len);
+
+// Finish the block once exactly BLOCK_SIZE bytes have been sent. The device
+// may keep programming afterwards; blockdev_poll() reports Busy until done.
+bool     blockdev_writeEnd();
+
+// Non-blocking completion check for the last write.
+BlockStatus blockdev_poll();
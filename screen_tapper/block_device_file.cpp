@@ -0,0 +1,90 @@
+// Purpose: host block device backed by an image file, so the SD logger can
+// be built and exercised on a PC. Not compiled into the sketch.
+//
+// SCREEN_TAPPER_SD_IMAGE     image path (default "sd.img"; created if missing;
+//                              set but empty: no card)
+// SCREEN_TAPPER_SD_BUSY_POLLS  blockdev_poll() calls that report Busy after
+//                              each write, to mimic card programming time
+
+#ifndef ARDUINO
+
+#include "block_device.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static FILE*    s_file      = nullptr;
+static bool     s_writing   = false;
+static uint32_t s_block     = 0;
+static uint16_t s_sent      = 0;
+static uint32_t s_busyPolls = 0;
+static uint32_t s_busyLeft  = 0;
+static uint8_t  s_pending[BLOCK_SIZE];
+
+bool blockdev_begin() {
+    if (s_file) fclose(s_file);
+
+    const char* path = getenv("SCREEN_TAPPER_SD_IMAGE");
+    if (!path) path = "sd.img";
+    if (!*path) {
+        s_file = nullptr;
+        return false;
+    }
+    s_file = fopen(path, "r+b");
+    if (!s_file) s_file = fopen(path, "w+b");
+
+    const char* polls = getenv("SCREEN_TAPPER_SD_BUSY_POLLS");
+    s_busyPolls = polls ? (uint32_t)strtoul(polls, nullptr, 10) : 0;
+    s_busyLeft  = 0;
+    s_writing   = false;
+    return s_file != nullptr;
+}
+
+bool blockdev_read(uint32_t block, uint8_t* buf) {
+    if (!s_file || s_writing || s_busyLeft) return false;
+    if (fseek(s_file, (long)block * BLOCK_SIZE, SEEK_SET) != 0) return false;
+
+    // Blocks past the end of the image read as erased.
+    size_t got = fread(buf, 1, BLOCK_SIZE, s_file);
+    for (size_t i = got; i < BLOCK_SIZE; ++i) buf[i] = 0xFF;
+    return true;
+}
+
+bool blockdev_writeBegin(uint32_t block) {
+    if (!s_file || s_writing || s_busyLeft) return false;
+    s_writing = true;
+    s_block   = block;
+    s_sent    = 0;
+    return true;
+}
+
+bool blockdev_writeData(const uint8_t* data, uint16_t len) {
+    if (!s_writing || s_sent + len > BLOCK_SIZE) return false;
+    for (uint16_t i = 0; i < len; ++i) s_pending[s_sent + i] = data[i];
+    s_sent += len;
+    return true;
+}
+
+bool blockdev_writeEnd() {
+    if (!s_writing || s_sent != BLOCK_SIZE) return false;
+    s_writing = false;
+
+    // The block lands on "disk" only once complete, like a card that
+    // discards a partial transfer.
+    if (fseek(s_file, (long)s_block * BLOCK_SIZE, SEEK_SET) != 0) return false;
+    if (fwrite(s_pending, 1, BLOCK_SIZE, s_file) != BLOCK_SIZE) return false;
+    fflush(s_file);
+    s_busyLeft = s_busyPolls;
+    return true;
+}
+
+BlockStatus blockdev_poll() {
+    if (!s_file) return BlockStatus::Error;
+    if (s_writing) return BlockStatus::Busy;
+    if (s_busyLeft) {
+        s_busyLeft--;
+        return BlockStatus::Busy;
+    }
+    return BlockStatus::Ready;
+}
+
+#endif
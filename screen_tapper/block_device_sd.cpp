@@ -0,0 +1,242 @@
+// Purpose: SD card block device over the hardware SPI bus (SPI mode, single-
+// block reads and writes only).
+
+#include "config.h"
+
+#if defined(ARDUINO) && defined(SD_LOGGING)
+
+#include "block_device.h"
+#include "watchdog.h"
+#include <Arduino.h>
+#include <SPI.h>
+
+// MOSI (51) doubles as the LCD's bit-banged data line, and u8g2 cannot drive
+// it while the SPI peripheral owns the pin. The bus is therefore enabled only
+// for the duration of each call and released before returning. The card's
+// chip select may stay asserted between slices of a block: u8g2 never clocks
+// SCK (52), so the card sees nothing while the LCD is drawn.
+
+static constexpr uint8_t  CMD0   = 0;    // GO_IDLE_STATE
+static constexpr uint8_t  CMD8   = 8;    // SEND_IF_COND
+static constexpr uint8_t  CMD17  = 17;   // READ_SINGLE_BLOCK
+static constexpr uint8_t  CMD24  = 24;   // WRITE_BLOCK
+static constexpr uint8_t  CMD55  = 55;   // APP_CMD
+static constexpr uint8_t  CMD58  = 58;   // READ_OCR
+static constexpr uint8_t  ACMD41 = 41;   // SD_SEND_OP_COND
+
+static constexpr uint8_t  R1_IDLE          = 0x01;
+static constexpr uint8_t  TOKEN_START      = 0xFE;
+static constexpr uint8_t  DATA_ACCEPTED    = 0x05;
+static constexpr uint16_t INIT_TIMEOUT_MS  = 1000;   // per step; the watchdog is fed while waiting
+static constexpr uint16_t READ_TIMEOUT_MS  = 300;
+static constexpr uint16_t WRITE_TIMEOUT_MS = 600;
+
+static const SPISettings kInitSpi(250000,  MSBFIRST, SPI_MODE0);
+static const SPISettings kFastSpi(4000000, MSBFIRST, SPI_MODE0);
+
+static bool     s_ready        = false;
+static bool     s_blockAddr    = false;   // SDHC/SDXC: block, not byte, addressing
+static bool     s_writing      = false;   // CS held low across write slices
+static bool     s_programming  = false;
+static uint16_t s_sent         = 0;
+static uint32_t s_programStart = 0;
+
+// ---------------------------------------------------------------------------
+// Bus helpers
+// ---------------------------------------------------------------------------
+
+static void busAcquire(const SPISettings& cfg) {
+    SPI.begin();
+    SPI.beginTransaction(cfg);
+}
+
+static void busRelease() {
+    SPI.endTransaction();
+    SPI.end();  // hands MOSI back to the LCD
+}
+
+static void select()   { digitalWrite(SD_CS_PIN, LOW); }
+static void deselect() { digitalWrite(SD_CS_PIN, HIGH); SPI.transfer(0xFF); }
+
+static uint8_t command(uint8_t cmd, uint32_t arg) {
+    SPI.transfer(0x40 | cmd);
+    SPI.transfer((uint8_t)(arg >> 24));
+    SPI.transfer((uint8_t)(arg >> 16));
+    SPI.transfer((uint8_t)(arg >> 8));
+    SPI.transfer((uint8_t)arg);
+    // Only CMD0 and CMD8 are checked for CRC in SPI mode.
+    SPI.transfer(cmd == CMD0 ? 0x95 : cmd == CMD8 ? 0x87 : 0x01);
+
+    uint8_t r1 = 0xFF;
+    for (uint8_t i = 0; i < 10 && (r1 & 0x80); ++i) r1 = SPI.transfer(0xFF);
+    return r1;
+}
+
+static uint8_t appCommand(uint8_t cmd, uint32_t arg) {
+    command(CMD55, 0);
+    return command(cmd, arg);
+}
+
+static bool waitNotBusy(uint16_t timeoutMs) {
+    uint32_t start = millis();
+    while (SPI.transfer(0xFF) != 0xFF) {
+        if (millis() - start >= timeoutMs) return false;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+bool blockdev_begin() {
+    s_ready = false;
+    pinMode(SD_CS_PIN, OUTPUT);
+    digitalWrite(SD_CS_PIN, HIGH);
+
+    busAcquire(kInitSpi);
+    for (uint8_t i = 0; i < 10; ++i) SPI.transfer(0xFF);  // >= 74 wake-up clocks
+
+    bool ok = false;
+    select();
+    uint32_t start = millis();
+    while (command(CMD0, 0) != R1_IDLE) {
+        if (millis() - start >= INIT_TIMEOUT_MS) goto done;
+        watchdog_feed();   // blockdev_begin() runs from loop(), after watchdog_begin()
+    }
+
+    {
+        bool v2 = false;
+        if (command(CMD8, 0x1AA) == R1_IDLE) {
+            uint8_t r7[4];
+            for (uint8_t i = 0; i < 4; ++i) r7[i] = SPI.transfer(0xFF);
+            if (r7[3] != 0xAA) goto done;
+            v2 = true;
+        }
+
+        start = millis();
+        while (appCommand(ACMD41, v2 ? 0x40000000UL : 0) != 0) {
+            if (millis() - start >= INIT_TIMEOUT_MS) goto done;
+            watchdog_feed();
+        }
+
+        s_blockAddr = false;
+        if (v2) {
+            if (command(CMD58, 0) != 0) goto done;
+            uint8_t ocr = SPI.transfer(0xFF);
+            for (uint8_t i = 0; i < 3; ++i) SPI.transfer(0xFF);
+            s_blockAddr = (ocr & 0x40) != 0;  // CCS
+        }
+        ok = true;
+    }
+
+done:
+    deselect();
+    busRelease();
+    s_ready       = ok;
+    s_writing     = false;
+    s_programming = false;
+    return ok;
+}
+
+bool blockdev_read(uint32_t block, uint8_t* buf) {
+    if (!s_ready || s_writing || s_programming) return false;
+
+    busAcquire(kFastSpi);
+    select();
+    bool ok = false;
+    if (command(CMD17, s_blockAddr ? block : block * BLOCK_SIZE) == 0) {
+        uint32_t start = millis();
+        uint8_t token;
+        while ((token = SPI.transfer(0xFF)) == 0xFF) {
+            if (millis() - start >= READ_TIMEOUT_MS) break;
+            watchdog_feed();
+        }
+        if (token == TOKEN_START) {
+            for (uint16_t i = 0; i < BLOCK_SIZE; ++i) buf[i] = SPI.transfer(0xFF);
+            SPI.transfer(0xFF);  // CRC, unchecked
+            SPI.transfer(0xFF);
+            ok = true;
+        }
+    }
+    deselect();
+    busRelease();
+    return ok;
+}
+
+bool blockdev_writeBegin(uint32_t block) {
+    if (!s_ready || s_writing || s_programming) return false;
+
+    busAcquire(kFastSpi);
+    select();
+    bool ok = waitNotBusy(WRITE_TIMEOUT_MS) &&
+              command(CMD24, s_blockAddr ? block : block * BLOCK_SIZE) == 0;
+    if (ok) {
+        SPI.transfer(0xFF);
+        SPI.transfer(TOKEN_START);
+        s_writing = true;
+        s_sent    = 0;
+    } else {
+        deselect();
+    }
+    busRelease();
+    return ok;
+}
+
+bool blockdev_writeData(const uint8_t* data, uint16_t len) {
+    if (!s_writing || s_sent + len > BLOCK_SIZE) return false;
+
+    busAcquire(kFastSpi);
+    for (uint16_t i = 0; i < len; ++i) SPI.transfer(data[i]);
+    busRelease();
+    s_sent += len;
+    return true;
+}
+
+bool blockdev_writeEnd() {
+    if (!s_writing || s_sent != BLOCK_SIZE) return false;
+
+    busAcquire(kFastSpi);
+    SPI.transfer(0xFF);  // CRC, ignored by the card in SPI mode
+    SPI.transfer(0xFF);
+    uint8_t response = SPI.transfer(0xFF) & 0x1F;
+    busRelease();
+
+    s_writing = false;
+    if (response != DATA_ACCEPTED) {
+        busAcquire(kFastSpi);
+        deselect();
+        busRelease();
+        return false;
+    }
+    // CS stays low so blockdev_poll() can watch the busy signal.
+    s_programming  = true;
+    s_programStart = millis();
+    return true;
+}
+
+BlockStatus blockdev_poll() {
+    if (!s_ready) return BlockStatus::Error;
+    if (s_writing) return BlockStatus::Busy;
+    if (!s_programming) return BlockStatus::Ready;
+
+    busAcquire(kFastSpi);
+    bool busy = SPI.transfer(0xFF) != 0xFF;
+    if (!busy) deselect();
+    busRelease();
+
+    if (!busy) {
+        s_programming = false;
+        return BlockStatus::Ready;
+    }
+    if (millis() - s_programStart >= WRITE_TIMEOUT_MS) {
+        busAcquire(kFastSpi);
+        deselect();
+        busRelease();
+        s_programming = false;
+        return BlockStatus::Error;
+    }
+    return BlockStatus::Busy;
+}
+
+#endif
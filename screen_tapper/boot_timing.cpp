@@ -0,0 +1,84 @@
+#include "boot_timing.h"
+#include "console.h"
+#include "hal.h"
+#include <Arduino.h>
+
+static constexpr uint8_t PHASES = (uint8_t)BootPhase::Count;
+
+static const char NAME_SAFE[]     PROGMEM = "safe";
+static const char NAME_CONSOLE[]  PROGMEM = "console";
+static const char NAME_CLOCK[]    PROGMEM = "clock";
+static const char NAME_SETTINGS[] PROGMEM = "settings";
+static const char NAME_INPUTS[]   PROGMEM = "inputs";
+static const char NAME_GEMS[]     PROGMEM = "gems";
+static const char NAME_POWER[]    PROGMEM = "power";
+static const char NAME_SD[]       PROGMEM = "sd";
+static const char NAME_SCHEDULE[] PROGMEM = "schedule";
+static const char NAME_INPUT[]    PROGMEM = "input";
+static const char NAME_LCD[]      PROGMEM = "lcd";
+static const char NAME_FRAME[]    PROGMEM = "frame";
+
+static const char* const kNames[] PROGMEM = {
+    NAME_SAFE, NAME_CONSOLE, NAME_CLOCK, NAME_SETTINGS, NAME_INPUTS, NAME_GEMS,
+    NAME_POWER, NAME_SCHEDULE, NAME_INPUT, NAME_LCD, NAME_FRAME, NAME_SD,
+};
+static_assert(sizeof(kNames) / sizeof(kNames[0]) == PHASES, "one name per BootPhase");
+
+static uint32_t s_startUs = 0;         // micros() on entry to setup()
+static uint32_t s_at[PHASES];
+
+// Dump progress: one line per boot_timing_service() call. Line 0 is the
+// start time, line i the phase i - 1.
+static bool    s_dumping  = false;
+static uint8_t s_dumpLine = 0;
+
+void boot_timing_begin() {
+    s_startUs = hal_micros();
+}
+
+void boot_timing_mark(BootPhase phase) {
+    uint32_t& at = s_at[(uint8_t)phase];
+    if (at == 0) at = hal_micros();
+}
+
+uint32_t boot_timing_at(BootPhase phase) {
+    return s_at[(uint8_t)phase];
+}
+
+void boot_timing_requestDump() {
+    s_dumping  = true;
+    s_dumpLine = 0;
+}
+
+// Lines:  boot start @<us>
+//         boot <phase> +<us> @<us>      duration, then end time
+// Phases not reached yet are skipped.
+void boot_timing_service() {
+    if (!s_dumping || !console_txIdle()) return;
+
+    if (s_dumpLine == 0) {
+        console_printf(PSTR("boot start @%lu"), (unsigned long)s_startUs);
+        s_dumpLine = 1;
+        return;
+    }
+
+    uint8_t phase = (uint8_t)(s_dumpLine - 1);
+    while (phase < PHASES && s_at[phase] == 0) phase++;
+    if (phase >= PHASES) {
+        s_dumping = false;
+        return;
+    }
+
+    // Duration from the end of the last phase reached before this one.
+    uint32_t prev = s_startUs;
+    for (uint8_t i = 0; i < phase; ++i) {
+        if (s_at[i]) prev = s_at[i];
+    }
+
+    char name[12];
+    strcpy_P(name, (const char*)pgm_read_ptr(&kNames[phase]));
+    console_printf(PSTR("boot %s +%lu @%lu"), name, (unsigned long)(s_at[phase] - prev),
+                   (unsigned long)s_at[phase]);
+    s_dumpLine = (uint8_t)(phase + 2);
+    if (s_dumpLine > PHASES) s_dumping = false;
+}
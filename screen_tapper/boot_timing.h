@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+
+// Boot phase timing. setup() marks the end of each init phase, loop() and
+// the display mark the deferred ones, and the breakdown goes out on the
+// serial console once the first frame is on screen ("boot" repeats it).
+// Times are micros() since the core started the timer, so the bootloader's
+// wait before setup() is not included.
+
+enum class BootPhase : uint8_t {
+    Safe,          // solenoid gates driven low
+    Console,
+    Clock,         // RTC probe over I2C
+    Settings,      // EEPROM queue + settings record
+    Inputs,        // encoder, button, menu
+    GemStore,      // base slot + bitmap scan
+    Power,         // power-fail comparator
+    Schedule,      // next-tap deadline from RTC NVRAM, reset record
+    FirstInput,    // first loop(): input polled and handled
+    LcdInit,       // deferred LCD controller init
+    FirstFrame,    // first full frame sent
+    SdLogger,      // card probe and LOG.BIN lookup, after the first frame
+                   // (SD_LOGGING only; the rest of the scan runs in slices)
+    Count
+};
+
+// Call first thing in setup().
+void boot_timing_begin();
+
+// Record that `phase` has just finished. Only the first mark counts.
+void boot_timing_mark(BootPhase phase);
+
+// micros() at the end of `phase`; 0 if not reached yet.
+uint32_t boot_timing_at(BootPhase phase);
+
+// Start printing the breakdown through the console.
+void boot_timing_requestDump();
+
+// Emit pending dump lines while the console is idle. Call once per loop().
+void boot_timing_service();
@@ -1,30 +1,43 @@
 #include "button.h"
-#include <Arduino.h>
+#include "hal.h"
+#include "mono_time.h"
 
-static constexpr unsigned long DEBOUNCE_MS = 40;
+static constexpr uint32_t DEBOUNCE_MS = 40;
 
-static uint8_t       s_pin           = 0xFF;
-static uint8_t       s_lastStable    = HIGH;
-static unsigned long s_lastChangeMs  = 0;
+static uint8_t  s_pin        = 0xFF;
+static bool     s_lastStable = true;    // pulled up: high = released
+static Deadline s_settled;              // next change accepted from here
+static uint32_t s_pressUs    = 0;
+static uint32_t s_lastPollUs = 0;
 
 void button_begin(uint8_t pin) {
-    s_pin          = pin;
-    s_lastStable   = HIGH;
-    s_lastChangeMs = millis();
-    pinMode(s_pin, INPUT_PULLUP);
+    s_pin        = pin;
+    s_lastStable = true;
+    s_settled    = deadline_in(mono_nowMs(), DEBOUNCE_MS);
+    s_lastPollUs = hal_micros();
+    hal_pinInputPullup(s_pin);
 }
 
 bool button_poll() {
     if (s_pin == 0xFF) return false;
 
-    uint8_t       current = digitalRead(s_pin);
-    unsigned long now     = millis();
+    bool     current = hal_pinRead(s_pin);
+    MonoMs   now     = mono_nowMs();
+    uint32_t prevUs  = s_lastPollUs;
+    s_lastPollUs     = hal_micros();
 
-    if (current != s_lastStable && (now - s_lastChangeMs) >= DEBOUNCE_MS) {
-        s_lastChangeMs = now;
-        s_lastStable   = current;
-        // Report true only on the press edge (HIGH → LOW)
-        if (current == LOW) return true;
+    if (current != s_lastStable && deadline_reached(s_settled, now)) {
+        s_settled    = deadline_in(now, DEBOUNCE_MS);
+        s_lastStable = current;
+        // Report true only on the press edge (high → low)
+        if (!current) {
+            s_pressUs = prevUs;
+            return true;
+        }
     }
     return false;
 }
+
+uint32_t button_pressUs() {
+    return s_pressUs;
+}
@@ -7,3 +7,7 @@ void button_begin(uint8_t pin);
 // Poll the button. Returns true exactly once per press (falling edge).
 // Call once per loop().
 bool button_poll();
+
+// hal_micros() of the poll before the one that saw the last press: the
+// earliest the press can have happened.
+uint32_t button_pressUs();
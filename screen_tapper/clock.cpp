@@ -1,14 +1,34 @@
 #include "clock.h"
-#include <Arduino.h>
-#include <Wire.h>
-#include <RTClib.h>
+#include "hal.h"
 
-static RTC_DS1307 g_rtc;
 static bool s_rtcAvailable = false;
+static uint16_t s_readFailures = 0;
+static bool s_lastAwake = true;    // clock_isAwake() answer from the last good read
+
+// A failed I2C read comes back as 0xFF bytes, which decode to impossible
+// fields (hour 165 etc.). Rejects those and counts them.
+static bool readNow(RtcTime& now) {
+    hal_rtcRead(now);
+    bool ok = now.hour < 24 && now.minute < 60 && now.second < 60 &&
+              now.month >= 1 && now.month <= 12 && now.day >= 1 && now.day <= 31;
+    if (!ok && s_readFailures < 0xFFFF) s_readFailures++;
+    return ok;
+}
+
+// Seconds since 1970-01-01 for a 2000-2099 date; same count as RTClib's
+// DateTime::unixtime(), which earlier schedule records were saved with.
+static uint32_t toUnix(const RtcTime& t) {
+    static const uint8_t kDaysInMonth[11] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30 };
+    uint16_t y    = t.year >= 2000 ? (uint16_t)(t.year - 2000) : 0;
+    uint32_t days = t.day - 1;
+    for (uint8_t m = 1; m < t.month && m < 12; ++m) days += kDaysInMonth[m - 1];
+    if (t.month > 2 && y % 4 == 0) days++;
+    days += 365UL * y + (y + 3) / 4;
+    return 946684800UL + ((days * 24 + t.hour) * 60 + t.minute) * 60 + t.second;
+}
 
 void clock_begin() {
-    Wire.begin();
-    s_rtcAvailable = g_rtc.begin();
+    s_rtcAvailable = hal_rtcBegin();
 }
 
 bool clock_available() {
@@ -17,16 +37,18 @@ bool clock_available() {
 
 bool clock_nowHM(uint8_t& hour, uint8_t& minute) {
     if (!s_rtcAvailable) return false;
-    DateTime now = g_rtc.now();
-    hour   = now.hour();
-    minute = now.minute();
+    RtcTime now;
+    if (!readNow(now)) return false;
+    hour   = now.hour;
+    minute = now.minute;
     return true;
 }
 
 uint16_t clock_nowMinutes() {
     if (!s_rtcAvailable) return CLOCK_MINUTES_INVALID;
-    DateTime now = g_rtc.now();
-    return (uint16_t)(now.hour() * 60u + now.minute());
+    RtcTime now;
+    if (!readNow(now)) return CLOCK_MINUTES_INVALID;
+    return (uint16_t)(now.hour * 60u + now.minute);
 }
 
 bool clock_isAwake(const SleepSchedule& schedule) {
@@ -36,16 +58,43 @@ bool clock_isAwake(const SleepSchedule& schedule) {
     const uint16_t wake = toMinutes(schedule.wakeHour,  schedule.wakeMinute);
     const uint16_t bed  = toMinutes(schedule.sleepHour, schedule.sleepMinute);
     const uint16_t nowM = clock_nowMinutes();
-    if (nowM == CLOCK_MINUTES_INVALID) return false;
+    // A rejected read (already counted) keeps the last answer, so one bad
+    // I2C transfer doesn't look like a sleep/wake transition.
+    if (nowM == CLOCK_MINUTES_INVALID) return s_lastAwake;
 
     if (wake < bed) {
         // Normal daytime window: awake during [wake, bed)
-        return (nowM >= wake) && (nowM < bed);
+        s_lastAwake = (nowM >= wake) && (nowM < bed);
     } else if (wake > bed) {
         // Crosses midnight: awake during [wake, 24h) U [0, bed)
-        return (nowM >= wake) || (nowM < bed);
+        s_lastAwake = (nowM >= wake) || (nowM < bed);
     } else {
         // wake == bed: treat as always awake
-        return true;
+        s_lastAwake = true;
     }
+    return s_lastAwake;
+}
+
+bool clock_nowUnix(uint32_t& unixSeconds) {
+    if (!s_rtcAvailable) return false;
+    RtcTime now;
+    if (!readNow(now)) return false;
+    unixSeconds = toUnix(now);
+    return true;
+}
+
+uint16_t clock_readFailures() {
+    return s_readFailures;
+}
+
+bool clock_readNvram(uint8_t addr, uint8_t* buf, uint8_t len) {
+    if (!s_rtcAvailable || addr + len > CLOCK_NVRAM_SIZE) return false;
+    hal_rtcReadNvram(addr, buf, len);
+    return true;
+}
+
+bool clock_writeNvram(uint8_t addr, const uint8_t* buf, uint8_t len) {
+    if (!s_rtcAvailable || addr + len > CLOCK_NVRAM_SIZE) return false;
+    hal_rtcWriteNvram(addr, buf, len);
+    return true;
 }
@@ -9,3 +9,11 @@ bool     clock_available();
 bool     clock_nowHM(uint8_t& hour, uint8_t& minute);
 uint16_t clock_nowMinutes();                          // minutes since midnight; 0xFFFF if RTC unavailable
 bool     clock_isAwake(const SleepSchedule& schedule);
+bool     clock_nowUnix(uint32_t& unixSeconds);           // false if RTC unavailable
+uint16_t clock_readFailures();                        // reads rejected as garbage since boot
+
+// DS1307 battery-backed NVRAM (56 bytes, addresses 0-55). Unlike EEPROM it has
+// no write-cycle limit, so it suits state that changes every few minutes.
+constexpr uint8_t CLOCK_NVRAM_SIZE = 56;
+bool     clock_readNvram(uint8_t addr, uint8_t* buf, uint8_t len);
+bool     clock_writeNvram(uint8_t addr, const uint8_t* buf, uint8_t len);
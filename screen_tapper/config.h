@@ -7,6 +7,47 @@
 // =============================================================================
 // #define DEBUG
 
+// =============================================================================
+// PROFILING
+// Uncomment to time loop() sections into histograms ("prof" on the console).
+// Disabled, the PROFILE_* macros compile to nothing.
+// =============================================================================
+// #define PROFILE
+
+// =============================================================================
+// POWER-FAIL DETECTION
+// Uncomment once the supply sense divider is fitted. The divider taps the
+// USB 5 V rail upstream of the hold-up capacitor's diode and is sized so
+// POWER_SENSE_ADC_CHANNEL falls below the 1.1 V bandgap at about 4.4 V.
+// =============================================================================
+// #define POWER_FAIL_DETECT
+
+// =============================================================================
+// SD CARD LOGGING
+// Uncomment to mirror the event log to an SD card. By default the log goes
+// into LOG.BIN in the root of a FAT16/FAT32 card; create it on a freshly
+// formatted card (e.g. dd if=/dev/zero of=LOG.BIN bs=1M count=64) so its
+// clusters are contiguous. Uncomment SD_LOG_RAW to use a raw block range.
+// =============================================================================
+// #define SD_LOGGING
+// #define SD_LOG_RAW
+
+// =============================================================================
+// PIN TRACE
+// Uncomment to timestamp every solenoid gate change into a RAM ring
+// ("trace" on the console), for checking pulse widths without a logic
+// analyzer. The host build always keeps a full trace (see hal_host.h).
+// =============================================================================
+// #define PIN_TRACE
+
+// =============================================================================
+// LCD MIRROR
+// Uncomment to stream the LCD over the serial port as changed 8x8 tiles
+// ("mirror on|off" on the console), for units whose screen can't be seen.
+// tools/lcd_mirror_view.py shows or records the stream.
+// =============================================================================
+// #define LCD_MIRROR
+
 // =============================================================================
 // PIN ASSIGNMENTS
 // =============================================================================
@@ -28,6 +69,12 @@ constexpr int LCD12864_CS  = 49;
 // Tap-timer reset button (mounted on LCD module, INPUT_PULLUP, active LOW)
 constexpr int RESET_BUTTON_PIN = 31;
 
+// Supply sense divider for power-fail detection (analog channel, A1)
+constexpr uint8_t POWER_SENSE_ADC_CHANNEL = 1;
+
+// SD card chip select (card on hardware SPI: MISO 50, MOSI 51, SCK 52)
+constexpr int SD_CS_PIN = 47;
+
 // =============================================================================
 // TAP TIMING PARAMETERS
 // =============================================================================
@@ -58,6 +105,39 @@ constexpr ModeParams kModeTest = {
     5,       // floatGemTaps
 };
 
+// =============================================================================
+// SOLENOID THERMAL BUDGET
+// =============================================================================
+
+// Each channel (solenoid plus MOSFET) integrates on-time x duty as heat, in
+// ms at full drive, and cools exponentially with kThermalTauMs. The figures
+// are a conservative starting point: raise the limit once coil temperature
+// has been measured at the shorter pauses.
+constexpr uint32_t kThermalTauMs   = 30000;
+constexpr uint32_t kThermalLimitMs = 4000;
+
+// Pause between taps while a channel is cold. It grows linearly with the
+// channel's heat up to the mode's pauseBetweenTapsMs at the limit, and a
+// pulse that would push the channel over the limit waits until it fits.
+constexpr uint16_t kTapPauseMinMs = 400;
+
+// =============================================================================
+// ADAPTIVE INTERVAL
+// =============================================================================
+
+// Reset-button presses after a cycle, kept as "ready again" samples. The
+// window is persisted in the settings record, so changing it needs a new
+// settings schema.
+constexpr uint8_t kIntervalWindow = 5;
+
+// Samples needed before the median replaces kModeActual.baseIntervalMs.
+constexpr uint8_t kIntervalMinSamples = 3;
+
+// Samples outside this range are dropped as outliers (a press right after a
+// cycle, or after a long absence), which also bounds the learned interval.
+constexpr uint32_t kIntervalLearnMinMs = 5UL * 60 * 1000;
+constexpr uint32_t kIntervalLearnMaxMs = 15UL * 60 * 1000;
+
 // =============================================================================
 // SLEEP SCHEDULE
 // =============================================================================
@@ -75,5 +155,159 @@ inline uint16_t toMinutes(uint8_t h, uint8_t m) { return h * 60u + m; }
 // GEM STORE
 // =============================================================================
 
+// Gems represented by one cleared bit in the gem store's increment bitmap.
+// Flushes commit whole units; any remainder stays in the session count.
+constexpr uint8_t kGemUnit = 5;
+
 // Save lifetime gem count to EEPROM after this many session gems accumulate.
-constexpr uint16_t kGemSaveThreshold = 25;
+// A flush usually costs one fast, non-erasing byte write (see gem_store.cpp).
+// With power-fail detection the unflushed count survives an unplug, so the
+// threshold can be much higher. It must fit the one-byte power-fail record.
+#ifdef POWER_FAIL_DETECT
+constexpr uint16_t kGemSaveThreshold = 100;
+#else
+constexpr uint16_t kGemSaveThreshold = 10;
+#endif
+static_assert(kGemSaveThreshold < 240, "session gems must fit in one byte");
+
+// =============================================================================
+// EEPROM WRITE QUEUE
+// =============================================================================
+
+// Byte writes buffered in RAM for the EE_READY interrupt to program.
+// Must be a power of two; one slot is kept free to tell full from empty.
+constexpr uint8_t kEepromQueueSize = 32;
+
+// =============================================================================
+// HOUSEKEEPING
+// =============================================================================
+
+// Gem bitmap bytes erased per housekeeping slice (see housekeeping.h): half
+// the write queue, so a slice never waits for room.
+constexpr uint8_t kGemEraseSlice = kEepromQueueSize / 2;
+
+// =============================================================================
+// EVENT LOG
+// =============================================================================
+
+// Binary event records held in RAM until dumped (8 bytes each).
+// Must be a power of two, at most 128. A tap cycle logs adGemTaps +
+// floatGemTaps + 2 records, so 64 holds a little over two cycles.
+constexpr uint8_t kEventLogSize = 64;
+
+// A loop() iteration longer than this is logged as an overrun.
+constexpr uint16_t kLoopOverrunMs = 20;
+
+// =============================================================================
+// PIN TRACE
+// =============================================================================
+
+// Gate changes kept when PIN_TRACE is defined (6 bytes each); the oldest
+// are overwritten. Must be a power of two.
+constexpr uint8_t kPinTraceSize = 32;
+
+// =============================================================================
+// LCD MIRROR
+// =============================================================================
+
+// Shortest time between two mirrored frames; screens drawn in between are
+// folded into the next one.
+constexpr uint16_t kLcdMirrorPeriodMs = 250;
+
+// Largest mirror frame payload. With the framing it must fit the serial
+// TX buffer (63 bytes on the Mega) or it would never find room.
+constexpr uint8_t kLcdMirrorFrameMax = 48;
+
+// Every kLcdMirrorRefreshMs, kLcdMirrorRefreshTiles tiles are resent even if
+// unchanged, so a viewer that starts late fills in the whole screen (128
+// tiles) within about a minute.
+constexpr uint16_t kLcdMirrorRefreshMs    = 1000;
+constexpr uint8_t  kLcdMirrorRefreshTiles = 2;
+
+// =============================================================================
+// YIELD STATISTICS
+// =============================================================================
+
+// Bins kept by stats.cpp: hourly in RAM (8 bytes each), daily in EEPROM
+// from kStatsEepromAddr (12 bytes each, one slot per day of the ring).
+constexpr uint8_t  kStatsHours      = 48;
+constexpr uint8_t  kStatsDays       = 30;
+constexpr uint16_t kStatsEepromAddr = 3584;
+
+// Today's bin is written back this often, on the way into sleep and when
+// the day rolls over. Unchanged bytes are skipped, so each write costs only
+// the counters that moved.
+constexpr uint32_t kStatsPersistMs = 60UL * 60 * 1000;
+
+// =============================================================================
+// SELF-BENCHMARK
+// =============================================================================
+
+// Longest stretch of benchmark work per loop(), well inside kWatchdogMs.
+constexpr uint8_t kSelfBenchSliceMs = 50;
+
+// Scratch byte the EEPROM case programs (16 erase cycles per run), in the
+// reserved tail of the EEPROM map (see gem_store.cpp).
+constexpr uint16_t kSelfBenchEepromAddr = 4095;
+
+// =============================================================================
+// INPUT LATENCY
+// =============================================================================
+
+// Input-to-frame delays are binned in kLatencyBucketUs steps; the last
+// bucket also takes everything beyond (128 ms here, longer than a full
+// software-SPI frame plus a slow loop() pass).
+constexpr uint16_t kLatencyBucketUs = 2000;
+constexpr uint8_t  kLatencyBuckets  = 64;
+
+// =============================================================================
+// SD CARD LOGGING
+// =============================================================================
+
+// Raw block range used when SD_LOG_RAW is defined (64 MiB from block 0).
+constexpr uint32_t kSdRawFirstBlock = 0;
+constexpr uint32_t kSdRawBlockCount = 131072;
+
+// Bytes of a 512-byte block sent to the card per loop() iteration.
+constexpr uint8_t kSdSliceBytes = 64;
+
+// A partly filled block is written after this long, so a quiet log still
+// reaches the card.
+constexpr uint32_t kSdSyncMs = 60000;
+
+// =============================================================================
+// SERIAL CONSOLE
+// =============================================================================
+
+// 250000 baud divides 16 MHz exactly, so the USB bridge sees no rate error.
+constexpr uint32_t kSerialBaud = 250000;
+
+// Console output buffered in RAM ahead of the 64-byte serial TX buffer.
+// Must be a power of two; messages that don't fit are dropped whole.
+constexpr uint8_t kConsoleTxSize = 128;
+
+// Longest accepted command line, excluding the terminator.
+constexpr uint8_t kConsoleLineMax = 31;
+
+// Default period of the status line (ms); "set status <ms>" changes it and
+// 0 turns it off.
+constexpr uint16_t kStatusIntervalMs = 1000;
+
+// =============================================================================
+// MEMORY MONITOR
+// =============================================================================
+
+// How often the painted stack region is rescanned for the low-water mark.
+constexpr uint16_t kMemScanMs = 1000;
+
+// =============================================================================
+// WATCHDOG
+// =============================================================================
+
+// Watchdog timeout (ms): 15, 30, 60, 120, 250, 500, 1000, 2000, 4000 or 8000.
+// The slowest normal loop() is a full LCD frame plus an RTC read, well under
+// 100 ms. RTC setup runs before the watchdog is armed; SD card setup runs in
+// loop() after the first frame and feeds the watchdog while it waits on the
+// card. The first timeout cuts the solenoids and records the running
+// section, the second resets the board.
+constexpr uint16_t kWatchdogMs = 500;
@@ -0,0 +1,384 @@
+// Purpose: non-blocking serial console: buffered output, periodic status
+// line, and a fixed-buffer command parser that emits MenuActions.
+
+#include "console.h"
+#include "config.h"
+#include "event_log.h"
+#include "profiler.h"
+#include "pin_trace.h"
+#include "lcd_mirror.h"
+#include "boot_timing.h"
+#include "stats.h"
+#include "ui_latency.h"
+#include "mem_monitor.h"
+#include "watchdog.h"
+#include "hal.h"
+#include <Arduino.h>
+#include <stdarg.h>
+
+static_assert((kConsoleTxSize & (kConsoleTxSize - 1)) == 0,
+              "kConsoleTxSize must be a power of two");
+
+static constexpr uint8_t kTxMask  = kConsoleTxSize - 1;
+static constexpr uint8_t LINE_MAX = 63;   // longest formatted output line
+static constexpr uint8_t MAX_ARGS = 3;
+
+// Output ring. Only loop() code touches it; no interrupt involvement.
+static char     s_tx[kConsoleTxSize];
+static uint8_t  s_txHead    = 0;
+static uint8_t  s_txTail    = 0;
+static uint16_t s_txDropped = 0;
+
+// Input line
+static char    s_line[kConsoleLineMax + 1];
+static uint8_t s_lineLen      = 0;
+static bool    s_lineOverflow = false;
+
+// Multi-line replies go out one line per update as the ring drains.
+enum class Reply : uint8_t { None, Help, Get };
+static Reply   s_reply     = Reply::None;
+static uint8_t s_replyLine = 0;
+
+static uint16_t s_statusPeriod = kStatusIntervalMs;
+static uint32_t s_lastStatus   = 0;
+static bool     s_statusNow    = false;
+
+// ---------------------------------------------------------------------------
+// Help text
+// ---------------------------------------------------------------------------
+static const char HELP_0[] PROGMEM = "help | get | status | mem | wdt | boot | reset | bench";
+static const char HELP_1[] PROGMEM = "stats | dump | latency [reset]";
+static const char HELP_2[] PROGMEM = "set duration <ms> | duty <0-255>";
+static const char HELP_3[] PROGMEM = "set sleep <hh:mm> | wake <hh:mm>";
+static const char HELP_4[] PROGMEM = "set gems <n> | status <ms>";
+static const char HELP_5[] PROGMEM = "set enabled|test|override|adaptive <0|1>";
+static const char* const kHelp[] PROGMEM = { HELP_0, HELP_1, HELP_2, HELP_3, HELP_4, HELP_5 };
+static constexpr uint8_t kHelpLines = sizeof(kHelp) / sizeof(kHelp[0]);
+static constexpr uint8_t kGetLines  = 9;
+
+// ---------------------------------------------------------------------------
+// Output
+// ---------------------------------------------------------------------------
+
+static uint8_t txFree() {
+    return (uint8_t)(kConsoleTxSize - 1 - ((s_txHead - s_txTail) & kTxMask));
+}
+
+// Appends text plus a newline, or nothing at all if it doesn't fit.
+static bool queueLine(const char* text, uint8_t len) {
+    if ((uint16_t)len + 1 > txFree()) {
+        if (s_txDropped < 0xFFFF) s_txDropped++;
+        return false;
+    }
+    for (uint8_t i = 0; i < len; ++i) {
+        s_tx[s_txHead] = text[i];
+        s_txHead = (uint8_t)((s_txHead + 1) & kTxMask);
+    }
+    s_tx[s_txHead] = '\n';
+    s_txHead = (uint8_t)((s_txHead + 1) & kTxMask);
+    return true;
+}
+
+static bool vqueuef(const char* fmtP, va_list ap) {
+    char buf[LINE_MAX + 1];
+    int n = vsnprintf_P(buf, sizeof(buf), fmtP, ap);
+    if (n < 0) return false;
+    if (n > LINE_MAX) n = LINE_MAX;
+    return queueLine(buf, (uint8_t)n);
+}
+
+static bool queuef(const char* fmtP, ...) {
+    va_list ap;
+    va_start(ap, fmtP);
+    bool ok = vqueuef(fmtP, ap);
+    va_end(ap);
+    return ok;
+}
+
+// Moves as much of the ring as the serial TX buffer will take, in at most
+// two contiguous writes.
+static void drainTx() {
+    while (s_txTail != s_txHead) {
+        int room = hal_serialWriteRoom();
+        if (room <= 0) return;
+        uint8_t end = (s_txHead > s_txTail) ? s_txHead : kConsoleTxSize;
+        uint8_t len = (uint8_t)(end - s_txTail);
+        if (len > room) len = (uint8_t)room;
+        hal_serialWrite((const uint8_t*)&s_tx[s_txTail], len);
+        s_txTail = (uint8_t)((s_txTail + len) & kTxMask);
+    }
+}
+
+static void sendStatus(uint32_t nowMs, const ConsoleStatus& st) {
+    uint8_t flags = (st.deviceEnabled ? 0x01 : 0) | (st.awake    ? 0x02 : 0) |
+                    (st.tapping       ? 0x04 : 0) | (st.testMode ? 0x08 : 0) |
+                    (st.overrideClock ? 0x10 : 0);
+    queuef(PSTR("S t=%lu left=%lu gems=%lu f=%02x"),
+           (unsigned long)nowMs, (unsigned long)st.msLeft,
+           (unsigned long)st.lifetimeGems, (unsigned)flags);
+}
+
+// Emits the next line of a multi-line reply once there is room for it.
+static void continueReply(const ConsoleStatus& st) {
+    if (s_reply == Reply::None || txFree() < LINE_MAX + 1) return;
+
+    if (s_reply == Reply::Help) {
+        char buf[LINE_MAX + 1];
+        strcpy_P(buf, (const char*)pgm_read_ptr(&kHelp[s_replyLine]));
+        queueLine(buf, (uint8_t)strlen(buf));
+        if (++s_replyLine >= kHelpLines) s_reply = Reply::None;
+        return;
+    }
+
+    switch (s_replyLine) {
+    case 0: queuef(PSTR("duration=%u"), (unsigned)st.tapDuration); break;
+    case 1: queuef(PSTR("duty=%u"), (unsigned)st.tapDuty); break;
+    case 2: queuef(PSTR("sleep=%02u:%02u"), (unsigned)st.sleepHour, (unsigned)st.sleepMinute); break;
+    case 3: queuef(PSTR("wake=%02u:%02u"), (unsigned)st.wakeHour, (unsigned)st.wakeMinute); break;
+    case 4: queuef(PSTR("gems=%lu"), (unsigned long)st.lifetimeGems); break;
+    case 5: queuef(PSTR("enabled=%u"), (unsigned)st.deviceEnabled); break;
+    case 6: queuef(PSTR("test=%u"), (unsigned)st.testMode); break;
+    case 7: queuef(PSTR("override=%u"), (unsigned)st.overrideClock); break;
+    case 8: queuef(PSTR("adaptive=%u interval=%lu samples=%u"), (unsigned)st.adaptive,
+                   (unsigned long)(st.baseIntervalMs / 1000), (unsigned)st.intervalSamples); break;
+    }
+    if (++s_replyLine >= kGetLines) s_reply = Reply::None;
+}
+
+// ---------------------------------------------------------------------------
+// Parsing
+// ---------------------------------------------------------------------------
+
+// Splits the line in place on spaces; returns the number of tokens.
+static uint8_t tokenize(char* line, char* argv[MAX_ARGS + 1]) {
+    uint8_t argc = 0;
+    char* p = line;
+    while (*p) {
+        while (*p == ' ') *p++ = '\0';
+        if (!*p) break;
+        if (argc > MAX_ARGS) return argc;  // too many; caller rejects
+        argv[argc++] = p;
+        while (*p && *p != ' ') ++p;
+    }
+    return argc;
+}
+
+static bool parseU32(const char* s, uint32_t& out) {
+    if (!*s) return false;
+    uint32_t v = 0;
+    for (; *s; ++s) {
+        if (*s < '0' || *s > '9') return false;
+        uint8_t d = (uint8_t)(*s - '0');
+        if (v > (0xFFFFFFFFUL - d) / 10) return false;
+        v = v * 10 + d;
+    }
+    out = v;
+    return true;
+}
+
+static bool parseRange(const char* s, uint32_t lo, uint32_t hi, uint32_t& out) {
+    return parseU32(s, out) && out >= lo && out <= hi;
+}
+
+static bool parseTime(char* s, uint8_t& hh, uint8_t& mm) {
+    char* colon = strchr(s, ':');
+    if (!colon) return false;
+    *colon = '\0';
+    uint32_t h, m;
+    if (!parseRange(s, 0, 23, h) || !parseRange(colon + 1, 0, 59, m)) return false;
+    hh = (uint8_t)h;
+    mm = (uint8_t)m;
+    return true;
+}
+
+static bool is(const char* token, const char* nameP) {
+    return strcmp_P(token, nameP) == 0;
+}
+
+// Emits a toggle action only when the requested state differs.
+static bool setFlag(const char* arg, bool current, MenuActionType toggle, MenuAction& out) {
+    uint32_t v;
+    if (!parseRange(arg, 0, 1, v)) return false;
+    if ((v != 0) != current) out.type = toggle;
+    return true;
+}
+
+static bool runSet(char* key, char* arg, const ConsoleStatus& st, MenuAction& out) {
+    uint32_t v;
+    uint8_t hh, mm;
+    out.committed = true;
+
+    if (is(key, PSTR("duration"))) {
+        if (!parseRange(arg, TAP_MIN_MS, TAP_MAX_MS, v)) return false;
+        out.type = MenuActionType::SetTapDuration;
+        out.u16a = (uint16_t)v;
+    } else if (is(key, PSTR("duty"))) {
+        if (!parseRange(arg, TAP_DUTY_MIN, TAP_DUTY_MAX, v)) return false;
+        out.type = MenuActionType::SetTapDuty;
+        out.u16a = (uint16_t)v;
+    } else if (is(key, PSTR("sleep")) || is(key, PSTR("wake"))) {
+        if (!parseTime(arg, hh, mm)) return false;
+        out.type = is(key, PSTR("sleep")) ? MenuActionType::SetSleepTime
+                                          : MenuActionType::SetWakeTime;
+        out.u16a = hh;
+        out.u16b = mm;
+    } else if (is(key, PSTR("gems"))) {
+        if (!parseRange(arg, GEMS_MIN, GEMS_MAX, v)) return false;
+        out.type = MenuActionType::SetGemCount;
+        out.u32  = v;
+    } else if (is(key, PSTR("enabled"))) {
+        return setFlag(arg, st.deviceEnabled, MenuActionType::ToggleDeviceEnabled, out);
+    } else if (is(key, PSTR("test"))) {
+        return setFlag(arg, st.testMode, MenuActionType::ToggleTestMode, out);
+    } else if (is(key, PSTR("override"))) {
+        return setFlag(arg, st.overrideClock, MenuActionType::ToggleOverrideSleep, out);
+    } else if (is(key, PSTR("adaptive"))) {
+        return setFlag(arg, st.adaptive, MenuActionType::ToggleAdaptiveInterval, out);
+    } else if (is(key, PSTR("status"))) {
+        if (!parseRange(arg, 0, 0xFFFF, v)) return false;
+        s_statusPeriod = (uint16_t)v;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Runs one command line. Returns true if it produced an action.
+static bool runLine(const ConsoleStatus& st, MenuAction& out) {
+    char* argv[MAX_ARGS + 1];
+    uint8_t argc = tokenize(s_line, argv);
+    if (argc == 0) return false;
+
+    bool ok = true;
+    const char* cmd = argv[0];
+    if (argc == 1 && is(cmd, PSTR("help"))) {
+        s_reply = Reply::Help;
+        s_replyLine = 0;
+        return false;
+    } else if (argc == 1 && is(cmd, PSTR("get"))) {
+        s_reply = Reply::Get;
+        s_replyLine = 0;
+        return false;
+    } else if (argc == 1 && is(cmd, PSTR("status"))) {
+        s_statusNow = true;
+        return false;
+    } else if (argc == 1 && is(cmd, PSTR("mem"))) {
+        queuef(PSTR("M static=%u heap=%u free=%u min=%u"),
+               mem_monitor_staticBytes(), mem_monitor_heapBytes(),
+               mem_monitor_freeNow(), mem_monitor_minFree());
+        return false;
+    } else if (argc == 1 && is(cmd, PSTR("wdt"))) {
+        char cause[12], section[12];
+        strcpy_P(cause, watchdog_causeName(watchdog_resetCause()));
+        strcpy_P(section, loop_section_name(watchdog_lastSection()));
+        queuef(PSTR("W cause=%s section=%s near=%u"), cause, section,
+               watchdog_nearMisses());
+        return false;
+    } else if (argc == 1 && is(cmd, PSTR("boot"))) {
+        boot_timing_requestDump();
+        return false;
+    } else if (argc == 1 && is(cmd, PSTR("stats"))) {
+        stats_requestDump();
+        return false;
+    } else if (argc == 1 && is(cmd, PSTR("latency"))) {
+        ui_latency_requestDump();
+        return false;
+    } else if (argc == 2 && is(cmd, PSTR("latency")) && is(argv[1], PSTR("reset"))) {
+        ui_latency_reset();
+    } else if (argc == 1 && is(cmd, PSTR("dump"))) {
+        event_log_requestDump();
+        return false;
+#ifdef PROFILE
+    } else if (argc == 1 && is(cmd, PSTR("prof"))) {
+        profiler_requestDump();
+        return false;
+    } else if (argc == 2 && is(cmd, PSTR("prof")) && is(argv[1], PSTR("reset"))) {
+        profiler_reset();
+#endif
+#ifdef PIN_TRACE
+    } else if (argc == 1 && is(cmd, PSTR("trace"))) {
+        pin_trace_requestDump();
+        return false;
+    } else if (argc == 2 && is(cmd, PSTR("trace")) && is(argv[1], PSTR("reset"))) {
+        pin_trace_reset();
+#endif
+#ifdef LCD_MIRROR
+    } else if (argc == 2 && is(cmd, PSTR("mirror")) && is(argv[1], PSTR("on"))) {
+        lcd_mirror_enable(true);
+    } else if (argc == 2 && is(cmd, PSTR("mirror")) && is(argv[1], PSTR("off"))) {
+        lcd_mirror_enable(false);
+#endif
+    } else if (argc == 1 && is(cmd, PSTR("reset"))) {
+        out.type = MenuActionType::ResetNextTap;
+    } else if (argc == 1 && is(cmd, PSTR("bench"))) {
+        out.type = MenuActionType::RunSelfBench;
+    } else if (argc == 3 && is(cmd, PSTR("set"))) {
+        ok = runSet(argv[1], argv[2], st, out);
+    } else {
+        ok = false;
+    }
+
+    queuef(ok ? PSTR("ok") : PSTR("err"));
+    return ok && out.type != MenuActionType::None;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+void console_begin() {
+    hal_serialBegin(kSerialBaud);
+}
+
+bool console_printf(const char* fmtP, ...) {
+    va_list ap;
+    va_start(ap, fmtP);
+    bool ok = vqueuef(fmtP, ap);
+    va_end(ap);
+    return ok;
+}
+
+bool console_update(uint32_t nowMs, const ConsoleStatus& st, MenuAction& outAction) {
+    bool fired = false;
+
+    // Stop at the first line that fires an action, and while a multi-line
+    // reply is still going out; the rest is read on a later loop.
+    while (!fired && s_reply == Reply::None && hal_serialAvailable() > 0) {
+        char c = (char)hal_serialRead();
+        if (c == '\r' || c == '\n') {
+            if (s_lineOverflow) {
+                queuef(PSTR("err"));
+            } else if (s_lineLen > 0) {
+                s_line[s_lineLen] = '\0';
+                MenuAction act;
+                fired = runLine(st, act);
+                if (fired) outAction = act;
+            }
+            s_lineLen      = 0;
+            s_lineOverflow = false;
+        } else if (s_lineLen < kConsoleLineMax) {
+            s_line[s_lineLen++] = c;
+        } else {
+            s_lineOverflow = true;
+        }
+    }
+
+    bool periodic = s_statusPeriod != 0 && nowMs - s_lastStatus >= s_statusPeriod;
+    if (periodic || s_statusNow) {
+        sendStatus(nowMs, st);
+        s_lastStatus = nowMs;
+        s_statusNow  = false;
+    }
+
+    continueReply(st);
+    drainTx();
+    return fired;
+}
+
+bool console_txIdle() {
+    return s_txHead == s_txTail;
+}
+
+uint16_t console_dropped() {
+    return s_txDropped;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <stdint.h>
+#include "menu.h"
+
+// Serial command console and status telemetry.
+//
+// Nothing here waits on the UART. Output is staged in a RAM ring and moved
+// into the serial TX buffer as it drains; a message that does not fit is
+// dropped whole and counted. Input is collected a character at a time into
+// a fixed line buffer, so commands cost no heap and no blocking reads.
+//
+// Commands (one per line, case-sensitive):
+//   help                    list commands
+//   get                     print every setting
+//   set duration <ms>       tap duration
+//   set duty <0-255>        tap PWM duty
+//   set sleep <hh:mm>       sleep time
+//   set wake <hh:mm>        wake time
+//   set gems <n>            lifetime gem count
+//   set enabled|test|override|adaptive <0|1>
+//   set status <ms>         status line period, 0 = off
+//   reset                   reschedule the next tap
+//   status                  print a status line now
+//   mem                     SRAM use: static, heap, free now, least free
+//   wdt                     last reset cause and section, near misses
+//   boot                    boot phase timings (boot_timing.h)
+//   stats                   hourly and daily yield bins (stats.h)
+//   latency [reset]         input-to-frame delay percentiles (or clear them)
+//   dump                    stream the binary event log
+//   prof [reset]            print (or clear) section timings; PROFILE builds
+//   trace [reset]           print (or clear) the gate trace; PIN_TRACE builds
+//   mirror on|off           start or stop the LCD mirror; LCD_MIRROR builds
+//   bench                   run the self-benchmark (self_bench.h)
+//
+// Settings changes come back from console_update() as committed
+// MenuActions, so they take the same path as edits made with the knob.
+//
+// Status line: "S t=<ms> left=<ms> gems=<n> f=<flags>", flags in hex:
+//   0x01 enabled, 0x02 awake, 0x04 tapping, 0x08 test mode, 0x10 override
+
+// Application state the console reports. Filled in by the app each loop().
+struct ConsoleStatus {
+    uint32_t msLeft        = 0;
+    uint32_t lifetimeGems  = 0;
+    uint16_t tapDuration   = 0;
+    uint8_t  tapDuty       = 0;
+    uint8_t  sleepHour     = 0;
+    uint8_t  sleepMinute   = 0;
+    uint8_t  wakeHour      = 0;
+    uint8_t  wakeMinute    = 0;
+    bool     deviceEnabled = false;
+    bool     awake         = false;
+    bool     tapping       = false;
+    bool     testMode      = false;
+    bool     overrideClock = false;
+    bool     adaptive      = false;
+    uint32_t baseIntervalMs  = 0;   // what the next interval is based on
+    uint8_t  intervalSamples = 0;
+};
+
+// Open the serial port at kSerialBaud.
+void console_begin();
+
+// Queue a formatted line (format string in flash, e.g. PSTR("x=%u")); the
+// newline is added. Returns false if the line was dropped.
+bool console_printf(const char* fmtP, ...);
+
+// Read input, run commands, send the periodic status line and drain queued
+// output. Returns true and fills outAction when a command changes a setting.
+bool console_update(uint32_t nowMs, const ConsoleStatus& st, MenuAction& outAction);
+
+// True when no console output is waiting, so binary frames (event log dump)
+// can go out without splitting a text line.
+bool console_txIdle();
+
+// Messages dropped because the output ring was full.
+uint16_t console_dropped();
@@ -0,0 +1,20 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF). Shared by the persisted
+// records and host-facing frames so host tools need only one routine.
+
+inline uint16_t crc16_update(uint16_t crc, uint8_t b) {
+    crc ^= (uint16_t)b << 8;
+    for (uint8_t i = 0; i < 8; ++i) {
+        crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+inline uint16_t crc16(const void* data, size_t len, uint16_t crc = 0xFFFF) {
+    const uint8_t* p = (const uint8_t*)data;
+    while (len--) crc = crc16_update(crc, *p++);
+    return crc;
+}
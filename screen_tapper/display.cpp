@@ -1,21 +1,25 @@
-// Purpose: render the MenuView onto the 128×64 ST7920 LCD using U8g2.
+// Purpose: render the MenuView onto the 128×64 ST7920 LCD through the HAL.
 
 #include "display.h"
 #include "config.h"
+#include "loop_section.h"
+#include "hal.h"
+#include "mono_time.h"
+#include "format.h"
+#include "self_bench.h"
+#include "boot_timing.h"
+#include "stats.h"
+#include "lcd_mirror.h"
+#include "ui_latency.h"
 #include <Arduino.h>
-#include <U8g2lib.h>
-
-static U8G2_ST7920_128X64_F_SW_SPI u8g2(
-    U8G2_R0, LCD12864_CLK, LCD12864_DAT, LCD12864_CS
-);
 
 // ---------------------------------------------------------------------------
 // Fonts
 // ---------------------------------------------------------------------------
-static const uint8_t* FONT_TITLE  = u8g2_font_7x14B_tf;
-static const uint8_t* FONT_BODY   = u8g2_font_6x10_tf;
-static const uint8_t* FONT_NUMBER = u8g2_font_helvB10_tf;
-static const uint8_t* FONT_SMALL  = u8g2_font_5x8_tf;
+static constexpr LcdFont FONT_TITLE  = LcdFont::Title;
+static constexpr LcdFont FONT_BODY   = LcdFont::Body;
+static constexpr LcdFont FONT_NUMBER = LcdFont::Number;
+static constexpr LcdFont FONT_SMALL  = LcdFont::Small;
 
 // ---------------------------------------------------------------------------
 // Layout constants
@@ -29,6 +33,7 @@ static constexpr uint8_t MARGIN         = 0;
 static constexpr uint8_t COLUMN_GAP     = 20;
 static constexpr uint8_t TAP_DURATION_Y = 26;
 static constexpr uint8_t CLOCK_Y        = 26;
+static constexpr uint8_t LINE_H_SMALL   = 9;
 
 // Home screen layout
 static constexpr uint8_t X_HOME_1     = 0;    // icon column x
@@ -41,26 +46,39 @@ static constexpr uint8_t Y_HOME_SPACE = 15;   // row spacing
 // Frame rate limiting
 // ---------------------------------------------------------------------------
 static bool     lcdDirty     = true;
-static uint32_t nextFrameMs  = 0;
+static Deadline nextFrame;
 static constexpr uint16_t kFramePeriodMs = 100;  // 10 FPS max
 
+// The controller is brought up by the first render rather than in setup(),
+// so boot reaches loop() without waiting on two software-SPI frames.
+static bool     s_lcdStarted = false;
+
+// Diagnostics counters
+static uint32_t s_framesRendered = 0;
+static uint32_t s_framesSkipped  = 0;   // dirty frames held back by the limiter
+static bool     s_skipCounted    = false;
+
+// Oldest input not yet shown, until a frame carrying it has been sent
+static bool     s_inputPending = false;
+static uint32_t s_inputUs      = 0;
+
 // First visible row for list views (scroll state)
 static uint8_t s_listFirst = 0;
 
 // ---------------------------------------------------------------------------
 // Custom bitmaps (PROGMEM)
 // ---------------------------------------------------------------------------
-static const unsigned char larrow_bitmap[] U8X8_PROGMEM = {
+static const unsigned char larrow_bitmap[] PROGMEM = {
     0b00000000, 0b00000000, 0b00010000, 0b00100000,
     0b01111110, 0b00100000, 0b00010000, 0b00000000
 };
 
-static const unsigned char return_bitmap[] U8X8_PROGMEM = {
+static const unsigned char return_bitmap[] PROGMEM = {
     0b00000000, 0b00010000, 0b00111000, 0b01111100,
     0b00010000, 0b00011110, 0b00000000, 0b00000000
 };
 
-static const unsigned char gem16_bitmap[] U8X8_PROGMEM = {
+static const unsigned char gem16_bitmap[] PROGMEM = {
     0b11111000, 0b00111111,
     0b01101100, 0b01101100,
     0b11000110, 0b11000110,
@@ -79,7 +97,7 @@ static const unsigned char gem16_bitmap[] U8X8_PROGMEM = {
     0b00000000, 0b00000000,
 };
 
-static const unsigned char clock16_bitmap[] U8X8_PROGMEM = {
+static const unsigned char clock16_bitmap[] PROGMEM = {
     0b00000000, 0b00000000,
     0b00000000, 0b00000000,
     0b00000000, 0b00000000,
@@ -98,7 +116,7 @@ static const unsigned char clock16_bitmap[] U8X8_PROGMEM = {
     0b00000000, 0b00000000,
 };
 
-static const unsigned char moon16_bitmap[] U8X8_PROGMEM = {
+static const unsigned char moon16_bitmap[] PROGMEM = {
     0b00000000, 0b00000000,
     0b00000000, 0b00000000,
     0b11000000, 0b00000001,
@@ -122,47 +140,9 @@ static const unsigned char moon16_bitmap[] U8X8_PROGMEM = {
 // ---------------------------------------------------------------------------
 
 static void headerBar(const char* title) {
-    u8g2.setFont(FONT_TITLE);
-    u8g2.setCursor(PAD, LINE_H_TITLE);
-    u8g2.print(title);
-}
-
-static void drawLabelAt(int x, int y, const char* s) {
-    u8g2.setFont(FONT_BODY);
-    u8g2.setCursor(x, y);
-    u8g2.print(s ? s : "");
-}
-
-static void fmt_commas(uint32_t v, char* out, size_t outSz) {
-    char t[16];
-    snprintf(t, sizeof(t), "%lu", (unsigned long)v);
-    int len = strlen(t), j = 0;
-    for (int i = 0; i < len && j < (int)outSz - 1; ++i) {
-        out[j++] = t[i];
-        if (((len - i - 1) % 3) == 0 && i != len - 1 && j < (int)outSz - 1)
-            out[j++] = ',';
-    }
-    out[j] = '\0';
-}
-
-static void fmt_mm_ss(uint32_t ms, char* out, size_t outSz) {
-    uint32_t s  = ms / 1000UL;
-    uint32_t mm = s / 60UL;
-    uint32_t ss = s % 60UL;
-    snprintf(out, outSz, "%02lu:%02lu", (unsigned long)mm, (unsigned long)ss);
-}
-
-static void drawSoftKeys(const char* left, const char* right) {
-    u8g2.setFont(FONT_SMALL);
-    if (left) {
-        u8g2.setCursor(PAD, H - MARGIN);
-        u8g2.print(left);
-    }
-    if (right) {
-        int16_t x = W - PAD - (int16_t)u8g2.getStrWidth(right);
-        u8g2.setCursor(x, H - MARGIN);
-        u8g2.print(right);
-    }
+    hal_lcdSetFont(FONT_TITLE);
+    hal_lcdSetCursor(PAD, LINE_H_TITLE);
+    hal_lcdPrint(title);
 }
 
 // ---------------------------------------------------------------------------
@@ -174,51 +154,58 @@ static void viewHome(const MenuView& v) {
 
     // --- Gem count (row 0, col 0) ---
     fmt_commas(v.lifetimeGems, buf, sizeof(buf));
-    u8g2.setFont(FONT_NUMBER);
-    u8g2.drawXBMP(X_HOME_1, Y_HOME_1 - 12, 16, 16, gem16_bitmap);
-    u8g2.setCursor(X_HOME_1 + X_HOME_2, Y_HOME_1);
-    u8g2.print(buf);
+    hal_lcdSetFont(FONT_NUMBER);
+    hal_lcdBitmap(X_HOME_1, Y_HOME_1 - 12, 16, 16, gem16_bitmap);
+    hal_lcdSetCursor(X_HOME_1 + X_HOME_2, Y_HOME_1);
+    hal_lcdPrint(buf);
 
     // --- Countdown (row 1, col 0) ---
     fmt_mm_ss(v.msLeft, buf, sizeof(buf));
-    u8g2.setFont(FONT_NUMBER);
-    u8g2.setCursor(X_HOME_1 + X_HOME_2, Y_HOME_1 + Y_HOME_SPACE);
-    u8g2.print(buf);
+    hal_lcdSetFont(FONT_NUMBER);
+    hal_lcdSetCursor(X_HOME_1 + X_HOME_2, Y_HOME_1 + Y_HOME_SPACE);
+    hal_lcdPrint(buf);
 
     // --- Sleep time (row 2, col 0) ---
     snprintf(buf, sizeof(buf), "%02u:%02u", (unsigned)v.sleepHour, (unsigned)v.sleepMinute);
-    u8g2.setFont(FONT_NUMBER);
-    u8g2.drawXBMP(X_HOME_1, Y_HOME_1 + 2 * Y_HOME_SPACE - 13, 16, 16, moon16_bitmap);
-    u8g2.setCursor(X_HOME_1 + X_HOME_2, Y_HOME_1 + 2 * Y_HOME_SPACE);
-    u8g2.print(buf);
+    hal_lcdSetFont(FONT_NUMBER);
+    hal_lcdBitmap(X_HOME_1, Y_HOME_1 + 2 * Y_HOME_SPACE - 13, 16, 16, moon16_bitmap);
+    hal_lcdSetCursor(X_HOME_1 + X_HOME_2, Y_HOME_1 + 2 * Y_HOME_SPACE);
+    hal_lcdPrint(buf);
 
     // --- Wake time (row 3, col 0) ---
     snprintf(buf, sizeof(buf), "%02u:%02u", (unsigned)v.wakeHour, (unsigned)v.wakeMinute);
-    u8g2.setFont(FONT_NUMBER);
-    u8g2.drawXBMP(X_HOME_1, Y_HOME_1 + 3 * Y_HOME_SPACE - 13, 16, 16, clock16_bitmap);
-    u8g2.setCursor(X_HOME_1 + X_HOME_2, Y_HOME_1 + 3 * Y_HOME_SPACE);
-    u8g2.print(buf);
+    hal_lcdSetFont(FONT_NUMBER);
+    hal_lcdBitmap(X_HOME_1, Y_HOME_1 + 3 * Y_HOME_SPACE - 13, 16, 16, clock16_bitmap);
+    hal_lcdSetCursor(X_HOME_1 + X_HOME_2, Y_HOME_1 + 3 * Y_HOME_SPACE);
+    hal_lcdPrint(buf);
 
     // --- Tap duration (row 0, col 1) ---
     snprintf(buf, sizeof(buf), "%u ms", (unsigned)v.tapDuration);
-    u8g2.setFont(FONT_NUMBER);
-    u8g2.setCursor(X_HOME_1 + X_HOME_SPACE, Y_HOME_1);
-    u8g2.print(buf);
+    hal_lcdSetFont(FONT_NUMBER);
+    hal_lcdSetCursor(X_HOME_1 + X_HOME_SPACE, Y_HOME_1);
+    hal_lcdPrint(buf);
 
     // --- Device on/off (row 1, col 1) ---
-    u8g2.setFont(FONT_NUMBER);
-    u8g2.setCursor(X_HOME_1 + X_HOME_SPACE, Y_HOME_1 + Y_HOME_SPACE);
-    u8g2.print(v.deviceEnabled ? "On" : "Off");
+    hal_lcdSetFont(FONT_NUMBER);
+    hal_lcdSetCursor(X_HOME_1 + X_HOME_SPACE, Y_HOME_1 + Y_HOME_SPACE);
+    hal_lcdPrint(v.deviceEnabled ? "On" : "Off");
 
     // --- Override sleep indicator (row 2, col 1) ---
-    u8g2.setFont(FONT_NUMBER);
-    u8g2.setCursor(X_HOME_1 + X_HOME_SPACE, Y_HOME_1 + 2 * Y_HOME_SPACE);
-    u8g2.print(v.overrideClock ? "OVR" : "");
-
-    // --- Test mode indicator (row 3, col 1) ---
-    u8g2.setFont(FONT_NUMBER);
-    u8g2.setCursor(X_HOME_1 + X_HOME_SPACE, Y_HOME_1 + 3 * Y_HOME_SPACE);
-    u8g2.print(v.testModeEnabled ? "TEST" : "");
+    hal_lcdSetFont(FONT_NUMBER);
+    hal_lcdSetCursor(X_HOME_1 + X_HOME_SPACE, Y_HOME_1 + 2 * Y_HOME_SPACE);
+    hal_lcdPrint(v.overrideClock ? "OVR" : "");
+
+    // --- Test mode indicator, or the learned interval (row 3, col 1) ---
+    buf[0] = '\0';
+    if (v.testModeEnabled) {
+        strcpy(buf, "TEST");
+    } else if (v.learnedIntervalMs) {
+        buf[0] = '~';
+        fmt_mm_ss(v.learnedIntervalMs, buf + 1, sizeof(buf) - 1);
+    }
+    hal_lcdSetFont(FONT_NUMBER);
+    hal_lcdSetCursor(X_HOME_1 + X_HOME_SPACE, Y_HOME_1 + 3 * Y_HOME_SPACE);
+    hal_lcdPrint(buf);
 }
 
 static void viewList(const MenuView& v) {
@@ -238,7 +225,7 @@ static void viewList(const MenuView& v) {
         if (s_listFirst > maxFirst) s_listFirst = maxFirst;
     }
 
-    u8g2.setFont(FONT_BODY);
+    hal_lcdSetFont(FONT_BODY);
     uint8_t y = 0;
     for (uint8_t i = 0; i < visibleRows; ++i) {
         uint8_t idx = (uint8_t)(s_listFirst + i);
@@ -247,16 +234,16 @@ static void viewList(const MenuView& v) {
         bool        selected = (idx == v.selected);
         const char* text     = v.items[idx] ? v.items[idx] : "";
 
-        u8g2.setCursor(PAD, y + LINE_H_BODY);
-        u8g2.print(selected ? ">" : " ");
-        u8g2.setCursor(8, y + LINE_H_BODY);
-        u8g2.print(text);
+        hal_lcdSetCursor(PAD, y + LINE_H_BODY);
+        hal_lcdPrint(selected ? ">" : " ");
+        hal_lcdSetCursor(8, y + LINE_H_BODY);
+        hal_lcdPrint(text);
 
         // Icon: return arrow for immediate-action items, forward arrow for sub-menus
         const unsigned char* bmp =
-            (idx == 0 || idx == 1 || idx == 2 || idx == 8 || idx == 9)
+            (idx == 0 || idx == 1 || idx == 2 || idx == 8 || idx == 9 || idx == 12)
                 ? return_bitmap : larrow_bitmap;
-        u8g2.drawXBMP(W - 18, y + LINE_H_BODY - 7, 8, 8, bmp);
+        hal_lcdBitmap(W - 18, y + LINE_H_BODY - 7, 8, 8, bmp);
 
         y += LINE_H_BODY + MARGIN;
     }
@@ -276,34 +263,34 @@ static void viewEditNumber(const MenuView& v) {
     }
 
     // Center the value
-    u8g2.setFont(FONT_NUMBER);
-    int numW = u8g2.getStrWidth(buf);
+    hal_lcdSetFont(FONT_NUMBER);
+    int numW = hal_lcdStrWidth(buf);
     int numX = (W - numW) / 2;
     int numY = TAP_DURATION_Y;
 
     if (v.editing) {
         // Show active ">" marker while value is being edited
         const char* bigMarker = ">";
-        int markerW = u8g2.getStrWidth(bigMarker);
+        int markerW = hal_lcdStrWidth(bigMarker);
         int markerX = numX - markerW - 1;
         if (markerX < PAD) markerX = PAD;
-        u8g2.setCursor(markerX, numY);
-        u8g2.print(bigMarker);
+        hal_lcdSetCursor(markerX, numY);
+        hal_lcdPrint(bigMarker);
     }
 
-    u8g2.setCursor(numX, numY);
-    u8g2.print(buf);
+    hal_lcdSetCursor(numX, numY);
+    hal_lcdPrint(buf);
 
     // Bottom 2×2 choice grid: [Value, Back] / [Save, Home]
     const char* choices[4] = { "Value", "Save", "Back", "Home" };
     const int   row1Y = H - 20;
     const int   row2Y = H - 8;
 
-    u8g2.setFont(FONT_BODY);
-    const int markerGW = u8g2.getStrWidth(">");
+    hal_lcdSetFont(FONT_BODY);
+    const int markerGW = hal_lcdStrWidth(">");
 
     auto labelW = [&](int idx) -> int {
-        return u8g2.getStrWidth(choices[idx] ? choices[idx] : "");
+        return hal_lcdStrWidth(choices[idx] ? choices[idx] : "");
     };
     auto centeredStartX = [&](int idxL, int idxR) -> int {
         int total = labelW(idxL) + COLUMN_GAP + labelW(idxR);
@@ -317,11 +304,11 @@ static void viewEditNumber(const MenuView& v) {
         int rightX = sx + labelW(idxL) + COLUMN_GAP;
         bool showMarkers = !v.editing;
 
-        if (showMarkers && v.selected == idxL) { u8g2.setCursor(leftX  - markerGW, y); u8g2.print(">"); }
-        u8g2.setCursor(leftX,  y); u8g2.print(choices[idxL]);
+        if (showMarkers && v.selected == idxL) { hal_lcdSetCursor(leftX  - markerGW, y); hal_lcdPrint(">"); }
+        hal_lcdSetCursor(leftX,  y); hal_lcdPrint(choices[idxL]);
 
-        if (showMarkers && v.selected == idxR) { u8g2.setCursor(rightX - markerGW, y); u8g2.print(">"); }
-        u8g2.setCursor(rightX, y); u8g2.print(choices[idxR]);
+        if (showMarkers && v.selected == idxR) { hal_lcdSetCursor(rightX - markerGW, y); hal_lcdPrint(">"); }
+        hal_lcdSetCursor(rightX, y); hal_lcdPrint(choices[idxR]);
     };
 
     drawRow(0, 2, row1Y);  // Value | Back
@@ -333,29 +320,29 @@ static void viewEditTime(const MenuView& v) {
     char t[8];
     snprintf(t, sizeof(t), "%02u:%02u", (unsigned)v.hh, (unsigned)v.mm);
 
-    u8g2.setFont(FONT_NUMBER);
-    int timeW = u8g2.getStrWidth(t);
+    hal_lcdSetFont(FONT_NUMBER);
+    int timeW = hal_lcdStrWidth(t);
     int timeX = (W - timeW) / 2;
     int timeY = CLOCK_Y;
 
     if (v.editingTime) {
         const char* bigMarker = ">";
-        int markerW = u8g2.getStrWidth(bigMarker);
+        int markerW = hal_lcdStrWidth(bigMarker);
         int markerX = timeX - markerW - 1;
         if (markerX < PAD) markerX = PAD;
-        u8g2.setCursor(markerX, timeY);
-        u8g2.print(bigMarker);
+        hal_lcdSetCursor(markerX, timeY);
+        hal_lcdPrint(bigMarker);
     }
 
-    u8g2.setCursor(timeX, timeY);
-    u8g2.print(t);
+    hal_lcdSetCursor(timeX, timeY);
+    hal_lcdPrint(t);
 
     // Underline active field while editing
     if (v.editingTime) {
-        int hhW    = u8g2.getStrWidth("00");
-        int colonW = u8g2.getStrWidth(":");
+        int hhW    = hal_lcdStrWidth("00");
+        int colonW = hal_lcdStrWidth(":");
         int ux     = v.editingHour ? timeX : timeX + hhW + colonW;
-        u8g2.drawHLine(ux, timeY + 3, hhW);
+        hal_lcdHLine(ux, timeY + 3, hhW);
     }
 
     // Bottom 2×2 choice grid: [Time, Back] / [Save, Home]
@@ -363,11 +350,11 @@ static void viewEditTime(const MenuView& v) {
     const int   row1Y = H - 20;
     const int   row2Y = H - 8;
 
-    u8g2.setFont(FONT_BODY);
-    const int markerGW = u8g2.getStrWidth(">");
+    hal_lcdSetFont(FONT_BODY);
+    const int markerGW = hal_lcdStrWidth(">");
 
     auto labelW = [&](int idx) -> int {
-        return u8g2.getStrWidth(choices[idx] ? choices[idx] : "");
+        return hal_lcdStrWidth(choices[idx] ? choices[idx] : "");
     };
     auto centeredStartX = [&](int idxL, int idxR) -> int {
         int total = labelW(idxL) + COLUMN_GAP + labelW(idxR);
@@ -381,42 +368,211 @@ static void viewEditTime(const MenuView& v) {
         int rightX = sx + labelW(idxL) + COLUMN_GAP;
         bool showMarkers = !v.editingTime;
 
-        if (showMarkers && v.selected == idxL) { u8g2.setCursor(leftX  - markerGW, y); u8g2.print(">"); }
-        u8g2.setCursor(leftX,  y); u8g2.print(choices[idxL]);
+        if (showMarkers && v.selected == idxL) { hal_lcdSetCursor(leftX  - markerGW, y); hal_lcdPrint(">"); }
+        hal_lcdSetCursor(leftX,  y); hal_lcdPrint(choices[idxL]);
 
-        if (showMarkers && v.selected == idxR) { u8g2.setCursor(rightX - markerGW, y); u8g2.print(">"); }
-        u8g2.setCursor(rightX, y); u8g2.print(choices[idxR]);
+        if (showMarkers && v.selected == idxR) { hal_lcdSetCursor(rightX - markerGW, y); hal_lcdPrint(">"); }
+        hal_lcdSetCursor(rightX, y); hal_lcdPrint(choices[idxR]);
     };
 
     drawRow(0, 2, row1Y);  // Time | Back
     drawRow(1, 3, row2Y);  // Save | Home
 }
 
-// ---------------------------------------------------------------------------
-// Public API
-// ---------------------------------------------------------------------------
+static void viewDiagnostics(const MenuView& v) {
+    headerBar(v.title);
+    if (!v.diag) return;
+    const DiagnosticsData& d = *v.diag;
 
-static void drawCurrentView(const MenuView& v) {
-    u8g2.clearBuffer();
+    char buf[40];   // longest line with every field at its widest
+    uint32_t s = d.uptimeSec;
+    uint8_t y = LINE_H_TITLE + LINE_H_SMALL;
+    hal_lcdSetFont(FONT_SMALL);
+
+    auto line = [&]() {
+        hal_lcdSetCursor(PAD, y);
+        hal_lcdPrint(buf);
+        y += LINE_H_SMALL;
+    };
+
+    snprintf(buf, sizeof(buf), "Up %lud %02u:%02u:%02u RAM %u",
+             (unsigned long)(s / 86400UL), (unsigned)(s / 3600UL % 24),
+             (unsigned)(s / 60UL % 60), (unsigned)(s % 60), (unsigned)d.ramMinFree);
+    line();
+    snprintf(buf, sizeof(buf), "Loop %u/s max %lu.%lums", (unsigned)d.loopsPerSec,
+             (unsigned long)(d.maxLoopUs / 1000), (unsigned long)(d.maxLoopUs / 100 % 10));
+    line();
+    snprintf(buf, sizeof(buf), "Frames %lu skip %lu",
+             (unsigned long)d.framesRendered, (unsigned long)d.framesSkipped);
+    line();
+    snprintf(buf, sizeof(buf), "EE wr %lu RTC err %u",
+             (unsigned long)d.eepromWrites, (unsigned)d.rtcFailures);
+    line();
+    snprintf(buf, sizeof(buf), "Wear slot %lu bmp %lu",
+             (unsigned long)d.slotWear, (unsigned long)d.bitmapWear);
+    line();
+    snprintf(buf, sizeof(buf), "Cycles %lu heat %u/%u%%", (unsigned long)d.tapCycles,
+             (unsigned)d.heatPercent[0], (unsigned)d.heatPercent[1]);
+    line();
+}
+
+// Self-benchmark results, one case per row; v.selected is the first row shown.
+static void viewBenchmark(const MenuView& v) {
+    constexpr uint8_t visibleRows = 6;
+    constexpr uint8_t cases       = (uint8_t)SelfBenchCase::Count;
+
+    char buf[28];
+    uint8_t done = self_bench_done();
+    if (self_bench_running()) {
+        snprintf(buf, sizeof(buf), "%s %u/%u", v.title, (unsigned)done, (unsigned)cases);
+        headerBar(buf);
+    } else {
+        headerBar(v.title);
+    }
+
+    uint8_t first = v.selected;
+    if (first > cases - visibleRows) first = cases - visibleRows;
+
+    uint8_t y = LINE_H_TITLE + LINE_H_SMALL;
+    hal_lcdSetFont(FONT_SMALL);
+    for (uint8_t i = first; i < first + visibleRows; ++i) {
+        char name[16];
+        strcpy_P(name, self_bench_name((SelfBenchCase)i));
+        hal_lcdSetCursor(PAD, y);
+        hal_lcdPrint(name);
+
+        if (i < done) {
+            uint32_t t = self_bench_tenthsUs((SelfBenchCase)i);
+            snprintf(buf, sizeof(buf), "%lu.%luus", (unsigned long)(t / 10), (unsigned long)(t % 10));
+        } else {
+            snprintf(buf, sizeof(buf), "-");
+        }
+        hal_lcdSetCursor(W - PAD - (int16_t)hal_lcdStrWidth(buf), y);
+        hal_lcdPrint(buf);
+        y += LINE_H_SMALL;
+    }
+}
+
+// Gems per bin as a sparkline, oldest on the left, scaled to the largest
+// bin; v.selected picks hourly (0) or daily (1) bins. Two summary lines
+// below cover the last 24 hours or 7 days.
+static void viewStats(const MenuView& v) {
+    constexpr uint8_t top    = LINE_H_TITLE + 4;
+    constexpr uint8_t bottom = 44;   // baseline row under the bars
+
+    bool    daily = v.selected == 1;
+    uint8_t bins  = daily ? kStatsDays : kStatsHours;
+    uint8_t pitch = daily ? 3 : 2;   // one pixel gap between bars
+    uint8_t span  = daily ? 7 : 24;  // bins in the summary
+
+    char buf[40];   // longest summary line with every field at its widest
+    snprintf(buf, sizeof(buf), "%s %s", v.title, daily ? "30d" : "48h");
+    headerBar(buf);
+
+    // Daily bins come from EEPROM, so each is read once.
+    uint16_t binGems[kStatsHours > kStatsDays ? kStatsHours : kStatsDays];
+    uint16_t maxGems = 1;
+    uint32_t gems = 0, cycles = 0, skipped = 0, busyS = 0;
+    for (uint8_t ago = 0; ago < bins; ++ago) {
+        StatsBin b = daily ? stats_day(ago) : stats_hour(ago);
+        binGems[ago] = b.gems;
+        if (b.gems > maxGems) maxGems = b.gems;
+        if (ago < span) {
+            gems    += b.gems;
+            cycles  += b.cycles;
+            skipped += b.skipped;
+            busyS   += b.busyS;
+        }
+    }
+
+    for (uint8_t ago = 0; ago < bins; ++ago) {
+        uint8_t h = (uint8_t)((uint32_t)binGems[ago] * (bottom - top) / maxGems);
+        if (binGems[ago] > 0 && h == 0) h = 1;
+        int16_t  x = (int16_t)(PAD + (bins - 1 - ago) * pitch);
+        for (uint8_t w = 0; w + 1 < pitch; ++w) hal_lcdVLine((int16_t)(x + w), bottom - h, h);
+    }
+    hal_lcdHLine(PAD, bottom, (uint16_t)(bins * pitch));
+
+    hal_lcdSetFont(FONT_SMALL);
+    snprintf(buf, sizeof(buf), "%u", (unsigned)maxGems);
+    hal_lcdSetCursor(W - PAD - (int16_t)hal_lcdStrWidth(buf), top + 6);
+    hal_lcdPrint(buf);
+
+    uint32_t meanDs = cycles ? busyS * 10 / cycles : 0;
+    snprintf(buf, sizeof(buf), "%s %lu gems %lu cyc", daily ? "7d" : "24h",
+             (unsigned long)gems, (unsigned long)cycles);
+    hal_lcdSetCursor(PAD, H - LINE_H_SMALL - 1);
+    hal_lcdPrint(buf);
+    snprintf(buf, sizeof(buf), "skip %lu  cycle %lu.%lus", (unsigned long)skipped,
+             (unsigned long)(meanDs / 10), (unsigned long)(meanDs % 10));
+    hal_lcdSetCursor(PAD, H - 1);
+    hal_lcdPrint(buf);
+}
+
+static void composeView(const MenuView& v) {
+    hal_lcdClear();
     switch (v.kind) {
         case ViewKind::Home:       viewHome(v);       break;
         case ViewKind::List:       viewList(v);       break;
         case ViewKind::EditNumber: viewEditNumber(v); break;
         case ViewKind::EditTime:   viewEditTime(v);   break;
+        case ViewKind::Diagnostics: viewDiagnostics(v); break;
+        case ViewKind::Benchmark:  viewBenchmark(v);  break;
+        case ViewKind::Stats:      viewStats(v);      break;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+// Input held back by the limiter or the LCD start-up is timed to the frame
+// that finally shows it.
+static void noteInput(const MenuView& v) {
+    if (!v.hasInput || s_inputPending) return;
+    s_inputPending = true;
+    s_inputUs      = v.inputUs;
+}
+
+static void drawCurrentView(const MenuView& v) {
+    LOOP_SECTION(DrawView);
+    composeView(v);
+    LOOP_SECTION(LcdSend);
+    hal_lcdSend();
+    lcd_mirror_frameSent();
+    if (s_inputPending) {
+        ui_latency_record(hal_micros() - s_inputUs);
+        s_inputPending = false;
     }
-    u8g2.sendBuffer();
+    s_framesRendered++;
+    s_skipCounted = false;
+}
+
+uint32_t display_framesRendered() {
+    return s_framesRendered;
+}
+
+uint32_t display_framesSkipped() {
+    return s_framesSkipped;
+}
+
+// Starts the LCD on the first call and reports false, so the first frame
+// goes out on the following loop() pass.
+static bool lcdStarted() {
+    if (s_lcdStarted) return true;
+    hal_lcdBegin();
+    s_lcdStarted = true;
+    boot_timing_mark(BootPhase::LcdInit);
+    return false;
 }
 
 void display_begin() {
-    u8g2.setBusClock(2000000);  // 2 MHz — ST7920 is rated for 2.5 MHz max.
-                                 // Cuts software-SPI transfer time ~4x vs default.
-    u8g2.begin();
-    u8g2.clearBuffer();
-    headerBar("Boot");
-    drawLabelAt(PAD, LINE_H_TITLE + LINE_H_BODY, "Starting...");
-    u8g2.sendBuffer();
-    lcdDirty    = true;
-    nextFrameMs = 0;
+    lcdDirty  = true;
+    nextFrame = Deadline();
+}
+
+void display_compose(const MenuView& v) {
+    composeView(v);
 }
 
 void display_markDirty() {
@@ -427,18 +583,28 @@ void display_renderNow(const MenuView& v) {
     // Bypass the frame-rate limiter entirely. Used after input events so
     // the user sees the response immediately without waiting for the next
     // rate-limited window. Resets the limiter so we don't double-draw.
+    noteInput(v);
+    if (!lcdStarted()) return;
     drawCurrentView(v);
-    lcdDirty    = false;
-    nextFrameMs = millis() + kFramePeriodMs;
+    lcdDirty  = false;
+    nextFrame = deadline_in(mono_nowMs(), kFramePeriodMs);
 }
 
 void display_render(const MenuView& v) {
     // Rate-limited path for auto-updates (countdown tick, gem count, etc.).
     // Skips the draw if nothing changed or the limiter hasn't elapsed yet.
-    uint32_t now = millis();
-    if (!lcdDirty || now < nextFrameMs) return;
+    MonoMs now = mono_nowMs();
+    noteInput(v);
+    if (!lcdDirty) return;
+    if (!deadline_reached(nextFrame, now)) {
+        // Count each held-back frame once, not every loop it waits.
+        if (!s_skipCounted) s_framesSkipped++;
+        s_skipCounted = true;
+        return;
+    }
 
+    if (!lcdStarted()) return;
     drawCurrentView(v);
-    lcdDirty    = false;
-    nextFrameMs = now + kFramePeriodMs;
+    lcdDirty  = false;
+    nextFrame = deadline_in(now, kFramePeriodMs);
 }
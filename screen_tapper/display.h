@@ -2,7 +2,8 @@
 #include <stdint.h>
 #include "menu.h"
 
-// Initialize the 128×64 LCD renderer.
+// Initialize the 128×64 LCD renderer. The controller itself is started by
+// the first render call, which draws nothing; the next one sends a frame.
 void display_begin();
 
 // Mark the display as needing a redraw.
@@ -15,3 +16,10 @@ void display_renderNow(const MenuView& v);
 // Render the current MenuView, rate-limited to kFramePeriodMs.
 // Safe to call every loop(). Use for auto-updates (countdown, gem count).
 void display_render(const MenuView& v);
+
+// Lay out v in the frame buffer without sending it (self-benchmark).
+void display_compose(const MenuView& v);
+
+// Frames drawn since boot, and dirty frames the rate limiter delayed.
+uint32_t display_framesRendered();
+uint32_t display_framesSkipped();
@@ -0,0 +1,169 @@
+#include "eeprom_queue.h"
+#include "config.h"
+#include "hal.h"
+#include <Arduino.h>
+
+static_assert((kEepromQueueSize & (kEepromQueueSize - 1)) == 0,
+              "kEepromQueueSize must be a power of two");
+
+static constexpr uint8_t kMask = kEepromQueueSize - 1;
+
+struct PendingWrite {
+    uint16_t addr;
+    uint8_t  value;
+};
+
+// Ring buffer shared with the EE_READY interrupt. The main loop only moves
+// s_head; the interrupt only moves s_tail, except that
+// eeprom_queue_write_first() steps it back with interrupts off.
+static PendingWrite     s_queue[kEepromQueueSize];
+static volatile uint8_t s_head = 0;
+static volatile uint8_t s_tail = 0;
+
+static volatile uint32_t s_programmed = 0;   // bytes actually written
+
+// ---------------------------------------------------------------------------
+// Interrupt service
+// ---------------------------------------------------------------------------
+
+// Programs the next queued byte that actually differs from the EEPROM, then
+// returns; the next EE_READY interrupt arrives when that write completes.
+// Disables the interrupt once drained. Call with interrupts disabled and no
+// write in progress.
+static void serviceQueue() {
+    while (s_tail != s_head) {
+        const PendingWrite& w = s_queue[s_tail];
+        uint8_t current = hal_eepromRead(w.addr);
+        uint8_t value   = w.value;
+        uint16_t addr   = w.addr;
+        s_tail = (uint8_t)((s_tail + 1) & kMask);
+
+        if (current != value) {
+            s_programmed++;
+            hal_eepromProgram(addr, current, value);
+            return;
+        }
+    }
+    hal_eepromReadyIrq(false);
+}
+
+// The EEPROM-ready interrupt fires whenever it is enabled and no write is
+// in progress.
+void eeprom_queue_onReady() {
+    serviceQueue();
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+void eeprom_queue_begin() {
+    uint8_t sreg = SREG;
+    cli();
+    s_head = 0;
+    s_tail = 0;
+    hal_eepromReadyIrq(false);
+    SREG = sreg;
+}
+
+uint16_t eeprom_queue_length() {
+    return hal_eepromSize();
+}
+
+uint8_t eeprom_queue_read(uint16_t addr) {
+    for (;;) {
+        uint8_t sreg = SREG;
+        cli();
+
+        // Newest queued value wins.
+        uint8_t i = s_head;
+        while (i != s_tail) {
+            i = (uint8_t)((i - 1) & kMask);
+            if (s_queue[i].addr == addr) {
+                uint8_t v = s_queue[i].value;
+                SREG = sreg;
+                return v;
+            }
+        }
+
+        // The hardware can only be read between writes. Wait with interrupts
+        // enabled so millis() keeps ticking during a 3.4 ms write.
+        if (!hal_eepromBusy()) {
+            uint8_t v = hal_eepromRead(addr);
+            SREG = sreg;
+            return v;
+        }
+        SREG = sreg;
+    }
+}
+
+void eeprom_queue_write(uint16_t addr, uint8_t value) {
+    for (;;) {
+        uint8_t sreg = SREG;
+        cli();
+        uint8_t next = (uint8_t)((s_head + 1) & kMask);
+        if (next != s_tail) {
+            s_queue[s_head].addr  = addr;
+            s_queue[s_head].value = value;
+            s_head = next;
+            hal_eepromReadyIrq(true);
+            SREG = sreg;
+            return;
+        }
+        // Full: free a slot ourselves once the current write finishes, so
+        // this also works when called with interrupts disabled.
+        if (!hal_eepromBusy()) serviceQueue();
+        SREG = sreg;
+    }
+}
+
+void eeprom_queue_write_first(uint16_t addr, uint8_t value) {
+    for (;;) {
+        uint8_t sreg = SREG;
+        cli();
+        uint8_t prev = (uint8_t)((s_tail - 1) & kMask);
+        if (prev != s_head) {
+            for (uint8_t i = s_tail; i != s_head; i = (uint8_t)((i + 1) & kMask)) {
+                if (s_queue[i].addr == addr) s_queue[i].value = value;
+            }
+            s_queue[prev].addr  = addr;
+            s_queue[prev].value = value;
+            s_tail = prev;
+            hal_eepromReadyIrq(true);
+            SREG = sreg;
+            return;
+        }
+        if (!hal_eepromBusy()) serviceQueue();
+        SREG = sreg;
+    }
+}
+
+void eeprom_queue_flush() {
+    // Services the queue directly rather than waiting on EE_READY, so it is
+    // safe to call from an interrupt handler (e.g. on power failure).
+    for (;;) {
+        uint8_t sreg = SREG;
+        cli();
+        bool busy = hal_eepromBusy();
+        bool done = !busy && s_head == s_tail;
+        if (!busy && !done) serviceQueue();
+        SREG = sreg;
+        if (done) return;
+    }
+}
+
+uint32_t eeprom_queue_writes() {
+    uint8_t sreg = SREG;
+    cli();
+    uint32_t n = s_programmed;
+    SREG = sreg;
+    return n;
+}
+
+uint8_t eeprom_queue_pending() {
+    uint8_t sreg = SREG;
+    cli();
+    uint8_t n = (uint8_t)((s_head - s_tail) & kMask);
+    SREG = sreg;
+    return n;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <stdint.h>
+
+// =============================================================================
+// Background EEPROM writer
+//
+// Byte writes are queued in RAM and programmed one at a time from the
+// EE_READY interrupt, so callers return immediately instead of stalling
+// ~3.4 ms per byte. Writes are applied strictly in the order they were
+// queued: a journal that queues its payload before its index can never
+// expose the index first.
+//
+// Once the queue is running, every EEPROM access must go through this module.
+// A direct EEPROM.read() can collide with a write the interrupt has in flight.
+// =============================================================================
+
+// Reset the queue. Call once in setup() before any other EEPROM access.
+void eeprom_queue_begin();
+
+// Size of the EEPROM in bytes.
+uint16_t eeprom_queue_length();
+
+// Read one byte. If a write to addr is still queued, its value is returned
+// so readers always see the newest data.
+uint8_t eeprom_queue_read(uint16_t addr);
+
+// Queue a one-byte write and return. Only waits if the queue is full.
+// A cell that already holds the value is skipped when serviced, like
+// EEPROM.update(). Writes that only clear bits (or only set them) use the
+// faster write-only (erase-only) mode, so bit-clearing counters are cheap.
+void eeprom_queue_write(uint16_t addr, uint8_t value);
+
+// Queue a one-byte write ahead of every other queued write, for data that
+// must land first when time is short (the power-fail record). Queued writes
+// to the same address take the new value, so they cannot undo it later.
+void eeprom_queue_write_first(uint16_t addr, uint8_t value);
+
+// Block until every queued write has been programmed. Use on shutdown paths
+// (power loss, reset) where pending data must reach the EEPROM. Safe to call
+// with interrupts disabled.
+void eeprom_queue_flush();
+
+// Number of writes still waiting to be programmed.
+uint8_t eeprom_queue_pending();
+
+// Bytes programmed since boot. Skipped writes (cell already held the
+// value) are not counted.
+uint32_t eeprom_queue_writes();
+
+// Called from the HAL's EEPROM-ready interrupt; not for application use.
+void eeprom_queue_onReady();
+
+// Multi-byte helpers mirroring EEPROM.get() / EEPROM.put().
+template <typename T>
+T& eeprom_queue_get(uint16_t addr, T& t) {
+    uint8_t* p = (uint8_t*)&t;
+    for (uint16_t i = 0; i < sizeof(T); ++i) p[i] = eeprom_queue_read(addr + i);
+    return t;
+}
+
+template <typename T>
+const T& eeprom_queue_put(uint16_t addr, const T& t) {
+    const uint8_t* p = (const uint8_t*)&t;
+    for (uint16_t i = 0; i < sizeof(T); ++i) eeprom_queue_write(addr + i, p[i]);
+    return t;
+}
@@ -1,9 +1,15 @@
 #include "encoder.h"
 #include "config.h"
+#include "hal.h"
+#include "mono_time.h"
+
+#ifdef DEBUG
+#include "console.h"
 #include <Arduino.h>
+#endif
 
 // Debounce window for the push switch
-static constexpr unsigned long SW_DEBOUNCE_MS = 30;
+static constexpr uint32_t SW_DEBOUNCE_MS = 30;
 
 // Pin storage
 static uint8_t s_clk = 0xFF;
@@ -11,11 +17,13 @@ static uint8_t s_dt  = 0xFF;
 static uint8_t s_sw  = 0xFF;
 
 // Rotation detection
-static uint8_t s_lastClk = HIGH;
+static bool s_lastClk = true;
 
 // Switch debounce state (active LOW)
-static unsigned long s_swLastChangeMs = 0;
-static uint8_t       s_swLastStable   = HIGH;
+static Deadline s_swSettled;            // next change accepted from here
+static bool     s_swLastStable = true;
+
+static uint32_t s_lastPollUs = 0;
 
 #ifdef DEBUG
 static long s_debugCount = 0;
@@ -26,34 +34,36 @@ void encoder_begin(uint8_t clkPin, uint8_t dtPin, uint8_t swPin) {
     s_dt  = dtPin;
     s_sw  = swPin;
 
-    pinMode(s_clk, INPUT_PULLUP);
-    pinMode(s_dt,  INPUT_PULLUP);
-    pinMode(s_sw,  INPUT_PULLUP);
+    hal_pinInputPullup(s_clk);
+    hal_pinInputPullup(s_dt);
+    hal_pinInputPullup(s_sw);
 
-    s_lastClk      = digitalRead(s_clk);
-    s_swLastStable = digitalRead(s_sw);
-    s_swLastChangeMs = millis();
+    s_lastClk      = hal_pinRead(s_clk);
+    s_swLastStable = hal_pinRead(s_sw);
+    s_swSettled    = deadline_in(mono_nowMs(), SW_DEBOUNCE_MS);
+    s_lastPollUs   = hal_micros();
 
 #ifdef DEBUG
     s_debugCount = 0;
-    Serial.println(F("[ENC] begin"));
-    Serial.print(F("[ENC] pins: CLK=")); Serial.print(s_clk);
-    Serial.print(F(" DT="));             Serial.print(s_dt);
-    Serial.print(F(" SW="));             Serial.println(s_sw);
-    Serial.print(F("[ENC] init CLK="));  Serial.print(s_lastClk);
-    Serial.print(F(" DT="));             Serial.println(digitalRead(s_dt));
-    Serial.println(F("[ENC] debug counter reset to 0"));
+    console_printf(PSTR("[ENC] begin pins: CLK=%u DT=%u SW=%u"),
+                   (unsigned)s_clk, (unsigned)s_dt, (unsigned)s_sw);
+    console_printf(PSTR("[ENC] init CLK=%u DT=%u, count 0"),
+                   (unsigned)s_lastClk, (unsigned)hal_pinRead(s_dt));
 #endif
 }
 
 EncoderEvents encoder_poll() {
+    // The pins have no pin-change interrupt on the Mega, so an edge is only
+    // known to lie between the previous poll and this one.
     EncoderEvents ev;
-    unsigned long now = millis();
+    ev.atUs      = s_lastPollUs;
+    s_lastPollUs = hal_micros();
+    MonoMs now   = mono_nowMs();
 
     // Rotation: report one step per falling edge of CLK
-    uint8_t clkNow = digitalRead(s_clk);
-    if (clkNow != s_lastClk && clkNow == LOW) {
-        uint8_t dtNow = digitalRead(s_dt);
+    bool clkNow = hal_pinRead(s_clk);
+    if (clkNow != s_lastClk && !clkNow) {
+        bool dtNow = hal_pinRead(s_dt);
         int8_t step = (dtNow != clkNow) ? +1 : -1;
         // If direction feels reversed on your hardware, flip the sign:
         // step = -step;
@@ -61,23 +71,20 @@ EncoderEvents encoder_poll() {
 
 #ifdef DEBUG
         s_debugCount += step;
-        Serial.print(F("[ENC] STEP "));
-        Serial.print((step > 0) ? F("CW ") : F("CCW "));
-        Serial.print(F("clk=")); Serial.print(clkNow);
-        Serial.print(F(" dt="));  Serial.print(dtNow);
-        Serial.print(F("  count=")); Serial.println(s_debugCount);
+        console_printf(PSTR("[ENC] STEP %s clk=%u dt=%u  count=%ld"),
+                       step > 0 ? "CW" : "CCW", (unsigned)clkNow, (unsigned)dtNow, s_debugCount);
 #endif
     }
     s_lastClk = clkNow;
 
     // Press: debounced falling edge detection
-    uint8_t swNow = digitalRead(s_sw);
-    if (swNow != s_swLastStable && (now - s_swLastChangeMs) >= SW_DEBOUNCE_MS) {
-        s_swLastChangeMs = now;
-        if (swNow == LOW) {
+    bool swNow = hal_pinRead(s_sw);
+    if (swNow != s_swLastStable && deadline_reached(s_swSettled, now)) {
+        s_swSettled = deadline_in(now, SW_DEBOUNCE_MS);
+        if (!swNow) {
             ev.pressed = true;
 #ifdef DEBUG
-            Serial.println(F("[ENC] PRESS"));
+            console_printf(PSTR("[ENC] PRESS"));
 #endif
         }
         s_swLastStable = swNow;
@@ -2,8 +2,10 @@
 #include <stdint.h>
 
 struct EncoderEvents {
-    int8_t delta   = 0;      // signed detent count since last poll (CW = positive)
-    bool   pressed = false;  // true exactly once on the switch press (falling edge)
+    int8_t   delta   = 0;      // signed detent count since last poll (CW = positive)
+    bool     pressed = false;  // true exactly once on the switch press (falling edge)
+    uint32_t atUs    = 0;      // hal_micros() of the previous poll: the earliest an edge
+                               // reported here can have happened
 };
 
 void          encoder_begin(uint8_t clkPin, uint8_t dtPin, uint8_t swPin);
@@ -0,0 +1,138 @@
+#include "event_log.h"
+#include "config.h"
+#include "sd_logger.h"
+#include "serial_frame.h"
+#include "hal.h"
+#include <Arduino.h>
+
+static_assert((kEventLogSize & (kEventLogSize - 1)) == 0,
+              "kEventLogSize must be a power of two");
+static_assert(sizeof(EventRecord) == 8, "record layout is a wire format");
+
+// =============================================================================
+// Dump frames (see serial_frame.h)
+//
+// type 'H'  header:  u16 records dropped since last dump, u8 record count
+// type 'R'  records: u32 baseMs, then up to RECORDS_PER_FRAME EventRecords
+// type 'T'  trailer: empty
+//
+// baseMs is the time the frame's first dtMs is relative to, so every frame
+// decodes on its own even if the ring overflows mid-dump. Records are removed
+// from the ring as they are sent, so consecutive dumps never repeat.
+// =============================================================================
+
+static constexpr uint8_t RECORDS_PER_FRAME = 4;
+static constexpr uint8_t FRAME_OVERHEAD    = SERIAL_FRAME_OVERHEAD;
+static constexpr uint8_t RECORD_FRAME_MAX  = 4 + RECORDS_PER_FRAME * sizeof(EventRecord);
+static constexpr uint8_t kMask             = kEventLogSize - 1;
+
+static EventRecord s_ring[kEventLogSize];
+static uint8_t  s_head    = 0;   // next slot to write
+static uint8_t  s_count   = 0;
+static uint32_t s_lastMs  = 0;   // timestamp of the newest record
+static uint32_t s_baseMs  = 0;   // timestamp the oldest record's dtMs is relative to
+static uint16_t s_dropped = 0;
+
+enum class DumpState : uint8_t { Idle, Header, Records, Trailer };
+static DumpState s_dump     = DumpState::Idle;
+static uint8_t   s_dumpLeft = 0;
+
+// ---------------------------------------------------------------------------
+// Ring helpers
+// ---------------------------------------------------------------------------
+
+static uint8_t tailIndex() {
+    return (uint8_t)((s_head - s_count) & kMask);
+}
+
+// Drops the oldest record, carrying its timestamp into s_baseMs.
+static void popOldest(EventRecord& out) {
+    out = s_ring[tailIndex()];
+    s_count--;
+    if (out.type == EventType::TimeSync) s_baseMs = out.a32;
+    else                                 s_baseMs += out.dtMs;
+}
+
+static void push(EventType type, uint8_t a8, uint16_t dtMs, uint32_t a32) {
+    if (s_count == kEventLogSize) {
+        EventRecord dropped;
+        popOldest(dropped);
+        if (s_dumpLeft > 0) s_dumpLeft--;
+        if (s_dropped < 0xFFFF) s_dropped++;
+    }
+    EventRecord& r = s_ring[s_head];
+    r.type = type;
+    r.a8   = a8;
+    r.dtMs = dtMs;
+    r.a32  = a32;
+    s_head = (uint8_t)((s_head + 1) & kMask);
+    s_count++;
+    sd_logger_append(r, s_lastMs);
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+void event_log_add(EventType type, uint8_t a8, uint32_t a32) {
+    uint8_t sreg = SREG;
+    cli();
+    uint32_t now = hal_millis();
+    uint32_t dt  = now - s_lastMs;
+    if (dt > 0xFFFF) {
+        push(EventType::TimeSync, 0, 0, now);
+        s_lastMs = now;
+        dt = 0;
+    }
+    push(type, a8, (uint16_t)dt, a32);
+    s_lastMs = now;
+    SREG = sreg;
+}
+
+void event_log_requestDump() {
+    if (s_dump != DumpState::Idle) return;
+    s_dump = DumpState::Header;
+}
+
+void event_log_service() {
+    while (s_dump != DumpState::Idle) {
+        int room = hal_serialWriteRoom();
+
+        if (s_dump == DumpState::Header) {
+            if (room < FRAME_OVERHEAD + 3) return;
+            uint8_t p[3];
+            uint8_t sreg = SREG;
+            cli();
+            s_dumpLeft = s_count;
+            memcpy(p, &s_dropped, 2);
+            p[2] = s_dumpLeft;
+            s_dropped = 0;
+            SREG = sreg;
+            serial_frame_send('H', p, sizeof(p));
+            s_dump = DumpState::Records;
+        } else if (s_dump == DumpState::Records) {
+            if (s_dumpLeft == 0) {
+                s_dump = DumpState::Trailer;
+                continue;
+            }
+            if (room < FRAME_OVERHEAD + RECORD_FRAME_MAX) return;
+            uint8_t p[RECORD_FRAME_MAX];
+            uint8_t sreg = SREG;
+            cli();
+            uint8_t n = s_dumpLeft < RECORDS_PER_FRAME ? s_dumpLeft : RECORDS_PER_FRAME;
+            memcpy(p, &s_baseMs, 4);
+            for (uint8_t i = 0; i < n; ++i) {
+                EventRecord r;
+                popOldest(r);
+                memcpy(p + 4 + i * sizeof(EventRecord), &r, sizeof(r));
+            }
+            s_dumpLeft -= n;
+            SREG = sreg;
+            if (n > 0) serial_frame_send('R', p, (uint8_t)(4 + n * sizeof(EventRecord)));
+        } else {
+            if (room < FRAME_OVERHEAD) return;
+            serial_frame_send('T', nullptr, 0);
+            s_dump = DumpState::Idle;
+        }
+    }
+}
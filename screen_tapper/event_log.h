@@ -0,0 +1,45 @@
+#pragma once
+#include <stdint.h>
+
+// Compact binary event log. Records are appended to a RAM ring from the hot
+// path in a few cycles and streamed out on request as CRC-framed binary, a
+// few frames per loop() so the dump never blocks. tools/event_log_decode.py
+// turns a capture into CSV.
+
+enum class EventType : uint8_t {
+    TimeSync    = 0,  // a32 = absolute millis(); later deltas are relative to it
+    CycleStart  = 1,  // a8 = ad-gem taps, a32 = float-gem taps
+    TapPulse    = 2,  // a8 = channel (0 = ad, 1 = float), a32 = measured on-time (us)
+    CycleEnd    = 3,  // a8 = peak thermal budget used (%), a32 = cycle duration (ms)
+    Wake        = 4,
+    Sleep       = 5,
+    MenuCommit  = 6,  // a8 = MenuActionType, a32 = u32 (gem count) or u16a | u16b << 16
+    EepromFlush = 7,  // a8 = source (EventFlushSource), a32 = value committed
+    LoopOverrun = 8,  // a32 = loop duration (us)
+    Reset       = 9,  // a8 = ResetCause, a32 = LoopSection a watchdog reset interrupted
+};
+
+enum EventFlushSource : uint8_t {
+    kFlushGems     = 0,
+    kFlushGemBase  = 1,
+    kFlushSettings = 2,
+};
+
+// 8 bytes on the wire and in RAM, little-endian.
+struct EventRecord {
+    EventType type;
+    uint8_t   a8;
+    uint16_t  dtMs;   // ms since the previous record
+    uint32_t  a32;
+};
+
+// Append a record. Overwrites the oldest record when the ring is full.
+// Safe to call from interrupt handlers.
+void event_log_add(EventType type, uint8_t a8 = 0, uint32_t a32 = 0);
+
+// Start streaming the buffered records. Ignored while a dump is running.
+void event_log_requestDump();
+
+// Emit pending dump frames while the serial TX buffer has room.
+// Call once per loop().
+void event_log_service();
@@ -0,0 +1,24 @@
+// Purpose: number formatting for the LCD views.
+
+#include "format.h"
+#include <stdio.h>
+#include <string.h>
+
+void fmt_commas(uint32_t v, char* out, size_t outSz) {
+    char t[16];
+    snprintf(t, sizeof(t), "%lu", (unsigned long)v);
+    int len = strlen(t), j = 0;
+    for (int i = 0; i < len && j < (int)outSz - 1; ++i) {
+        out[j++] = t[i];
+        if (((len - i - 1) % 3) == 0 && i != len - 1 && j < (int)outSz - 1)
+            out[j++] = ',';
+    }
+    out[j] = '\0';
+}
+
+void fmt_mm_ss(uint32_t ms, char* out, size_t outSz) {
+    uint32_t s  = ms / 1000UL;
+    uint32_t mm = s / 60UL;
+    uint32_t ss = s % 60UL;
+    snprintf(out, outSz, "%02lu:%02lu", (unsigned long)mm, (unsigned long)ss);
+}
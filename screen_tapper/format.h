@@ -0,0 +1,13 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Number formatting shared by the LCD views and the host benchmarks.
+// Both always NUL-terminate and truncate to outSz.
+
+// 1234567 -> "1,234,567"
+void fmt_commas(uint32_t v, char* out, size_t outSz);
+
+// Milliseconds as minutes and seconds: 125000 -> "02:05". Minutes are not
+// wrapped at 60.
+void fmt_mm_ss(uint32_t ms, char* out, size_t outSz);
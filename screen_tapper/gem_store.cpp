@@ -1,36 +1,93 @@
 #include "gem_store.h"
 #include "config.h"
+#include "eeprom_queue.h"
+#include "event_log.h"
 #include <Arduino.h>
-#include <EEPROM.h>
 
 // =============================================================================
-// EEPROM Layout
-// [0..1]   uint16_t  index of last-written slot
-// [2..255] reserved for future settings
-// [256..]  ring buffer of slots, each 5 bytes:
-//            [0..3] uint32_t lifetime gem count
-//            [4]    uint8_t  XOR checksum of the 4 data bytes
+// EEPROM Layout (layout version 2)
+// [0..1]       legacy slot index (layout 1 only; read once during migration)
+// [2..250]     settings region (see settings_store.h)
+// [251..252]   uint8_t   session gems saved on power failure, then its
+//                        complement; 0xFF 0xFF when nothing is pending
+// [253..254]   uint16_t  index of last-written base slot
+// [255]        uint8_t   layout version; any other value means layout 1
+// [256..319]   increment bitmap A (owned by even base slots)
+// [320..383]   increment bitmap B (owned by odd base slots)
+// [384..3583]  ring buffer of base slots, each 5 bytes:
+//                [0..3] uint32_t base lifetime gem count
+//                [4]    uint8_t  XOR checksum of the 4 data bytes
+// [3584..3943] daily yield statistics (see stats.cpp)
+// [3944..]     reserved for future use; [4095] is the self-benchmark's
+//              scratch byte (kSelfBenchEepromAddr)
+//
+// Lifetime = base + kGemUnit * (cleared bits in the base slot's bitmap)
+//
+// A flush clears the next few bitmap bits. Clearing bits needs no erase, so
+// the EEPROM write queue programs it in write-only mode: ~1.8 ms and no wear.
+// When the bitmap is exhausted (or the count is overwritten) the total is
+// rebased: the other bitmap is erased, then a new base slot and the index are
+// written. The queue applies these in order, so a torn rebase leaves the
+// previous base and its untouched bitmap as a valid fallback.
+//
+// Layout 1 kept the index at [0..1] and 5-byte slots from 256 to the end of
+// the EEPROM. gem_store_begin() migrates it by writing a fresh base slot that
+// does not overlap the live legacy slot, then the new index, then erasing that
+// slot's bitmap, then the layout byte. Cut off before the index, it reruns on
+// the next boot; cut off after, the next boot finishes from the new base.
+//
+// Gems below the flush threshold live only in RAM. When the power monitor
+// sees the supply failing it calls gem_store_commit_on_power_fail(), which
+// saves them to the two-byte pending record; the next boot adds them back to
+// the session and erases the record.
 // =============================================================================
 
-static constexpr uint16_t SLOT_INDEX_ADDR = 0;
-static constexpr uint16_t GEM_SLOTS_START = 256;
+static constexpr uint16_t LEGACY_INDEX_ADDR   = 0;
+static constexpr uint16_t PENDING_ADDR        = 251;
+static constexpr uint16_t SLOT_INDEX_ADDR     = 253;
+static constexpr uint16_t LAYOUT_VERSION_ADDR = 255;
+static constexpr uint8_t  LAYOUT_VERSION      = 2;
+
+static constexpr uint16_t BITMAP_A_START = 256;
+static constexpr uint16_t BITMAP_BYTES   = 64;
+static constexpr uint16_t BITMAP_BITS    = BITMAP_BYTES * 8;
+
+static constexpr uint16_t GEM_SLOTS_START = BITMAP_A_START + 2 * BITMAP_BYTES;
+static constexpr uint16_t GEM_SLOTS_END   = 3584;
 static constexpr uint8_t  BYTES_PER_SLOT  = 5;
 
+static constexpr uint16_t LEGACY_SLOTS_START = 256;
+
 // Session state (not persisted)
-static uint32_t s_lifetimeGems = 0;
+static uint32_t s_lifetimeGems = 0;   // base + committed bitmap units
 static uint32_t s_sessionGems  = 0;
 
+// Set while the main loop is flushing or rebasing, so the power-fail
+// interrupt does not commit a half-updated mirror. Adding to the session
+// count is done with interrupts off instead, so a power failure between
+// flushes always finds a count it can save.
+static volatile bool s_busy = false;
+
+// Mirror of the persisted counter, so a flush never has to read back a
+// value that may still be sitting in the write queue.
+static uint16_t s_lastSlot   = 0;
+static uint16_t s_bitsUsed   = 0;     // cleared bits in the active bitmap
+static uint8_t  s_bitCursor  = 0;     // first bitmap byte with a set bit left
+
 // ---------------------------------------------------------------------------
 // Internal helpers
 // ---------------------------------------------------------------------------
 
-static uint16_t usableBytes() {
-    uint16_t len = EEPROM.length();
-    return (len > GEM_SLOTS_START) ? (len - GEM_SLOTS_START) : 0;
+static uint16_t slotRegionEnd() {
+    uint16_t len = eeprom_queue_length();
+    return (len < GEM_SLOTS_END) ? len : GEM_SLOTS_END;
 }
 
+// Always even, so the bitmap owner (slot parity) alternates across the wrap.
 static uint16_t maxSlots() {
-    return usableBytes() / BYTES_PER_SLOT;
+    uint16_t end = slotRegionEnd();
+    if (end <= GEM_SLOTS_START) return 0;
+    return (uint16_t)(((end - GEM_SLOTS_START) / BYTES_PER_SLOT) & ~1u);
 }
 
 static uint8_t checksum32(uint32_t v) {
@@ -41,56 +98,215 @@ static uint16_t slotAddr(uint16_t slotIdx) {
     return (uint16_t)(GEM_SLOTS_START + slotIdx * BYTES_PER_SLOT);
 }
 
-static uint16_t sanitizeSlotIndex(uint16_t idx) {
-    uint16_t m = maxSlots();
+static uint16_t bitmapAddr(uint16_t slotIdx) {
+    return (uint16_t)(BITMAP_A_START + (slotIdx & 1u) * BITMAP_BYTES);
+}
+
+static uint16_t sanitizeSlotIndex(uint16_t idx, uint16_t m) {
     if (m == 0 || idx == 0xFFFF || idx >= m) return 0;
     return idx;
 }
 
-static uint32_t readLifetimeFromEEPROM() {
+static uint8_t clearedBits(uint8_t b) {
+    uint8_t n = 0;
+    for (uint8_t v = (uint8_t)~b; v; v &= (uint8_t)(v - 1)) n++;
+    return n;
+}
+
+// Reads the 4-byte value at addr and validates it against the checksum byte.
+// A checksum byte of 0xFF is accepted, as it always has been.
+static bool readSlotValue(uint16_t addr, uint32_t& value) {
+    eeprom_queue_get(addr, value);
+    uint8_t chk = eeprom_queue_read(addr + BYTES_PER_SLOT - 1);
+    if (value == 0xFFFFFFFFUL) {  // blank/unwritten slot
+        value = 0;
+        return true;
+    }
+    return chk == 0xFF || chk == checksum32(value);
+}
+
+// Resolves the live base slot: the indexed slot, or the previous one if the
+// indexed slot fails its checksum. Returns false if neither is valid.
+static bool readBase(uint16_t indexed, uint16_t& slot, uint32_t& base) {
     uint16_t m = maxSlots();
+    if (readSlotValue(slotAddr(indexed), base)) {
+        slot = indexed;
+        return true;
+    }
+    uint16_t prev = (uint16_t)((indexed + m - 1) % m);
+    if (readSlotValue(slotAddr(prev), base)) {
+        slot = prev;
+        return true;
+    }
+    return false;
+}
+
+// Loads the bitmap owned by s_lastSlot into the RAM mirror.
+static void scanBitmap() {
+    uint16_t addr = bitmapAddr(s_lastSlot);
+    s_bitsUsed  = 0;
+    s_bitCursor = BITMAP_BYTES;
+    for (uint8_t i = 0; i < BITMAP_BYTES; ++i) {
+        uint8_t b = eeprom_queue_read(addr + i);
+        s_bitsUsed += clearedBits(b);
+        if (b != 0x00 && s_bitCursor == BITMAP_BYTES) s_bitCursor = i;
+    }
+}
+
+// Queues an erase of every bitmap byte that is not already erased.
+static void eraseBitmap(uint16_t bmp) {
+    for (uint8_t i = 0; i < BITMAP_BYTES; ++i) {
+        if (eeprom_queue_read(bmp + i) != 0xFF) eeprom_queue_write(bmp + i, 0xFF);
+    }
+}
+
+// Writes `base` to `slot`, then points the index at it and resets the mirror.
+// The caller makes sure the slot's bitmap is erased before anything is
+// counted into it.
+static void putBase(uint16_t slot, uint32_t base) {
+    uint16_t addr = slotAddr(slot);
+    eeprom_queue_put(addr, base);
+    uint8_t chk = checksum32(base);
+    eeprom_queue_put((uint16_t)(addr + BYTES_PER_SLOT - 1), chk);
+    eeprom_queue_put(SLOT_INDEX_ADDR, slot);
+
+    s_lastSlot     = slot;
+    s_bitsUsed     = 0;
+    s_bitCursor    = 0;
+    s_lifetimeGems = base;
+    event_log_add(EventType::EepromFlush, kFlushGemBase, base);
+}
+
+// Starts a new counter generation at `base`: erase the next slot's bitmap,
+// write the slot, then point the index at it.
+static void writeBase(uint32_t base) {
+    uint16_t m = maxSlots();
+    if (m == 0) return;
+
+    uint16_t nextSlot = (uint16_t)((s_lastSlot + 1) % m);
+
+    // Usually a no-op: housekeeping erases the bitmap ahead of time
+    // (gem_store_prepare_rebase()), so active hours don't fill the queue.
+    eraseBitmap(bitmapAddr(nextSlot));
+    putBase(nextSlot, base);
+}
+
+// Clears the next `units` set bits of the active bitmap, lowest bit first.
+static void clearBitmapBits(uint16_t units) {
+    uint16_t addr = bitmapAddr(s_lastSlot);
+    while (units > 0 && s_bitCursor < BITMAP_BYTES) {
+        uint8_t b = eeprom_queue_read(addr + s_bitCursor);
+        while (units > 0 && b != 0) {
+            b &= (uint8_t)(b - 1);
+            units--;
+        }
+        eeprom_queue_write(addr + s_bitCursor, b);
+        if (b == 0) s_bitCursor++;
+    }
+}
+
+// Commits whole units of session gems, rebasing when the bitmap is full.
+static void flushSession() {
+    uint16_t units = (uint16_t)(s_sessionGems / kGemUnit);
+    if (units == 0) return;
+
+    if (s_bitsUsed + units > BITMAP_BITS) {
+        writeBase(s_lifetimeGems + s_sessionGems);
+        s_sessionGems = 0;
+        return;
+    }
+
+    clearBitmapBits(units);
+    uint32_t committed = (uint32_t)units * kGemUnit;
+    s_bitsUsed     += units;
+    s_lifetimeGems += committed;
+    s_sessionGems  -= committed;
+    event_log_add(EventType::EepromFlush, kFlushGems, s_lifetimeGems);
+}
+
+// Reads the lifetime count from layout 1. Also reports which legacy slot
+// held it so the migration can avoid overwriting it.
+static uint32_t readLegacyLifetime(uint16_t& legacySlot) {
+    uint16_t len = eeprom_queue_length();
+    uint16_t m   = (len > LEGACY_SLOTS_START) ? (len - LEGACY_SLOTS_START) / BYTES_PER_SLOT : 0;
+    legacySlot   = 0;
     if (m == 0) return 0;
 
     uint16_t lastSlot;
-    EEPROM.get(SLOT_INDEX_ADDR, lastSlot);
-    lastSlot = sanitizeSlotIndex(lastSlot);
+    eeprom_queue_get(LEGACY_INDEX_ADDR, lastSlot);
+    lastSlot   = sanitizeSlotIndex(lastSlot, m);
+    legacySlot = lastSlot;
 
-    uint16_t addr  = slotAddr(lastSlot);
     uint32_t value = 0;
-    EEPROM.get(addr, value);
-    uint8_t chk = EEPROM.read(addr + BYTES_PER_SLOT - 1);
-
-    if (value == 0xFFFFFFFFUL) return 0;  // blank/unwritten slot
-
-    if (chk == 0xFF || chk == checksum32(value)) return value;
+    uint16_t addr  = (uint16_t)(LEGACY_SLOTS_START + lastSlot * BYTES_PER_SLOT);
+    if (readSlotValue(addr, value)) return value;
 
     // Checksum mismatch — try the previous slot as fallback
     if (lastSlot > 0) {
-        uint16_t prevAddr = slotAddr(lastSlot - 1);
+        uint16_t prevAddr = (uint16_t)(addr - BYTES_PER_SLOT);
         uint32_t prevVal  = 0;
-        EEPROM.get(prevAddr, prevVal);
-        uint8_t prevChk = EEPROM.read(prevAddr + BYTES_PER_SLOT - 1);
+        eeprom_queue_get(prevAddr, prevVal);
+        uint8_t prevChk = eeprom_queue_read(prevAddr + BYTES_PER_SLOT - 1);
         if (prevChk == checksum32(prevVal)) return prevVal;
     }
-
     return 0;
 }
 
-static void writeLifetimeToEEPROM(uint32_t lifetime) {
+static bool overlaps(uint16_t a, uint16_t aLen, uint16_t b, uint16_t bLen) {
+    return a < b + bLen && b < a + aLen;
+}
+
+static void migrateLegacyLayout() {
     uint16_t m = maxSlots();
-    if (m == 0) return;
 
-    uint16_t lastSlot;
-    EEPROM.get(SLOT_INDEX_ADDR, lastSlot);
-    lastSlot = sanitizeSlotIndex(lastSlot);
+    // Layout 1 never wrote [253..254]. A valid index there means an earlier
+    // run committed the new base and was cut off before the layout byte; its
+    // bitmap erase may already have overwritten the legacy slots, so finish
+    // from the new base instead of reading them again.
+    uint16_t storedSlot;
+    uint32_t base;
+    eeprom_queue_get(SLOT_INDEX_ADDR, storedSlot);
+    if (storedSlot < m && readSlotValue(slotAddr(storedSlot), base)) {
+        eraseBitmap(bitmapAddr(storedSlot));
+        eeprom_queue_write(LAYOUT_VERSION_ADDR, LAYOUT_VERSION);
+        s_lastSlot     = storedSlot;
+        s_bitsUsed     = 0;
+        s_bitCursor    = 0;
+        s_lifetimeGems = base;
+        return;
+    }
+
+    uint16_t legacySlot;
+    uint32_t lifetime = readLegacyLifetime(legacySlot);
 
-    uint16_t nextSlot = (uint16_t)((lastSlot + 1) % m);
-    uint16_t addr     = slotAddr(nextSlot);
+    // Legacy slots L and L-1 (the fallback) must survive until the new index
+    // has committed. Both bitmaps can overlap them (L = 12 or 13), so only
+    // the new slot itself has to avoid them; its bitmap still holds legacy
+    // bytes and is erased after the index, ahead of the layout byte.
+    uint16_t keep    = (uint16_t)(LEGACY_SLOTS_START + legacySlot * BYTES_PER_SLOT);
+    uint16_t keepLen = BYTES_PER_SLOT;
+    if (legacySlot > 0) {
+        keep    -= BYTES_PER_SLOT;
+        keepLen += BYTES_PER_SLOT;
+    }
+
+    for (uint16_t slot = 0; slot < m; ++slot) {
+        if (overlaps(slotAddr(slot), BYTES_PER_SLOT, keep, keepLen)) continue;
+        putBase(slot, lifetime);
+        eraseBitmap(bitmapAddr(slot));
+        eeprom_queue_write(LAYOUT_VERSION_ADDR, LAYOUT_VERSION);
+        return;
+    }
+}
 
-    EEPROM.put(addr, lifetime);
-    uint8_t chk = checksum32(lifetime);
-    EEPROM.put((uint16_t)(addr + BYTES_PER_SLOT - 1), chk);
-    EEPROM.put(SLOT_INDEX_ADDR, nextSlot);
+// Restores session gems saved by a power-fail commit, then clears the record.
+static void restorePending() {
+    uint8_t v   = eeprom_queue_read(PENDING_ADDR);
+    uint8_t inv = eeprom_queue_read(PENDING_ADDR + 1);
+    if (v == 0xFF && inv == 0xFF) return;
+    if ((uint8_t)~v == inv) s_sessionGems += v;
+    eeprom_queue_write(PENDING_ADDR,     0xFF);
+    eeprom_queue_write(PENDING_ADDR + 1, 0xFF);
 }
 
 // ---------------------------------------------------------------------------
@@ -98,17 +314,34 @@ static void writeLifetimeToEEPROM(uint32_t lifetime) {
 // ---------------------------------------------------------------------------
 
 void gem_store_begin() {
-    if (maxSlots() == 0) return;
+    uint16_t m = maxSlots();
+    if (m == 0) return;
+
+    s_sessionGems = 0;
+    restorePending();
+
+    if (eeprom_queue_read(LAYOUT_VERSION_ADDR) != LAYOUT_VERSION) {
+        migrateLegacyLayout();
+        return;
+    }
 
     uint16_t storedSlot;
-    EEPROM.get(SLOT_INDEX_ADDR, storedSlot);
-    uint16_t fixed = sanitizeSlotIndex(storedSlot);
+    eeprom_queue_get(SLOT_INDEX_ADDR, storedSlot);
+    uint16_t fixed = sanitizeSlotIndex(storedSlot, m);
     if (fixed != storedSlot) {
-        EEPROM.put(SLOT_INDEX_ADDR, (uint16_t)0);
+        eeprom_queue_put(SLOT_INDEX_ADDR, fixed);
     }
 
-    s_lifetimeGems = readLifetimeFromEEPROM();
-    s_sessionGems  = 0;
+    uint16_t slot;
+    uint32_t base;
+    if (!readBase(fixed, slot, base)) {
+        slot = fixed;
+        base = 0;
+    }
+
+    s_lastSlot = slot;
+    scanBitmap();
+    s_lifetimeGems = base + (uint32_t)s_bitsUsed * kGemUnit;
 }
 
 uint32_t gem_store_read_lifetime() {
@@ -116,12 +349,15 @@ uint32_t gem_store_read_lifetime() {
 }
 
 uint32_t gem_store_add_session(uint32_t gemsEarned) {
+    uint8_t sreg = SREG;
+    cli();
     s_sessionGems += gemsEarned;
+    SREG = sreg;
 
     if (s_sessionGems >= kGemSaveThreshold) {
-        s_lifetimeGems += s_sessionGems;
-        writeLifetimeToEEPROM(s_lifetimeGems);
-        s_sessionGems = 0;
+        s_busy = true;
+        flushSession();
+        s_busy = false;
     }
 
     return s_lifetimeGems + s_sessionGems;
@@ -132,17 +368,95 @@ uint32_t gem_store_total() {
 }
 
 void gem_store_write_lifetime(uint32_t lifetime) {
-    s_lifetimeGems = lifetime;
-    s_sessionGems  = 0;
-    writeLifetimeToEEPROM(lifetime);
+    s_busy = true;
+    s_sessionGems = 0;
+    writeBase(lifetime);
+    // A record saved during a supply dip that never became a reset would
+    // otherwise be added to the new count at the next boot.
+    eeprom_queue_write(PENDING_ADDR,     0xFF);
+    eeprom_queue_write(PENDING_ADDR + 1, 0xFF);
+    s_busy = false;
+}
+
+void gem_store_commit_on_power_fail() {
+    // If the loop was interrupted mid-flush its writes are already queued
+    // and leave a consistent store; only the unflushed remainder is lost.
+    if (s_busy || s_sessionGems == 0) return;
+    // Ahead of anything already queued, so it is programmed within the
+    // hold-up time; the complement goes in first so it is written second.
+    uint8_t v = (uint8_t)s_sessionGems;
+    eeprom_queue_write_first(PENDING_ADDR + 1, (uint8_t)~v);
+    eeprom_queue_write_first(PENDING_ADDR,     v);
+}
+
+void gem_store_power_restored() {
+    // The session count is still in RAM, so the record must not be counted again.
+    eeprom_queue_write(PENDING_ADDR,     0xFF);
+    eeprom_queue_write(PENDING_ADDR + 1, 0xFF);
+}
+
+// Gems committed per rebase once a bitmap is exhausted.
+static uint32_t gemsPerRebase() {
+    return (uint32_t)BITMAP_BITS * kGemUnit;
+}
+
+uint32_t gem_store_slot_wear() {
+    uint16_t m = maxSlots();
+    if (m == 0) return 0;
+    return s_lifetimeGems / gemsPerRebase() / m;
+}
+
+uint32_t gem_store_bitmap_wear() {
+    return s_lifetimeGems / gemsPerRebase() / 2;
+}
+
+bool gem_store_prepare_rebase() {
+    uint16_t m = maxSlots();
+    if (m == 0) return true;
+
+    // The next slot owns the other bitmap, which nothing reads until the
+    // rebase points the index at it.
+    uint16_t bmp    = bitmapAddr((uint16_t)((s_lastSlot + 1) % m));
+    uint8_t  queued = 0;
+    for (uint8_t i = 0; i < BITMAP_BYTES; ++i) {
+        if (eeprom_queue_read(bmp + i) == 0xFF) continue;
+        if (queued == kGemEraseSlice) return false;
+        eeprom_queue_write(bmp + i, 0xFF);
+        queued++;
+    }
+    return true;
+}
+
+bool gem_store_verify() {
+    if (maxSlots() == 0) return false;
+
+    uint32_t base;
+    bool ok = readSlotValue(slotAddr(s_lastSlot), base);
+    uint16_t addr = bitmapAddr(s_lastSlot);
+    uint16_t bits = 0;
+    for (uint8_t i = 0; i < BITMAP_BYTES; ++i) bits += clearedBits(eeprom_queue_read(addr + i));
+    if (ok && bits == s_bitsUsed && base + (uint32_t)bits * kGemUnit == s_lifetimeGems) return false;
+
+    s_busy = true;
+    uint32_t total = s_lifetimeGems + s_sessionGems;
+    s_sessionGems = 0;
+    writeBase(total);
+    s_busy = false;
+    return true;
 }
 
 void gem_store_clear_all() {
-    uint16_t len = EEPROM.length();
-    for (uint16_t i = GEM_SLOTS_START; i < len; ++i) {
-        EEPROM.update(i, 0xFF);
+    s_busy = true;
+    uint16_t end = slotRegionEnd();
+    for (uint16_t i = BITMAP_A_START; i < end; ++i) {
+        eeprom_queue_write(i, 0xFF);
     }
-    EEPROM.put(SLOT_INDEX_ADDR, (uint16_t)0);
+    eeprom_queue_put(SLOT_INDEX_ADDR, (uint16_t)0);
+    eeprom_queue_write(LAYOUT_VERSION_ADDR, LAYOUT_VERSION);
+    s_lastSlot     = 0;
+    s_bitsUsed     = 0;
+    s_bitCursor    = 0;
     s_lifetimeGems = 0;
     s_sessionGems  = 0;
+    s_busy         = false;
 }
@@ -15,8 +15,33 @@ uint32_t gem_store_add_session(uint32_t gemsEarned);
 // Returns the current lifetime + unflushed session total without modifying anything.
 uint32_t gem_store_total();
 
-// Overwrite the stored lifetime count directly (e.g. from the menu gem-count editor).
+// Overwrite the stored lifetime count directly (e.g. from the menu gem-count
+// editor). Also discards any power-fail record.
 void gem_store_write_lifetime(uint32_t lifetime);
 
+// Queue the unflushed session count for saving, ahead of any other queued
+// writes. Called from the power-fail interrupt; the caller flushes the EEPROM
+// write queue afterwards.
+void gem_store_commit_on_power_fail();
+
+// Discard the power-fail record after the supply recovers without a reset.
+void gem_store_power_restored();
+
+// Estimated erase cycles so far, derived from the lifetime count: each
+// rebase erases one bitmap (the two alternate) and writes the next base slot
+// round the ring. Counts written by hand or under layout 1 aren't included.
+uint32_t gem_store_slot_wear();
+uint32_t gem_store_bitmap_wear();
+
+// Housekeeping: erase the bitmap the next rebase will use, kGemEraseSlice
+// bytes per call, so the rebase itself only writes the slot and index.
+// Returns true once the whole bitmap is erased.
+bool gem_store_prepare_rebase();
+
+// Housekeeping: re-read the live base slot and bitmap and check them against
+// the RAM mirror. On a mismatch the RAM total is written as a fresh base.
+// Returns true if it rebased.
+bool gem_store_verify();
+
 // Erase all gem data from EEPROM and reset session count to zero.
 void gem_store_clear_all();
@@ -0,0 +1,107 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Hardware abstraction layer.
+//
+// The firmware modules reach pins, timers, the EEPROM controller, the
+// DS1307, the serial port and the LCD only through these calls.
+// hal_avr.cpp implements them on the Mega with the Arduino core, RTClib and
+// U8g2. hal_host.cpp implements them in memory, so the whole sketch also
+// builds and runs as a Linux program (see host/ and CMakeLists.txt).
+
+// ---------------------------------------------------------------------------
+// GPIO / PWM
+// ---------------------------------------------------------------------------
+
+void hal_pinOutput(uint8_t pin);
+void hal_pinInputPullup(uint8_t pin);
+bool hal_pinRead(uint8_t pin);                  // true = high
+void hal_pwmWrite(uint8_t pin, uint8_t duty);   // 0 = low, 255 = fully on
+
+// ---------------------------------------------------------------------------
+// Time
+// ---------------------------------------------------------------------------
+
+uint32_t hal_millis();
+uint32_t hal_micros();
+
+// hal_millis() widened to 64 bits; never wraps. Use it through mono_time.h.
+uint64_t hal_millis64();
+
+// Tells the HAL that time-based work is due at atMs (a hal_millis() value).
+// Modules call it every loop() while they are waiting on a deadline. The
+// board ignores it; the host simulator jumps its clock to the earliest one
+// instead of stepping through the idle time in between.
+void hal_deadline(uint32_t atMs);
+
+// ---------------------------------------------------------------------------
+// EEPROM controller
+// ---------------------------------------------------------------------------
+// Byte-level access for eeprom_queue.cpp, which owns all EEPROM traffic.
+// Writes are asynchronous: hal_eepromProgram() starts one and enables the
+// ready interrupt, which calls eeprom_queue_onReady() whenever the
+// controller is idle until hal_eepromReadyIrq(false).
+
+uint16_t hal_eepromSize();
+bool     hal_eepromBusy();
+uint8_t  hal_eepromRead(uint16_t addr);                              // only when not busy
+void     hal_eepromProgram(uint16_t addr, uint8_t current, uint8_t value);
+void     hal_eepromReadyIrq(bool enable);
+
+// ---------------------------------------------------------------------------
+// Real-time clock (DS1307)
+// ---------------------------------------------------------------------------
+
+struct RtcTime {
+    uint16_t year   = 2000;
+    uint8_t  month  = 1;    // 1-12
+    uint8_t  day    = 1;    // 1-31
+    uint8_t  hour   = 0;
+    uint8_t  minute = 0;
+    uint8_t  second = 0;
+};
+
+bool hal_rtcBegin();                                   // false if no RTC answers
+void hal_rtcRead(RtcTime& t);                          // fields unchecked: a failed read decodes to garbage
+void hal_rtcReadNvram(uint8_t addr, uint8_t* buf, uint8_t len);
+void hal_rtcWriteNvram(uint8_t addr, const uint8_t* buf, uint8_t len);
+
+// ---------------------------------------------------------------------------
+// Serial port
+// ---------------------------------------------------------------------------
+
+void hal_serialBegin(uint32_t baud);
+int  hal_serialAvailable();            // bytes waiting to be read
+int  hal_serialRead();                 // -1 if none
+int  hal_serialWriteRoom();            // bytes that can be written without blocking
+void hal_serialWrite(const uint8_t* buf, size_t len);
+
+// ---------------------------------------------------------------------------
+// LCD (128x64 monochrome frame buffer)
+// ---------------------------------------------------------------------------
+// Drawing goes to an off-screen buffer; hal_lcdSend() pushes it out.
+// Coordinates and text follow U8g2: y is the text baseline.
+
+enum class LcdFont : uint8_t {
+    Title,    // 7x14 bold
+    Body,     // 6x10
+    Number,   // Helvetica bold 10
+    Small,    // 5x8
+};
+
+void     hal_lcdBegin();
+void     hal_lcdClear();
+void     hal_lcdSetFont(LcdFont font);
+void     hal_lcdSetCursor(int16_t x, int16_t y);
+void     hal_lcdPrint(const char* s);                   // draws at the cursor and advances it
+uint16_t hal_lcdStrWidth(const char* s);                // in the current font
+void     hal_lcdHLine(int16_t x, int16_t y, uint16_t w);
+void     hal_lcdVLine(int16_t x, int16_t y, uint16_t h);
+void     hal_lcdBitmap(int16_t x, int16_t y, uint8_t w, uint8_t h,
+                       const uint8_t* xbm);             // XBM bits in flash
+void     hal_lcdSend();
+
+// The frame buffer U8g2 draws into: 64 rows of 16 bytes, leftmost pixel in
+// the MSB. Holds the last frame drawn until the next hal_lcdClear().
+const uint8_t* hal_lcdBuffer();
@@ -0,0 +1,470 @@
+// Purpose: hal.h for the Linux build. Pins, EEPROM, RTC and LCD live in
+// memory; time is the host's monotonic clock (or a virtual clock the
+// simulator drives), the RTC follows the host's local time and the serial
+// port is stdin/stdout. Not compiled into the sketch.
+
+#ifndef ARDUINO
+
+#include "hal_host.h"
+#include "eeprom_queue.h"
+#include "pin_trace.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static constexpr uint8_t  PINS        = 70;     // Mega: D0-D53, A0-A15
+static constexpr uint16_t EEPROM_SIZE = 4096;
+static constexpr uint8_t  NVRAM_SIZE  = 56;
+static constexpr uint8_t  MAX_RUNS    = 32;
+
+// ---------------------------------------------------------------------------
+// GPIO / PWM
+// ---------------------------------------------------------------------------
+
+static bool     s_pinLevel[PINS];
+static uint8_t  s_pwm[PINS];
+static uint32_t s_pwmPulses[PINS];
+static bool     s_pinsReady = false;
+
+static TraceEdge* s_trace    = nullptr;   // every duty change, oldest first
+static size_t     s_traceLen = 0;
+static size_t     s_traceCap = 0;
+
+static uint64_t monotonicUs();
+
+static void initPins() {
+    if (s_pinsReady) return;
+    for (uint8_t i = 0; i < PINS; ++i) s_pinLevel[i] = true;
+    s_pinsReady = true;
+}
+
+void hal_pinOutput(uint8_t pin) {
+    initPins();
+    if (pin < PINS) s_pinLevel[pin] = false;
+}
+
+void hal_pinInputPullup(uint8_t) {
+    initPins();
+}
+
+bool hal_pinRead(uint8_t pin) {
+    initPins();
+    return pin < PINS ? s_pinLevel[pin] : true;
+}
+
+void hal_pwmWrite(uint8_t pin, uint8_t duty) {
+    pin_trace_record(pin, duty);
+    if (pin >= PINS) return;
+    if (s_pwm[pin] == 0 && duty != 0) s_pwmPulses[pin]++;
+    if (s_pwm[pin] != duty) {
+        if (s_traceLen == s_traceCap) {
+            size_t cap = s_traceCap ? s_traceCap * 2 : 1024;
+            TraceEdge* t = (TraceEdge*)realloc(s_trace, cap * sizeof(TraceEdge));
+            if (!t) abort();
+            s_trace    = t;
+            s_traceCap = cap;
+        }
+        s_trace[s_traceLen++] = { monotonicUs(), pin, duty };
+    }
+    s_pwm[pin] = duty;
+}
+
+void hal_host_setPin(uint8_t pin, bool high) {
+    initPins();
+    if (pin < PINS) s_pinLevel[pin] = high;
+}
+
+uint8_t hal_host_pwm(uint8_t pin) {
+    return pin < PINS ? s_pwm[pin] : 0;
+}
+
+uint32_t hal_host_pwmPulses(uint8_t pin) {
+    return pin < PINS ? s_pwmPulses[pin] : 0;
+}
+
+size_t hal_host_traceCount() {
+    return s_traceLen;
+}
+
+const TraceEdge& hal_host_traceEdge(size_t i) {
+    return s_trace[i];
+}
+
+void hal_host_traceClear() {
+    s_traceLen = 0;
+}
+
+// ---------------------------------------------------------------------------
+// Time
+// ---------------------------------------------------------------------------
+
+static bool     s_virtualTime = false;
+static uint64_t s_virtualUs   = 0;
+static uint32_t s_rtcBaseUnix = 0;
+static bool     s_haveDeadline = false;
+static uint32_t s_deadline     = 0;
+
+static uint64_t monotonicUs() {
+    if (s_virtualTime) return s_virtualUs;
+    static uint64_t start = 0;
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t us = (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+    if (start == 0) start = us;
+    return us - start;
+}
+
+uint32_t hal_millis() { return (uint32_t)(monotonicUs() / 1000u); }
+uint32_t hal_micros() { return (uint32_t)monotonicUs(); }
+uint64_t hal_millis64() { return monotonicUs() / 1000u; }
+
+void hal_deadline(uint32_t atMs) {
+    if (!s_haveDeadline || (int32_t)(atMs - s_deadline) < 0) s_deadline = atMs;
+    s_haveDeadline = true;
+}
+
+void hal_host_useVirtualTime(uint32_t rtcUnix) {
+    s_virtualTime = true;
+    s_virtualUs   = 0;
+    s_rtcBaseUnix = rtcUnix;
+}
+
+void hal_host_setTimeUs(uint64_t us) {
+    if (us > s_virtualUs) s_virtualUs = us;
+}
+
+uint64_t hal_host_timeUs() {
+    return monotonicUs();
+}
+
+bool hal_host_takeDeadline(uint32_t& atMs) {
+    if (!s_haveDeadline) return false;
+    atMs = s_deadline;
+    s_haveDeadline = false;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// EEPROM controller
+// ---------------------------------------------------------------------------
+// Writes complete immediately. The "ready interrupt" is run inline while it
+// stays enabled, so the queue drains before the enabling call returns.
+
+static uint8_t  s_eeprom[EEPROM_SIZE];
+static uint32_t s_eePrograms[EEPROM_SIZE];
+static uint32_t s_eeErases[EEPROM_SIZE];
+static FILE*    s_eepromFile  = nullptr;
+static bool     s_eepromReady = false;
+static bool     s_eeIrq       = false;
+static bool     s_inEeIrq     = false;
+
+static void initEeprom() {
+    if (s_eepromReady) return;
+    s_eepromReady = true;
+    memset(s_eeprom, 0xFF, sizeof(s_eeprom));
+    const char* path = getenv("SCREEN_TAPPER_EEPROM_IMAGE");
+    if (!path) return;
+    s_eepromFile = fopen(path, "r+b");
+    if (!s_eepromFile) s_eepromFile = fopen(path, "w+b");
+    if (!s_eepromFile) return;
+    size_t n = fread(s_eeprom, 1, sizeof(s_eeprom), s_eepromFile);
+    if (n < sizeof(s_eeprom)) {
+        fseek(s_eepromFile, 0, SEEK_SET);
+        fwrite(s_eeprom, 1, sizeof(s_eeprom), s_eepromFile);
+        fflush(s_eepromFile);
+    }
+}
+
+static void runReadyIrq() {
+    if (s_inEeIrq) return;
+    s_inEeIrq = true;
+    while (s_eeIrq) eeprom_queue_onReady();
+    s_inEeIrq = false;
+}
+
+uint16_t hal_eepromSize() {
+    return EEPROM_SIZE;
+}
+
+bool hal_eepromBusy() {
+    return false;
+}
+
+uint8_t hal_eepromRead(uint16_t addr) {
+    initEeprom();
+    return addr < EEPROM_SIZE ? s_eeprom[addr] : 0xFF;
+}
+
+void hal_eepromProgram(uint16_t addr, uint8_t current, uint8_t value) {
+    initEeprom();
+    if (addr < EEPROM_SIZE) {
+        s_eePrograms[addr]++;
+        if ((current & value) != value) s_eeErases[addr]++;   // same rule as the AVR's mode choice
+        s_eeprom[addr] = value;
+        if (s_eepromFile) {
+            fseek(s_eepromFile, addr, SEEK_SET);
+            fputc(value, s_eepromFile);
+            fflush(s_eepromFile);
+        }
+    }
+    s_eeIrq = true;
+    runReadyIrq();
+}
+
+void hal_eepromReadyIrq(bool enable) {
+    s_eeIrq = enable;
+    if (enable) runReadyIrq();
+}
+
+uint32_t hal_host_eepromPrograms(uint16_t addr) {
+    return addr < EEPROM_SIZE ? s_eePrograms[addr] : 0;
+}
+
+uint32_t hal_host_eepromErases(uint16_t addr) {
+    return addr < EEPROM_SIZE ? s_eeErases[addr] : 0;
+}
+
+// ---------------------------------------------------------------------------
+// Real-time clock
+// ---------------------------------------------------------------------------
+
+static uint8_t s_nvram[NVRAM_SIZE];
+
+bool hal_rtcBegin() {
+    return true;
+}
+
+// Virtual time: a DS1307 started at s_rtcBaseUnix, ticking in whole
+// seconds with the virtual clock.
+void hal_rtcRead(RtcTime& t) {
+    tm local;
+    if (s_virtualTime) {
+        time_t now = (time_t)s_rtcBaseUnix + (time_t)(s_virtualUs / 1000000u);
+        gmtime_r(&now, &local);
+    } else {
+        time_t now = time(nullptr);
+        localtime_r(&now, &local);
+    }
+    t.year   = (uint16_t)(local.tm_year + 1900);
+    t.month  = (uint8_t)(local.tm_mon + 1);
+    t.day    = (uint8_t)local.tm_mday;
+    t.hour   = (uint8_t)local.tm_hour;
+    t.minute = (uint8_t)local.tm_min;
+    t.second = (uint8_t)local.tm_sec;
+}
+
+void hal_rtcReadNvram(uint8_t addr, uint8_t* buf, uint8_t len) {
+    if (addr + len > NVRAM_SIZE) return;
+    memcpy(buf, &s_nvram[addr], len);
+}
+
+void hal_rtcWriteNvram(uint8_t addr, const uint8_t* buf, uint8_t len) {
+    if (addr + len > NVRAM_SIZE) return;
+    memcpy(&s_nvram[addr], buf, len);
+}
+
+// ---------------------------------------------------------------------------
+// Serial port
+// ---------------------------------------------------------------------------
+
+static int   s_peek      = -1;
+static FILE* s_serialOut = stdout;
+static bool  s_serialSet = false;
+
+void hal_serialBegin(uint32_t) {
+    int flags = fcntl(STDIN_FILENO, F_GETFL, 0);
+    if (flags >= 0) fcntl(STDIN_FILENO, F_SETFL, flags | O_NONBLOCK);
+}
+
+int hal_serialAvailable() {
+    if (s_peek < 0) {
+        unsigned char c;
+        if (read(STDIN_FILENO, &c, 1) == 1) s_peek = c;
+    }
+    return s_peek < 0 ? 0 : 1;
+}
+
+int hal_serialRead() {
+    if (!hal_serialAvailable()) return -1;
+    int c = s_peek;
+    s_peek = -1;
+    return c;
+}
+
+int hal_serialWriteRoom() {
+    return 64;   // the Mega's TX buffer; stdout never pushes back
+}
+
+void hal_serialWrite(const uint8_t* buf, size_t len) {
+    FILE* out = s_serialSet ? s_serialOut : stdout;
+    if (!out) return;
+    fwrite(buf, 1, len, out);
+    if (out == stdout) fflush(out);
+}
+
+void hal_host_setSerialOutput(FILE* f) {
+    s_serialOut = f;
+    s_serialSet = true;
+}
+
+// ---------------------------------------------------------------------------
+// LCD
+// ---------------------------------------------------------------------------
+// Text is recorded as strings for the tests, and also drawn into a real
+// frame buffer (hal_lcdBuffer()) with one 5x7 face for every font, so the
+// LCD mirror has pixels to send. Widths use each font's nominal cell, so
+// layout code sees plausible numbers.
+
+static LcdRun   s_draw[MAX_RUNS];   // frame being drawn
+static uint8_t  s_drawCount = 0;
+static LcdRun   s_sent[MAX_RUNS];   // last frame sent
+static uint8_t  s_sentCount = 0;
+static uint32_t s_frames    = 0;
+static LcdFont  s_font      = LcdFont::Body;
+static int16_t  s_cursorX   = 0;
+static int16_t  s_cursorY   = 0;
+static uint8_t  s_fb[64 * 16];      // U8g2 layout: 16 bytes per row, MSB left
+
+// 5x7 glyphs for ' '..'~', one byte per column, LSB at the top.
+static const uint8_t kFont5x7[] = {
+    0x00,0x00,0x00,0x00,0x00, 0x00,0x00,0x5F,0x00,0x00, 0x00,0x07,0x00,0x07,0x00,  //   ! "
+    0x14,0x7F,0x14,0x7F,0x14, 0x24,0x2A,0x7F,0x2A,0x12, 0x23,0x13,0x08,0x64,0x62,  // # $ %
+    0x36,0x49,0x55,0x22,0x50, 0x00,0x05,0x03,0x00,0x00, 0x00,0x1C,0x22,0x41,0x00,  // & ' (
+    0x00,0x41,0x22,0x1C,0x00, 0x14,0x08,0x3E,0x08,0x14, 0x08,0x08,0x3E,0x08,0x08,  // ) * +
+    0x00,0x50,0x30,0x00,0x00, 0x08,0x08,0x08,0x08,0x08, 0x00,0x60,0x60,0x00,0x00,  // , - .
+    0x20,0x10,0x08,0x04,0x02, 0x3E,0x51,0x49,0x45,0x3E, 0x00,0x42,0x7F,0x40,0x00,  // / 0 1
+    0x42,0x61,0x51,0x49,0x46, 0x21,0x41,0x45,0x4B,0x31, 0x18,0x14,0x12,0x7F,0x10,  // 2 3 4
+    0x27,0x45,0x45,0x45,0x39, 0x3C,0x4A,0x49,0x49,0x30, 0x01,0x71,0x09,0x05,0x03,  // 5 6 7
+    0x36,0x49,0x49,0x49,0x36, 0x06,0x49,0x49,0x29,0x1E, 0x00,0x36,0x36,0x00,0x00,  // 8 9 :
+    0x00,0x56,0x36,0x00,0x00, 0x08,0x14,0x22,0x41,0x00, 0x14,0x14,0x14,0x14,0x14,  // ; < =
+    0x00,0x41,0x22,0x14,0x08, 0x02,0x01,0x51,0x09,0x06, 0x32,0x49,0x79,0x41,0x3E,  // > ? @
+    0x7E,0x11,0x11,0x11,0x7E, 0x7F,0x49,0x49,0x49,0x36, 0x3E,0x41,0x41,0x41,0x22,  // A B C
+    0x7F,0x41,0x41,0x22,0x1C, 0x7F,0x49,0x49,0x49,0x41, 0x7F,0x09,0x09,0x09,0x01,  // D E F
+    0x3E,0x41,0x49,0x49,0x7A, 0x7F,0x08,0x08,0x08,0x7F, 0x00,0x41,0x7F,0x41,0x00,  // G H I
+    0x20,0x40,0x41,0x3F,0x01, 0x7F,0x08,0x14,0x22,0x41, 0x7F,0x40,0x40,0x40,0x40,  // J K L
+    0x7F,0x02,0x0C,0x02,0x7F, 0x7F,0x04,0x08,0x10,0x7F, 0x3E,0x41,0x41,0x41,0x3E,  // M N O
+    0x7F,0x09,0x09,0x09,0x06, 0x3E,0x41,0x51,0x21,0x5E, 0x7F,0x09,0x19,0x29,0x46,  // P Q R
+    0x46,0x49,0x49,0x49,0x31, 0x01,0x01,0x7F,0x01,0x01, 0x3F,0x40,0x40,0x40,0x3F,  // S T U
+    0x1F,0x20,0x40,0x20,0x1F, 0x3F,0x40,0x38,0x40,0x3F, 0x63,0x14,0x08,0x14,0x63,  // V W X
+    0x07,0x08,0x70,0x08,0x07, 0x61,0x51,0x49,0x45,0x43, 0x00,0x7F,0x41,0x41,0x00,  // Y Z [
+    0x02,0x04,0x08,0x10,0x20, 0x00,0x41,0x41,0x7F,0x00, 0x04,0x02,0x01,0x02,0x04,  // \ ] ^
+    0x40,0x40,0x40,0x40,0x40, 0x00,0x01,0x02,0x04,0x00, 0x20,0x54,0x54,0x54,0x78,  // _ ` a
+    0x7F,0x48,0x44,0x44,0x38, 0x38,0x44,0x44,0x44,0x20, 0x38,0x44,0x44,0x48,0x7F,  // b c d
+    0x38,0x54,0x54,0x54,0x18, 0x08,0x7E,0x09,0x01,0x02, 0x0C,0x52,0x52,0x52,0x3E,  // e f g
+    0x7F,0x08,0x04,0x04,0x78, 0x00,0x44,0x7D,0x40,0x00, 0x20,0x40,0x44,0x3D,0x00,  // h i j
+    0x7F,0x10,0x28,0x44,0x00, 0x00,0x41,0x7F,0x40,0x00, 0x7C,0x04,0x18,0x04,0x78,  // k l m
+    0x7C,0x08,0x04,0x04,0x78, 0x38,0x44,0x44,0x44,0x38, 0x7C,0x14,0x14,0x14,0x08,  // n o p
+    0x08,0x14,0x14,0x18,0x7C, 0x7C,0x08,0x04,0x04,0x08, 0x48,0x54,0x54,0x54,0x20,  // q r s
+    0x04,0x3F,0x44,0x40,0x20, 0x3C,0x40,0x40,0x20,0x7C, 0x1C,0x20,0x40,0x20,0x1C,  // t u v
+    0x3C,0x40,0x30,0x40,0x3C, 0x44,0x28,0x10,0x28,0x44, 0x0C,0x50,0x50,0x50,0x3C,  // w x y
+    0x44,0x64,0x54,0x4C,0x44, 0x00,0x08,0x36,0x41,0x00, 0x00,0x00,0x7F,0x00,0x00,  // z { |
+    0x00,0x41,0x36,0x08,0x00, 0x10,0x08,0x08,0x10,0x08,                            // } ~
+};
+static_assert(sizeof(kFont5x7) == 95 * 5, "one glyph per printable character");
+
+static void setPixel(int16_t x, int16_t y) {
+    if (x < 0 || x >= 128 || y < 0 || y >= 64) return;
+    s_fb[y * 16 + x / 8] |= (uint8_t)(0x80 >> (x & 7));
+}
+
+// Draws c with its bottom row just above the baseline y.
+static void drawGlyph(int16_t x, int16_t y, char c) {
+    if (c < ' ' || c > '~') return;
+    const uint8_t* g = &kFont5x7[(c - ' ') * 5];
+    for (uint8_t col = 0; col < 5; ++col) {
+        for (uint8_t row = 0; row < 7; ++row) {
+            if (g[col] & (1 << row)) setPixel((int16_t)(x + col), (int16_t)(y - 7 + row));
+        }
+    }
+}
+
+static uint8_t charWidth(LcdFont font) {
+    switch (font) {
+        case LcdFont::Title:  return 7;
+        case LcdFont::Body:   return 6;
+        case LcdFont::Number: return 7;
+        case LcdFont::Small:  return 5;
+    }
+    return 6;
+}
+
+void hal_lcdBegin() {}
+
+void hal_lcdClear() {
+    s_drawCount = 0;
+    memset(s_fb, 0, sizeof(s_fb));
+}
+
+void hal_lcdSetFont(LcdFont font) {
+    s_font = font;
+}
+
+void hal_lcdSetCursor(int16_t x, int16_t y) {
+    s_cursorX = x;
+    s_cursorY = y;
+}
+
+void hal_lcdPrint(const char* s) {
+    if (!s || !*s) return;
+    if (s_drawCount < MAX_RUNS) {
+        LcdRun& r = s_draw[s_drawCount++];
+        r.x    = s_cursorX;
+        r.y    = s_cursorY;
+        r.font = s_font;
+        strncpy(r.text, s, sizeof(r.text) - 1);
+        r.text[sizeof(r.text) - 1] = '\0';
+    }
+    for (const char* c = s; *c; ++c) {
+        drawGlyph(s_cursorX, s_cursorY, *c);
+        s_cursorX = (int16_t)(s_cursorX + charWidth(s_font));
+    }
+}
+
+uint16_t hal_lcdStrWidth(const char* s) {
+    return (uint16_t)(strlen(s) * charWidth(s_font));
+}
+
+void hal_lcdHLine(int16_t x, int16_t y, uint16_t w) {
+    for (uint16_t i = 0; i < w; ++i) setPixel((int16_t)(x + i), y);
+}
+
+void hal_lcdVLine(int16_t x, int16_t y, uint16_t h) {
+    for (uint16_t i = 0; i < h; ++i) setPixel(x, (int16_t)(y + i));
+}
+
+void hal_lcdBitmap(int16_t x, int16_t y, uint8_t w, uint8_t h, const uint8_t* xbm) {
+    uint8_t stride = (uint8_t)((w + 7) / 8);
+    for (uint8_t row = 0; row < h; ++row) {
+        for (uint8_t col = 0; col < w; ++col) {
+            if (xbm[row * stride + col / 8] & (1 << (col & 7))) {
+                setPixel((int16_t)(x + col), (int16_t)(y + row));
+            }
+        }
+    }
+}
+
+void hal_lcdSend() {
+    memcpy(s_sent, s_draw, sizeof(LcdRun) * s_drawCount);
+    s_sentCount = s_drawCount;
+    s_frames++;
+}
+
+const uint8_t* hal_lcdBuffer() {
+    return s_fb;
+}
+
+uint8_t hal_host_lcdRunCount() {
+    return s_sentCount;
+}
+
+const LcdRun& hal_host_lcdRun(uint8_t i) {
+    return s_sent[i < s_sentCount ? i : 0];
+}
+
+uint32_t hal_host_lcdFrames() {
+    return s_frames;
+}
+
+#endif
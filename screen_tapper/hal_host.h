@@ -0,0 +1,62 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include "hal.h"
+
+// Host-only controls for the in-memory HAL in hal_host.cpp: drive input
+// pins, watch outputs, run on a virtual clock, read EEPROM wear and LCD
+// frames. Not part of the sketch.
+//
+// SCREEN_TAPPER_EEPROM_IMAGE  file backing the EEPROM (default: none, the
+//                             EEPROM starts erased and is lost on exit)
+
+// Input pins read high (pulled up) until driven.
+void hal_host_setPin(uint8_t pin, bool high);
+
+// Last PWM duty written to a pin, and how many times it went from 0 to
+// non-zero.
+uint8_t  hal_host_pwm(uint8_t pin);
+uint32_t hal_host_pwmPulses(uint8_t pin);
+
+// Every PWM write that changed a pin's duty since start (or the last
+// clear), stamped with the 64-bit host clock so week-long simulations do
+// not wrap. host/trace.h checks and exports it.
+struct TraceEdge {
+    uint64_t us;
+    uint8_t  pin;
+    uint8_t  duty;    // 0 = off
+};
+size_t           hal_host_traceCount();
+const TraceEdge& hal_host_traceEdge(size_t i);    // i < hal_host_traceCount()
+void             hal_host_traceClear();
+
+// Virtual time. Once enabled, hal_millis()/hal_micros() start from 0 and
+// only move when told to, and the RTC reads rtcUnix plus the elapsed virtual
+// seconds (wall-clock fields, no time zone).
+void     hal_host_useVirtualTime(uint32_t rtcUnix);
+void     hal_host_setTimeUs(uint64_t us);        // never moves backwards
+uint64_t hal_host_timeUs();
+
+// Earliest hal_deadline() since the last call; false if none was given.
+bool hal_host_takeDeadline(uint32_t& atMs);
+
+// Per-cell EEPROM counters: programming operations, and the subset that
+// needed an erase (set any bit), which is what wears a cell.
+uint32_t hal_host_eepromPrograms(uint16_t addr);
+uint32_t hal_host_eepromErases(uint16_t addr);
+
+// Where serial output goes (default stdout); nullptr discards it.
+void hal_host_setSerialOutput(FILE* f);
+
+// One string drawn on the LCD.
+struct LcdRun {
+    int16_t x;
+    int16_t y;           // baseline
+    LcdFont font;
+    char    text[24];
+};
+
+// Strings of the last frame sent with hal_lcdSend(), in drawing order.
+uint8_t        hal_host_lcdRunCount();
+const LcdRun&  hal_host_lcdRun(uint8_t i);
+uint32_t       hal_host_lcdFrames();     // frames sent since start
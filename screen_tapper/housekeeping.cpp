@@ -0,0 +1,71 @@
+#include "housekeeping.h"
+#include "settings_store.h"
+#include "gem_store.h"
+#include "stats.h"
+#include "sd_logger.h"
+#include "eeprom_queue.h"
+#include "console.h"
+#include "hal.h"
+#include <Arduino.h>
+
+static constexpr uint8_t JOBS = (uint8_t)HousekeepingJob::Count;
+static_assert(JOBS <= 8, "queued jobs are one bit each in s_pending");
+
+static uint8_t s_pending = 0;
+
+// ---------------------------------------------------------------------------
+// Jobs
+// ---------------------------------------------------------------------------
+// Each step does a bounded slice of work and returns true once the job is
+// finished; a job that returns false runs again on a later pass.
+
+static bool settingsFlush() { settings_flush();  return true; }
+static bool statsFlush()    { stats_flush();     return true; }
+static bool logSync()       { sd_logger_sync();  return true; }
+
+static bool gemErase() { return gem_store_prepare_rebase(); }
+
+static bool settingsCheck() {
+    if (settings_verify()) console_printf(PSTR("housekeeping: settings record rewritten"));
+    return true;
+}
+
+static bool gemCheck() {
+    if (gem_store_verify()) console_printf(PSTR("housekeeping: gem counter rebased"));
+    return true;
+}
+
+typedef bool (*JobStep)();
+
+static const JobStep kSteps[] PROGMEM = {
+    settingsFlush, statsFlush, logSync, gemErase, settingsCheck, gemCheck,
+};
+static_assert(sizeof(kSteps) / sizeof(kSteps[0]) == JOBS, "one step per HousekeepingJob");
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+void housekeeping_request(HousekeepingJob job) {
+    s_pending |= (uint8_t)(1u << (uint8_t)job);
+}
+
+void housekeeping_requestAll() {
+    s_pending = (uint8_t)((1u << JOBS) - 1);
+}
+
+bool housekeeping_pending() {
+    return s_pending != 0;
+}
+
+void housekeeping_service(bool idle) {
+    if (!idle || s_pending == 0) return;
+    // Keep the host simulator stepping instead of skipping to the next deadline.
+    hal_deadline(hal_millis());
+    if (eeprom_queue_pending() > 0) return;
+
+    uint8_t job = 0;
+    while (!(s_pending & (1u << job))) job++;
+    JobStep step = (JobStep)pgm_read_ptr(&kSteps[job]);
+    if (step()) s_pending &= (uint8_t)~(1u << job);
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <stdint.h>
+
+// Deferred maintenance. Work that can wait for the night is queued here and
+// run only while the device sleeps and the tapper is idle, so the loop
+// carries none of it during active hours. One slice of the first queued job
+// runs per loop() pass, and only once the EEPROM write queue has drained,
+// so a slice's writes never wait for room.
+
+enum class HousekeepingJob : uint8_t {
+    SettingsFlush,   // commit a pending settings edit
+    StatsFlush,      // write today's statistics bin back
+    LogSync,         // seal the partial SD log block
+    GemErase,        // pre-erase the bitmap the next gem rebase will use
+    SettingsCheck,   // re-read the settings record, rewrite it if it differs
+    GemCheck,        // re-read the gem counter, rebase it if it differs
+    Count
+};
+
+// Queue one job; queuing it again before it has run is a no-op.
+void housekeeping_request(HousekeepingJob job);
+
+// Queue every job: the nightly pass, requested on the way into sleep.
+void housekeeping_requestAll();
+
+// True while any job is queued.
+bool housekeeping_pending();
+
+// Run one slice if idle (asleep, tapper off). Call once per loop().
+void housekeeping_service(bool idle);
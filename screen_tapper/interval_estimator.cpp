@@ -0,0 +1,71 @@
+#include "interval_estimator.h"
+
+static_assert(kIntervalLearnMaxMs / 1000 <= 0xFFFF, "samples are kept in u16 seconds");
+
+static IntervalHistory s_hist;
+static uint32_t        s_cycleMs   = 0;
+static bool            s_haveCycle = false;
+
+// ---------------------------------------------------------------------------
+// Internal helpers
+// ---------------------------------------------------------------------------
+
+static void addSample(uint16_t sec) {
+    if (s_hist.count == kIntervalWindow) {
+        for (uint8_t i = 1; i < kIntervalWindow; ++i) s_hist.sec[i - 1] = s_hist.sec[i];
+        s_hist.count--;
+    }
+    s_hist.sec[s_hist.count++] = sec;
+}
+
+// Median by insertion sort of a copy; the window is a handful of entries.
+static uint16_t median() {
+    uint16_t v[kIntervalWindow];
+    uint8_t  n = s_hist.count;
+    for (uint8_t i = 0; i < n; ++i) {
+        uint16_t x = s_hist.sec[i];
+        uint8_t  j = i;
+        for (; j > 0 && v[j - 1] > x; --j) v[j] = v[j - 1];
+        v[j] = x;
+    }
+    // Even counts take the mean of the middle pair.
+    return (n & 1) ? v[n / 2] : (uint16_t)(((uint32_t)v[n / 2 - 1] + v[n / 2]) / 2);
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+void interval_estimator_begin(const IntervalHistory& h) {
+    s_hist = h;
+    if (s_hist.count > kIntervalWindow) s_hist.count = 0;
+    s_haveCycle = false;
+}
+
+void interval_estimator_cycleStarted(uint32_t nowMs) {
+    s_cycleMs   = nowMs;
+    s_haveCycle = true;
+}
+
+void interval_estimator_invalidate() {
+    s_haveCycle = false;
+}
+
+bool interval_estimator_ready(uint32_t nowMs) {
+    if (!s_haveCycle) return false;
+    s_haveCycle = false;
+    uint32_t ms = nowMs - s_cycleMs;
+    if (ms < kIntervalLearnMinMs || ms > kIntervalLearnMaxMs) return false;
+    addSample((uint16_t)((ms + 500) / 1000));
+    return true;
+}
+
+bool interval_estimator_estimateMs(uint32_t& outMs) {
+    if (s_hist.count < kIntervalMinSamples) return false;
+    outMs = median() * 1000UL;
+    return true;
+}
+
+const IntervalHistory& interval_estimator_history() {
+    return s_hist;
+}
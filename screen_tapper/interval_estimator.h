@@ -0,0 +1,37 @@
+#pragma once
+#include <stdint.h>
+#include "config.h"
+
+// Learns the tap interval from the reset button. A press after a tap cycle
+// means "the resource is ready again", so the time from the cycle's start to
+// the press is one sample of how long it really takes. The last
+// kIntervalWindow samples are kept and their median is the estimate, so one
+// late or early press cannot drag it far.
+//
+// Only the first press after a cycle counts, and sleep or a mode change in
+// between voids the pending cycle. The samples are persisted with the
+// settings (settings_store.h).
+
+// Samples in seconds, oldest first. Part of the settings record.
+struct IntervalHistory {
+    uint8_t  count = 0;
+    uint16_t sec[kIntervalWindow] = {};
+};
+
+// Restore the samples loaded with the settings.
+void interval_estimator_begin(const IntervalHistory& h);
+
+// A tap cycle started; the next press measures from here.
+void interval_estimator_cycleStarted(uint32_t nowMs);
+
+// Forget the pending cycle (sleep, device off, test mode).
+void interval_estimator_invalidate();
+
+// The reset button was pressed. Returns true if it added a sample, so the
+// caller can save the settings.
+bool interval_estimator_ready(uint32_t nowMs);
+
+// Median of the samples in ms, once there are kIntervalMinSamples of them.
+bool interval_estimator_estimateMs(uint32_t& outMs);
+
+const IntervalHistory& interval_estimator_history();
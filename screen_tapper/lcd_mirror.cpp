@@ -0,0 +1,181 @@
+#include "lcd_mirror.h"
+
+#ifdef LCD_MIRROR
+
+#include "console.h"
+#include "hal.h"
+#include "serial_frame.h"
+#include <string.h>
+
+static_assert(kLcdMirrorFrameMax + SERIAL_FRAME_OVERHEAD <= 63,
+              "mirror frames must fit the serial TX buffer");
+
+static constexpr uint8_t COLS       = 16;
+static constexpr uint8_t TILES      = 128;
+static constexpr uint8_t TILE_BYTES = 1 + 8;     // largest tile entry
+static constexpr uint8_t RUN_BYTES  = 3;
+static constexpr uint8_t RUN_FLAG   = 0x80;
+
+// Per-tile hash of what the viewer was last sent. A collision leaves a tile
+// stale until the rolling refresh reaches it. Every tile starts pending so
+// the first screen goes out whole.
+static uint8_t  s_hash[TILES];
+static uint8_t  s_pending[TILES / 8] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+static bool     s_enabled       = true;
+static bool     s_newFrame      = false;
+static bool     s_sending       = false;    // tiles of one screen going out
+static uint8_t  s_next          = 0;        // first tile not yet looked at
+static uint8_t  s_refreshTile   = 0;
+static uint32_t s_lastScanMs    = 0;
+static uint32_t s_lastRefreshMs = 0;
+static uint32_t s_frameMs       = 0;
+
+// ---------------------------------------------------------------------------
+// Tiles
+// ---------------------------------------------------------------------------
+
+static void setPending(uint8_t t)    { s_pending[t >> 3] |= (uint8_t)(1 << (t & 7)); }
+static void clearPending(uint8_t t)  { s_pending[t >> 3] &= (uint8_t)~(1 << (t & 7)); }
+static bool isPending(uint8_t t)     { return s_pending[t >> 3] & (1 << (t & 7)); }
+
+static void readTile(const uint8_t* fb, uint8_t t, uint8_t rows[8]) {
+    const uint8_t* p = fb + (uint16_t)(t / COLS) * 8 * COLS + t % COLS;
+    for (uint8_t r = 0; r < 8; ++r, p += COLS) rows[r] = *p;
+}
+
+static uint8_t hashRows(const uint8_t rows[8]) {
+    uint8_t h = 0;
+    for (uint8_t r = 0; r < 8; ++r) h = (uint8_t)(((h << 1) | (h >> 7)) ^ rows[r]);
+    return h;
+}
+
+// True if all eight rows are the same byte.
+static bool solid(const uint8_t rows[8]) {
+    for (uint8_t r = 1; r < 8; ++r) {
+        if (rows[r] != rows[0]) return false;
+    }
+    return true;
+}
+
+static void scan(const uint8_t* fb) {
+    uint8_t rows[8];
+    for (uint8_t t = 0; t < TILES; ++t) {
+        readTile(fb, t, rows);
+        if (hashRows(rows) != s_hash[t]) setPending(t);
+    }
+}
+
+static bool anyPending() {
+    for (uint8_t i = 0; i < sizeof(s_pending); ++i) {
+        if (s_pending[i]) return true;
+    }
+    return false;
+}
+
+// Encodes pending tiles from s_next on into p, up to room bytes. Returns
+// the payload length; 0 once every pending tile has been sent.
+static uint8_t buildTiles(const uint8_t* fb, uint8_t* p, uint8_t room) {
+    uint8_t len = 0;
+    uint8_t rows[8];
+    while (s_next < TILES) {
+        uint8_t t = s_next;
+        if (!isPending(t)) {
+            s_next++;
+            continue;
+        }
+        readTile(fb, t, rows);
+        if (solid(rows)) {
+            if (len + RUN_BYTES > room) break;
+            uint8_t n = 0;
+            uint8_t more[8];
+            while (t + n < TILES && isPending(t + n)) {
+                readTile(fb, t + n, more);
+                if (!solid(more) || more[0] != rows[0]) break;
+                s_hash[t + n] = hashRows(more);
+                clearPending(t + n);
+                n++;
+            }
+            p[len++] = (uint8_t)(RUN_FLAG | t);
+            p[len++] = rows[0];
+            p[len++] = n;
+            s_next = (uint8_t)(t + n);
+        } else {
+            if (len + TILE_BYTES > room) break;
+            p[len++] = t;
+            memcpy(p + len, rows, 8);
+            len += 8;
+            s_hash[t] = hashRows(rows);
+            clearPending(t);
+            s_next++;
+        }
+    }
+    return len;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+void lcd_mirror_frameSent() {
+    s_newFrame = true;
+    s_frameMs  = hal_millis();
+}
+
+void lcd_mirror_enable(bool on) {
+    s_enabled = on;
+    s_sending = false;
+    if (on) memset(s_pending, 0xFF, sizeof(s_pending));
+}
+
+void lcd_mirror_service() {
+    if (!s_enabled || !console_txIdle()) return;
+    const uint8_t* fb = hal_lcdBuffer();
+
+    if (!s_sending) {
+        uint32_t now = hal_millis();
+        if (now - s_lastScanMs < kLcdMirrorPeriodMs) return;
+        bool refresh = now - s_lastRefreshMs >= kLcdMirrorRefreshMs;
+        if (!s_newFrame && !refresh && !anyPending()) return;
+
+        s_lastScanMs = now;
+        if (s_newFrame) scan(fb);
+        s_newFrame = false;
+        if (refresh) {
+            for (uint8_t i = 0; i < kLcdMirrorRefreshTiles; ++i) {
+                setPending(s_refreshTile);
+                s_refreshTile = (uint8_t)((s_refreshTile + 1) % TILES);
+            }
+            s_lastRefreshMs = now;
+        }
+        if (!anyPending()) return;
+        s_next    = 0;
+        s_sending = true;
+    }
+
+    for (;;) {
+        int room = hal_serialWriteRoom() - SERIAL_FRAME_OVERHEAD;
+        if (room < TILE_BYTES) return;
+        uint8_t p[kLcdMirrorFrameMax];
+        uint8_t len = buildTiles(fb, p, room < kLcdMirrorFrameMax ? (uint8_t)room
+                                                                  : kLcdMirrorFrameMax);
+        if (len > 0) {
+            serial_frame_send('D', p, len);
+            continue;
+        }
+        memcpy(p, &s_frameMs, 4);
+        serial_frame_send('F', p, 4);
+        s_sending = false;
+        return;
+    }
+}
+
+#else
+
+void lcd_mirror_frameSent() {}
+void lcd_mirror_enable(bool) {}
+void lcd_mirror_service() {}
+
+#endif
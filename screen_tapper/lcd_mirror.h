@@ -0,0 +1,27 @@
+#pragma once
+#include <stdint.h>
+#include "config.h"
+
+// LCD mirror. The frame buffer is split into 128 tiles of 8x8 pixels and
+// the tiles that changed since they were last sent go out as CRC frames
+// (serial_frame.h), at most one screen per kLcdMirrorPeriodMs and only as
+// much as fits the serial TX buffer each loop(), so the real display and the
+// tapper never wait on it. tools/lcd_mirror_view.py rebuilds the screen.
+//
+// Frames:
+//   'D'  tiles: entries until the end of the payload, tile = row * 16 + col
+//          tile            then 8 row bytes, top first, MSB = leftmost pixel
+//          0x80 | tile, fill, n
+//                          n tiles from tile on have every row equal to fill
+//   'F'  end of screen: u32 millis() when it was drawn
+//
+// Compiles away unless LCD_MIRROR is defined in config.h.
+
+// Called by display.cpp after every frame it sends to the LCD.
+void lcd_mirror_frameSent();
+
+// Start or stop the stream. Starting resends the whole screen.
+void lcd_mirror_enable(bool on);
+
+// Send changed tiles while the console is idle. Call once per loop().
+void lcd_mirror_service();
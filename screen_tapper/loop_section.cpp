@@ -0,0 +1,32 @@
+#include "loop_section.h"
+#include <Arduino.h>
+
+static const char NAME_SETUP[]    PROGMEM = "setup";
+static const char NAME_LOOP[]     PROGMEM = "loop";
+static const char NAME_PERIOD[]   PROGMEM = "period";
+static const char NAME_ENCODER[]  PROGMEM = "encoder";
+static const char NAME_MENU[]     PROGMEM = "menu";
+static const char NAME_AWAKE[]    PROGMEM = "awake";
+static const char NAME_TAPPER[]   PROGMEM = "tapper";
+static const char NAME_STORAGE[]  PROGMEM = "storage";
+static const char NAME_VIEW[]     PROGMEM = "view";
+static const char NAME_DRAW[]     PROGMEM = "draw";
+static const char NAME_LCD[]      PROGMEM = "lcd";
+static const char NAME_CONSOLE[]  PROGMEM = "console";
+static const char NAME_SD[]       PROGMEM = "sd";
+static const char NAME_BENCH[]    PROGMEM = "bench";
+static const char NAME_HOUSEKEEP[] PROGMEM = "housekeep";
+static const char NAME_UNKNOWN[]  PROGMEM = "?";
+
+static const char* const kNames[] PROGMEM = {
+    NAME_SETUP, NAME_LOOP, NAME_PERIOD, NAME_ENCODER, NAME_MENU, NAME_AWAKE,
+    NAME_TAPPER, NAME_STORAGE, NAME_VIEW, NAME_DRAW, NAME_LCD, NAME_CONSOLE,
+    NAME_SD, NAME_BENCH, NAME_HOUSEKEEP,
+};
+static_assert(sizeof(kNames) / sizeof(kNames[0]) == (uint8_t)LoopSection::Count,
+              "one name per LoopSection");
+
+const char* loop_section_name(LoopSection section) {
+    if ((uint8_t)section >= (uint8_t)LoopSection::Count) return NAME_UNKNOWN;
+    return (const char*)pgm_read_ptr(&kNames[(uint8_t)section]);
+}
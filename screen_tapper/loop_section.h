@@ -0,0 +1,51 @@
+#pragma once
+#include <stdint.h>
+#include "profiler.h"
+
+// Named regions of setup()/loop(). The watchdog keeps the one currently
+// executing in no-init RAM so a reset can be attributed to it, and PROFILE
+// builds time each one (see profiler.h).
+
+enum class LoopSection : uint8_t {
+    Setup,
+    Loop,           // loop() outside any narrower section
+    LoopPeriod,     // start of one loop() to the start of the next (profiler only)
+    EncoderPoll,
+    MenuUpdate,
+    ClockIsAwake,
+    TapperUpdate,
+    Storage,        // deferred settings / gem commits
+    BuildMenuView,
+    DrawView,       // compose + send a frame
+    LcdSend,        // the send part alone
+    Console,        // console, event-log dump, profiler output
+    SdLogger,
+    SelfBench,      // one self-benchmark slice
+    Housekeeping,   // one deferred-maintenance slice
+    Count
+};
+
+// Short lowercase name, for reports.
+const char* loop_section_name(LoopSection section);   // string in flash
+
+// Section bookkeeping, implemented in watchdog.cpp.
+LoopSection loop_section_current();
+void        loop_section_set(LoopSection section);
+
+// Marks the enclosing scope as `section`, restoring the outer section on
+// exit so time after a nested section is not blamed on it.
+class SectionScope {
+public:
+    explicit SectionScope(LoopSection section) : m_outer(loop_section_current()) {
+        loop_section_set(section);
+    }
+    ~SectionScope() { loop_section_set(m_outer); }
+private:
+    LoopSection m_outer;
+};
+
+#define LOOP_SECTION_CONCAT_(a, b) a##b
+#define LOOP_SECTION_CONCAT(a, b)  LOOP_SECTION_CONCAT_(a, b)
+#define LOOP_SECTION(section)                                                    \
+    SectionScope LOOP_SECTION_CONCAT(sectionScope_, __LINE__)(LoopSection::section); \
+    PROFILE_SCOPE(section)
@@ -0,0 +1,94 @@
+#include "mem_monitor.h"
+#include "config.h"
+
+#ifdef __AVR__
+
+#include <avr/io.h>
+
+// Linker and avr-libc symbols
+extern uint8_t  __data_start;   // start of SRAM used by .data
+extern uint8_t  __heap_start;   // end of .bss
+extern uint8_t  __stack;        // RAMEND
+extern uint8_t* __brkval;       // malloc's break, 0 until the first malloc
+
+static constexpr uint8_t  CANARY     = 0xC5;
+static constexpr uint16_t SCAN_CHUNK = 128;   // bytes checked per update
+
+static uint8_t* s_cursor     = nullptr;   // next byte to check; null = idle
+static uint16_t s_minFree    = 0xFFFF;
+static uint32_t s_lastScanMs = 0;
+
+// Runs from .init3: after the stack pointer is set up, before .data/.bss
+// are initialized (they sit below __heap_start and are not touched) and
+// before any constructor. The stack is still empty, so everything up to
+// RAMEND can be painted. Naked and register-only: there is no frame yet.
+void mem_monitor_paint() __attribute__((naked, used, section(".init3")));
+void mem_monitor_paint() {
+    __asm__ volatile(
+        "    ldi r30, lo8(__heap_start)\n"
+        "    ldi r31, hi8(__heap_start)\n"
+        "    ldi r24, %[canary]\n"
+        "    ldi r25, hi8(__stack)\n"
+        "    rjmp 2f\n"
+        "1:  st Z+, r24\n"
+        "2:  cpi r30, lo8(__stack)\n"
+        "    cpc r31, r25\n"
+        "    brlo 1b\n"
+        "    breq 1b\n"
+        :: [canary] "i" (CANARY));
+}
+
+static uint8_t* heapTop() {
+    return __brkval ? __brkval : &__heap_start;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+void mem_monitor_update(uint32_t nowMs) {
+    if (!s_cursor) {
+        if (nowMs - s_lastScanMs < kMemScanMs) return;
+        s_lastScanMs = nowMs;
+        s_cursor = heapTop();
+    }
+
+    // Walk up from the heap to the first byte the stack has written.
+    uint8_t* sp = (uint8_t*)(uintptr_t)SP;
+    for (uint16_t n = 0; n < SCAN_CHUNK; ++n, ++s_cursor) {
+        if (s_cursor < sp && *s_cursor == CANARY) continue;
+        uint8_t* bottom = heapTop();
+        uint16_t headroom = s_cursor > bottom ? (uint16_t)(s_cursor - bottom) : 0;
+        if (headroom < s_minFree) s_minFree = headroom;
+        s_cursor = nullptr;
+        return;
+    }
+}
+
+uint16_t mem_monitor_staticBytes() {
+    return (uint16_t)(&__heap_start - &__data_start);
+}
+
+uint16_t mem_monitor_heapBytes() {
+    return (uint16_t)(heapTop() - &__heap_start);
+}
+
+uint16_t mem_monitor_freeNow() {
+    uint8_t* sp = (uint8_t*)(uintptr_t)SP;
+    uint8_t* top = heapTop();
+    return sp > top ? (uint16_t)(sp - top) : 0;
+}
+
+uint16_t mem_monitor_minFree() {
+    return s_minFree == 0xFFFF ? mem_monitor_freeNow() : s_minFree;
+}
+
+#else
+
+void mem_monitor_update(uint32_t) {}
+uint16_t mem_monitor_staticBytes() { return 0; }
+uint16_t mem_monitor_heapBytes() { return 0; }
+uint16_t mem_monitor_freeNow() { return 0; }
+uint16_t mem_monitor_minFree() { return 0; }
+
+#endif
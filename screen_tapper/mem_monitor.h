@@ -0,0 +1,28 @@
+#pragma once
+#include <stdint.h>
+
+// SRAM headroom monitor.
+//
+// Before any constructor runs, the free space between the heap and the top
+// of RAM is filled with a canary byte. The stack overwrites it as it grows,
+// so the canaries still intact above the heap give the least free memory
+// seen since boot. The rescan runs a slice per loop() and never blocks.
+//
+// tools/ram_report.py gives the matching static (.data + .bss) breakdown
+// per module from a build.
+
+// Rescan the painted region every kMemScanMs. Call once per loop().
+void mem_monitor_update(uint32_t nowMs);
+
+// .data + .bss bytes, fixed at link time.
+uint16_t mem_monitor_staticBytes();
+
+// Heap bytes in use (0 unless something calls malloc).
+uint16_t mem_monitor_heapBytes();
+
+// Bytes between the heap and the stack pointer right now.
+uint16_t mem_monitor_freeNow();
+
+// Least free bytes between heap and stack since boot, as of the last
+// completed scan.
+uint16_t mem_monitor_minFree();
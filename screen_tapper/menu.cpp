@@ -2,6 +2,7 @@
 // application, and provide a view model for the display renderer.
 
 #include "menu.h"
+#include "self_bench.h"
 #include <Arduino.h>
 
 // ---------------------------------------------------------------------------
@@ -18,19 +19,20 @@ static const char* const kSettingsItems[] = {
     "Set Gem Count",
     "Toggle Test Mode",
     "Override Sleep",
+    "Diagnostics",
+    "Self Benchmark",
+    "Adaptive Interval",
+    "Statistics",
 };
 static constexpr uint8_t kSettingsCount =
     sizeof(kSettingsItems) / sizeof(kSettingsItems[0]);
 
+// Scroll positions on the Benchmark screen, which shows six result rows.
+static constexpr uint8_t kSelfBenchRows = (uint8_t)SelfBenchCase::Count - 6 + 1;
+
 // ---------------------------------------------------------------------------
-// Editor limits
+// Editor units (limits are in menu.h)
 // ---------------------------------------------------------------------------
-static constexpr uint32_t TAP_MIN_MS   = 1;
-static constexpr uint32_t TAP_MAX_MS   = 1000;
-static constexpr uint32_t TAP_DUTY_MIN = 0;
-static constexpr uint32_t TAP_DUTY_MAX = 255;
-static constexpr uint32_t GEMS_MIN     = 0;
-static constexpr uint32_t GEMS_MAX     = 999999999;
 static constexpr const char* UNIT_MS   = "ms";
 static constexpr const char* UNIT_DUTY = "/255";
 static constexpr const char* UNIT_GEMS = "gems";
@@ -112,6 +114,41 @@ static bool update_settings(int d, bool pressed, MenuAction& act) {
         case 7: act.type = MenuActionType::SetGemCount;                                       return true;
         case 8: act.type = MenuActionType::ToggleTestMode;                                    return true;
         case 9: act.type = MenuActionType::ToggleOverrideSleep;                               return true;
+        case 10: s_screen = MenuScreen::Diagnostics;                                          return false;
+        case 11: s_screen = MenuScreen::SelfBench; s_sel = 0;
+                 act.type = MenuActionType::RunSelfBench;                                     return true;
+        case 12: act.type = MenuActionType::ToggleAdaptiveInterval;                           return true;
+        case 13: s_screen = MenuScreen::Stats; s_sel = 0;                                     return false;
+    }
+    return false;
+}
+
+// Read-only screen; press returns to its settings entry.
+static bool update_diagnostics(int d, bool pressed, MenuAction& act) {
+    if (pressed) {
+        enter_settings();
+        s_sel = 10;
+    }
+    return false;
+}
+
+// Self-benchmark results; the knob scrolls, press returns to its settings entry.
+static bool update_self_bench(int d, bool pressed, MenuAction& act) {
+    if (d != 0) s_sel = wrap((int)s_sel + (d > 0 ? +1 : -1), kSelfBenchRows);
+    if (pressed) {
+        enter_settings();
+        s_sel = 11;
+    }
+    return false;
+}
+
+// Yield sparkline; the knob switches hourly/daily bins, press returns to its
+// settings entry.
+static bool update_stats(int d, bool pressed, MenuAction& act) {
+    if (d != 0) s_sel = wrap((int)s_sel + (d > 0 ? +1 : -1), 2);
+    if (pressed) {
+        enter_settings();
+        s_sel = 13;
     }
     return false;
 }
@@ -237,6 +274,9 @@ bool menu_update(int encDelta, bool pressed, MenuAction& outAction) {
         case MenuScreen::EditGemCount:    return update_num_editor(encDelta, pressed, outAction, MenuActionType::SetGemCount);
         case MenuScreen::EditSleepTime:   return update_time_editor(encDelta, pressed, outAction, MenuActionType::SetSleepTime);
         case MenuScreen::EditWakeTime:    return update_time_editor(encDelta, pressed, outAction, MenuActionType::SetWakeTime);
+        case MenuScreen::Diagnostics:     return update_diagnostics(encDelta, pressed, outAction);
+        case MenuScreen::SelfBench:       return update_self_bench(encDelta, pressed, outAction);
+        case MenuScreen::Stats:           return update_stats(encDelta, pressed, outAction);
     }
     return false;
 }
@@ -311,6 +351,23 @@ void menu_getView(MenuView& v) {
             v.editingHour = s_timeOnHour;
             v.selected    = s_sel;
             break;
+
+        case MenuScreen::Diagnostics:
+            v.kind  = ViewKind::Diagnostics;
+            v.title = "Diagnostics";
+            break;
+
+        case MenuScreen::SelfBench:
+            v.kind     = ViewKind::Benchmark;
+            v.title    = "Benchmark";
+            v.selected = s_sel;
+            break;
+
+        case MenuScreen::Stats:
+            v.kind     = ViewKind::Stats;
+            v.title    = "Yield";
+            v.selected = s_sel;   // 0 = hourly, 1 = daily
+            break;
     }
 }
 
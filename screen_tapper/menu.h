@@ -12,8 +12,21 @@ enum class MenuScreen {
     EditSleepTime,
     EditWakeTime,
     EditGemCount,
+    Diagnostics,
+    SelfBench,
+    Stats,
 };
 
+// ---------------------------------------------------------------------------
+// Editor limits (shared with the serial console)
+// ---------------------------------------------------------------------------
+constexpr uint32_t TAP_MIN_MS   = 1;
+constexpr uint32_t TAP_MAX_MS   = 1000;
+constexpr uint32_t TAP_DUTY_MIN = 0;
+constexpr uint32_t TAP_DUTY_MAX = 255;
+constexpr uint32_t GEMS_MIN     = 0;
+constexpr uint32_t GEMS_MAX     = 999999999;
+
 // ---------------------------------------------------------------------------
 // Actions emitted by the menu to the application
 // ---------------------------------------------------------------------------
@@ -31,6 +44,8 @@ enum class MenuActionType {
     SetGemCount,           // u32  = new lifetime count
     ToggleTestMode,
     ToggleOverrideSleep,
+    RunSelfBench,          // start the self-benchmark (self_bench.h)
+    ToggleAdaptiveInterval,
 };
 
 struct MenuAction {
@@ -44,7 +59,24 @@ struct MenuAction {
 // ---------------------------------------------------------------------------
 // View model (what the renderer reads each frame)
 // ---------------------------------------------------------------------------
-enum class ViewKind { Home, List, EditNumber, EditTime };
+enum class ViewKind { Home, List, EditNumber, EditTime, Diagnostics, Benchmark, Stats };
+
+// Runtime health counters for the Diagnostics screen (filled by the app,
+// only while that screen is showing)
+struct DiagnosticsData {
+    uint32_t uptimeSec      = 0;
+    uint16_t loopsPerSec    = 0;
+    uint32_t maxLoopUs      = 0;
+    uint32_t framesRendered = 0;
+    uint32_t framesSkipped  = 0;
+    uint16_t rtcFailures    = 0;
+    uint32_t eepromWrites   = 0;
+    uint32_t slotWear       = 0;
+    uint32_t bitmapWear     = 0;
+    uint32_t tapCycles      = 0;
+    uint16_t ramMinFree     = 0;
+    uint8_t  heatPercent[2] = {};   // thermal budget used, ad and float channel
+};
 
 struct MenuView {
     ViewKind    kind  = ViewKind::Home;
@@ -59,6 +91,7 @@ struct MenuView {
     bool     overrideClock   = false;
     bool     testModeEnabled = false;
     uint16_t tapDuration     = 0;
+    uint32_t learnedIntervalMs = 0;   // base interval in use when learned, else 0
 
     // Sleep/wake times (injected by the app each frame)
     uint8_t sleepHour   = 0;
@@ -83,6 +116,14 @@ struct MenuView {
     uint8_t mm          = 0;
     bool    editingHour = true;
     bool    editingTime = false;
+
+    // Diagnostics
+    const DiagnosticsData* diag = nullptr;
+
+    // Set when this frame answers encoder or button input: inputUs is the
+    // earliest hal_micros() the edge can have happened, for ui_latency.h.
+    bool     hasInput = false;
+    uint32_t inputUs  = 0;
 };
 
 // Live data pushed to the home screen each frame
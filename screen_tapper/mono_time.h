@@ -0,0 +1,39 @@
+#pragma once
+#include <stdint.h>
+#include "hal.h"
+
+// Monotonic milliseconds since boot, 64 bits wide so they never wrap in
+// the device's lifetime (hal_millis() wraps after 49.7 days). Everything
+// that waits on a point in time keeps it as a Deadline and compares with
+// the helpers below instead of doing its own millis() arithmetic.
+
+typedef uint64_t MonoMs;
+
+inline MonoMs mono_nowMs() { return hal_millis64(); }
+
+struct Deadline {
+    MonoMs atMs = 0;    // 0 = already due
+};
+
+inline Deadline deadline_at(MonoMs atMs) {
+    Deadline d;
+    d.atMs = atMs;
+    return d;
+}
+
+inline Deadline deadline_in(MonoMs nowMs, uint32_t ms) { return deadline_at(nowMs + ms); }
+
+inline bool deadline_reached(const Deadline& d, MonoMs nowMs) { return nowMs >= d.atMs; }
+
+// Milliseconds until d, 0 once reached; saturates at UINT32_MAX.
+inline uint32_t deadline_leftMs(const Deadline& d, MonoMs nowMs) {
+    if (nowMs >= d.atMs) return 0;
+    MonoMs left = d.atMs - nowMs;
+    return left > UINT32_MAX ? UINT32_MAX : (uint32_t)left;
+}
+
+// Milliseconds since t, for elapsed-time checks against a recorded start.
+inline MonoMs mono_sinceMs(MonoMs t, MonoMs nowMs) { return nowMs > t ? nowMs - t : 0; }
+
+// Passes d on to hal_deadline() so the host simulator can skip to it.
+inline void deadline_announce(const Deadline& d) { hal_deadline((uint32_t)d.atMs); }
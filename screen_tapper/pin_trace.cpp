@@ -0,0 +1,104 @@
+#include "pin_trace.h"
+
+#ifdef PIN_TRACE
+
+#include "console.h"
+#include "hal.h"
+#include <Arduino.h>
+
+static_assert((kPinTraceSize & (kPinTraceSize - 1)) == 0, "kPinTraceSize must be a power of two");
+
+// Last duty per pin, so repeated writes of the same level are not
+// recorded. Pins beyond the table are recorded on every write.
+static constexpr uint8_t MAX_PINS = 4;
+
+static PinEdge  s_ring[kPinTraceSize];
+static uint8_t  s_head    = 0;       // next slot to write
+static uint8_t  s_count   = 0;
+static uint16_t s_dropped = 0;       // overwritten before being printed
+static uint8_t  s_pins[MAX_PINS];
+static uint8_t  s_duty[MAX_PINS];
+static uint8_t  s_pinCount = 0;
+
+// Dump progress: one line per pin_trace_service() call.
+static bool    s_dumping  = false;
+static uint8_t s_dumpNext = 0;
+
+// True if duty differs from the pin's last recorded write.
+static bool changed(uint8_t pin, uint8_t duty) {
+    for (uint8_t i = 0; i < s_pinCount; ++i) {
+        if (s_pins[i] != pin) continue;
+        if (s_duty[i] == duty) return false;
+        s_duty[i] = duty;
+        return true;
+    }
+    if (s_pinCount < MAX_PINS) {
+        s_pins[s_pinCount] = pin;
+        s_duty[s_pinCount] = duty;
+        s_pinCount++;
+    }
+    return true;
+}
+
+void pin_trace_record(uint8_t pin, uint8_t duty) {
+    uint8_t sreg = SREG;
+    cli();
+    if (changed(pin, duty)) {
+        PinEdge& e = s_ring[s_head];
+        e.us   = hal_micros();
+        e.pin  = pin;
+        e.duty = duty;
+        s_head = (uint8_t)((s_head + 1) & (kPinTraceSize - 1));
+        if (s_count < kPinTraceSize) s_count++;
+        else if (s_dropped < 0xFFFF) s_dropped++;
+    }
+    SREG = sreg;
+}
+
+void pin_trace_requestDump() {
+    s_dumping  = true;
+    s_dumpNext = 0;
+}
+
+void pin_trace_reset() {
+    uint8_t sreg = SREG;
+    cli();
+    s_count   = 0;
+    s_dropped = 0;
+    s_dumping = false;
+    SREG = sreg;
+}
+
+// Lines:  T <us> <pin> <duty>        oldest first
+//         T end n=<count> dropped=<n>
+void pin_trace_service() {
+    if (!s_dumping || !console_txIdle()) return;
+
+    uint8_t sreg = SREG;
+    cli();
+    uint8_t count = s_count;
+    PinEdge e;
+    bool    more  = s_dumpNext < count;
+    if (more) {
+        e = s_ring[(uint8_t)((s_head - count + s_dumpNext) & (kPinTraceSize - 1))];
+    }
+    uint16_t dropped = s_dropped;
+    SREG = sreg;
+
+    if (more) {
+        console_printf(PSTR("T %lu %u %u"), (unsigned long)e.us, e.pin, e.duty);
+        s_dumpNext++;
+    } else {
+        console_printf(PSTR("T end n=%u dropped=%u"), count, dropped);
+        s_dumping = false;
+    }
+}
+
+#else
+
+void pin_trace_record(uint8_t, uint8_t) {}
+void pin_trace_requestDump() {}
+void pin_trace_reset() {}
+void pin_trace_service() {}
+
+#endif
@@ -0,0 +1,29 @@
+#pragma once
+#include <stdint.h>
+#include "config.h"
+
+// Gate trace. Every hal_pwmWrite() that changes a pin's duty is stamped
+// with micros() into a ring of kPinTraceSize entries. "trace" on the serial
+// console prints it oldest first and "trace reset" empties it.
+//
+// Compiles away unless PIN_TRACE is defined in config.h. The host HAL keeps
+// its own unbounded trace as well, for VCD export and the pulse checks in
+// host/trace.h.
+
+struct PinEdge {
+    uint32_t us;     // micros() at the write
+    uint8_t  pin;
+    uint8_t  duty;   // 0 = gate off
+};
+
+// Called by the HAL for every PWM write; safe from interrupts.
+void pin_trace_record(uint8_t pin, uint8_t duty);
+
+// Start printing the trace through the console. No-op without PIN_TRACE.
+void pin_trace_requestDump();
+
+// Empty the trace. No-op without PIN_TRACE.
+void pin_trace_reset();
+
+// Emit pending dump lines while the console is idle. Call once per loop().
+void pin_trace_service();
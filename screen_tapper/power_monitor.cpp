@@ -0,0 +1,96 @@
+#include "power_monitor.h"
+#include "config.h"
+
+#if defined(POWER_FAIL_DETECT) && defined(__AVR__)
+
+#include "tapper.h"
+#include "gem_store.h"
+#include "eeprom_queue.h"
+#include <Arduino.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+static_assert(POWER_SENSE_ADC_CHANNEL < 8, "comparator mux setup assumes A0-A7");
+
+// Supply must read healthy this long before the monitor re-arms.
+static constexpr uint32_t RECOVERY_MS = 500;
+
+static volatile bool s_failing       = false;
+static uint32_t      s_healthySince  = 0;
+static bool          s_healthyTiming = false;
+
+// Comparator output is high while the sense voltage is below the bandgap.
+static bool supplyLow() {
+    return (ACSR & _BV(ACO)) != 0;
+}
+
+static void arm() {
+    ACSR &= (uint8_t)~_BV(ACIE);
+    ACSR |= _BV(ACI);   // clear any stale flag
+    ACSR |= _BV(ACIE);
+}
+
+// Hold-up budget: with solenoids off the board draws ~150 mA, so a 2200 uF
+// capacitor gives ~25 ms from 4.4 V down to the 2.7 V brown-out level. The
+// commit is two 3.4 ms byte writes queued ahead of everything else, so at
+// most one write already in flight delays it. The rest of the queue (up to
+// ~100 ms) is drained on a best-effort basis; the gem store's queue order
+// keeps a torn rebase safe. Uncommitted settings are not saved here: they
+// would cost ~24 more writes, and their last record is still valid.
+ISR(ANALOG_COMP_vect) {
+    tapper_stop();
+    ACSR &= (uint8_t)~_BV(ACIE);  // one shot until the supply recovers
+    s_failing = true;
+
+    gem_store_commit_on_power_fail();
+    eeprom_queue_flush();
+}
+
+void power_monitor_begin() {
+    // Route ADC channel POWER_SENSE_ADC_CHANNEL to the comparator's negative
+    // input; the bandgap drives the positive input.
+    ADCSRA &= (uint8_t)~_BV(ADEN);
+    ADCSRB  = (uint8_t)((ADCSRB | _BV(ACME)) & ~_BV(MUX5));
+    ADMUX   = (uint8_t)((ADMUX & ~0x07) | POWER_SENSE_ADC_CHANNEL);
+    DIDR0  |= _BV(POWER_SENSE_ADC_CHANNEL);
+
+    // Interrupt on the rising comparator output (supply falling).
+    ACSR = _BV(ACBG) | _BV(ACIS1) | _BV(ACIS0);
+    delayMicroseconds(100);  // bandgap settling
+
+    s_failing = supplyLow();
+    if (!s_failing) arm();
+}
+
+void power_monitor_update(uint32_t nowMs) {
+    if (!s_failing) return;
+
+    if (supplyLow()) {
+        s_healthyTiming = false;
+        return;
+    }
+    if (!s_healthyTiming) {
+        s_healthyTiming = true;
+        s_healthySince  = nowMs;
+        return;
+    }
+    if (nowMs - s_healthySince < RECOVERY_MS) return;
+
+    // Glitch survived without a reset: the session count is still in RAM.
+    s_healthyTiming = false;
+    gem_store_power_restored();
+    s_failing = false;
+    arm();
+}
+
+bool power_monitor_failing() {
+    return s_failing;
+}
+
+#else
+
+void power_monitor_begin() {}
+void power_monitor_update(uint32_t) {}
+bool power_monitor_failing() { return false; }
+
+#endif
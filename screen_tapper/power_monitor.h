@@ -0,0 +1,20 @@
+#pragma once
+#include <stdint.h>
+
+// Power-fail detection. The analog comparator watches the supply sense
+// divider against the internal bandgap. When the supply starts to fall the
+// interrupt cuts both solenoids and commits unsaved gems to EEPROM while the
+// hold-up capacitor still carries the board. Compiles to no-ops unless
+// POWER_FAIL_DETECT is defined in config.h.
+
+// Arm the comparator. Call in setup() after gem_store_begin(). The ADC is
+// switched off to route its multiplexer to the comparator, so analogRead()
+// must not be used afterwards.
+void power_monitor_begin();
+
+// Re-arm after the supply has been back for a while. Call once per loop().
+void power_monitor_update(uint32_t nowMs);
+
+// True from a power-fail event until the supply has recovered. The app must
+// not start tap cycles while this is set.
+bool power_monitor_failing();
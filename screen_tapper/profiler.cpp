@@ -0,0 +1,112 @@
+#include "profiler.h"
+
+#ifdef PROFILE
+
+#include "console.h"
+#include "loop_section.h"
+#include "hal.h"
+#include <Arduino.h>
+
+static constexpr uint8_t BUCKETS          = 16;
+static constexpr uint8_t BUCKETS_PER_LINE = 8;
+static constexpr uint8_t SECTIONS         = (uint8_t)LoopSection::Count;
+
+struct SectionStats {
+    uint32_t count;
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint16_t hist[BUCKETS];   // saturating
+};
+
+static SectionStats s_stats[SECTIONS];
+static uint32_t     s_lastMark[SECTIONS];
+
+// Dump progress: one line per profiler_service() call.
+static bool    s_dumping     = false;
+static uint8_t s_dumpSection = 0;
+static uint8_t s_dumpPart    = 0;   // 0 = summary, then histogram halves
+
+static uint8_t bucketFor(uint32_t us) {
+    uint8_t b = 0;
+    while (us && b < BUCKETS - 1) {
+        us >>= 1;
+        b++;
+    }
+    return b;
+}
+
+uint32_t ProfileScope::micros_() {
+    return hal_micros();
+}
+
+void profiler_record(LoopSection section, uint32_t us) {
+    SectionStats& s = s_stats[(uint8_t)section];
+    if (s.count == 0 || us < s.minUs) s.minUs = us;
+    if (us > s.maxUs) s.maxUs = us;
+    s.count++;
+    uint16_t& h = s.hist[bucketFor(us)];
+    if (h < 0xFFFF) h++;
+}
+
+void profiler_mark(LoopSection section) {
+    uint32_t now = hal_micros();
+    uint32_t& last = s_lastMark[(uint8_t)section];
+    if (last != 0) profiler_record(section, now - last);
+    last = now;
+}
+
+void profiler_requestDump() {
+    s_dumping     = true;
+    s_dumpSection = 0;
+    s_dumpPart    = 0;
+}
+
+void profiler_reset() {
+    memset(s_stats, 0, sizeof(s_stats));
+    memset(s_lastMark, 0, sizeof(s_lastMark));
+}
+
+// Lines:  P <name> n=<count> min=<us> max=<us>
+//         H <name> <first bucket>: <count> x8     (all-zero halves skipped)
+void profiler_service() {
+    if (!s_dumping || !console_txIdle()) return;
+
+    // Sections with no samples are skipped.
+    while (s_dumpSection < SECTIONS && s_stats[s_dumpSection].count == 0) s_dumpSection++;
+    if (s_dumpSection >= SECTIONS) {
+        s_dumping = false;
+        return;
+    }
+
+    const SectionStats& s = s_stats[s_dumpSection];
+    char name[12];
+    strcpy_P(name, loop_section_name((LoopSection)s_dumpSection));
+
+    if (s_dumpPart == 0) {
+        console_printf(PSTR("P %s n=%lu min=%lu max=%lu"), name,
+                       (unsigned long)s.count, (unsigned long)s.minUs,
+                       (unsigned long)s.maxUs);
+    } else {
+        const uint16_t* h = &s.hist[(s_dumpPart - 1) * BUCKETS_PER_LINE];
+        bool any = false;
+        for (uint8_t i = 0; i < BUCKETS_PER_LINE; ++i) any |= h[i] != 0;
+        if (any) {
+            console_printf(PSTR("H %s %u: %u %u %u %u %u %u %u %u"), name,
+                           (unsigned)((s_dumpPart - 1) * BUCKETS_PER_LINE),
+                           h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7]);
+        }
+    }
+
+    if (++s_dumpPart > BUCKETS / BUCKETS_PER_LINE) {
+        s_dumpPart = 0;
+        if (++s_dumpSection >= SECTIONS) s_dumping = false;
+    }
+}
+
+#else
+
+void profiler_requestDump() {}
+void profiler_reset() {}
+void profiler_service() {}
+
+#endif
@@ -0,0 +1,58 @@
+#pragma once
+#include <stdint.h>
+#include "config.h"
+
+// Section profiler. Each LoopSection collects micros() durations into a
+// power-of-two histogram plus min/max/count; "prof" on the serial console
+// prints them and "prof reset" clears them. micros() ticks in 4 us steps on
+// a 16 MHz board, so short sections land in the low buckets.
+//
+// Bucket 0 holds 0 us; bucket b (1-15) holds [2^(b-1), 2^b) us, with bucket
+// 15 open-ended (>= 16.4 ms).
+//
+// Everything compiles away unless PROFILE is defined in config.h. Code
+// normally uses LOOP_SECTION() from loop_section.h, which also feeds the
+// watchdog's section tracking; PROFILE_SCOPE() times without it.
+
+enum class LoopSection : uint8_t;   // loop_section.h
+
+#ifdef PROFILE
+
+// Add one sample.
+void profiler_record(LoopSection section, uint32_t us);
+
+// Times the enclosing scope.
+class ProfileScope {
+public:
+    explicit ProfileScope(LoopSection section) : m_section(section), m_start(micros_()) {}
+    ~ProfileScope() { profiler_record(m_section, micros_() - m_start); }
+private:
+    static uint32_t micros_();
+    LoopSection m_section;
+    uint32_t    m_start;
+};
+
+// Records the time since the previous mark of the same section.
+void profiler_mark(LoopSection section);
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b)  PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(section) \
+    ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(LoopSection::section)
+#define PROFILE_MARK(section) profiler_mark(LoopSection::section)
+
+#else
+
+#define PROFILE_SCOPE(section) do {} while (0)
+#define PROFILE_MARK(section)  do {} while (0)
+
+#endif
+
+// Start printing the histograms through the console. No-op without PROFILE.
+void profiler_requestDump();
+
+// Clear every section. No-op without PROFILE.
+void profiler_reset();
+
+// Emit pending dump lines while the console is idle. Call once per loop().
+void profiler_service();
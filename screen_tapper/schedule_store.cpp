@@ -0,0 +1,33 @@
+#include "schedule_store.h"
+#include "clock.h"
+#include "crc16.h"
+
+static constexpr uint8_t NVRAM_ADDR     = 0;
+static constexpr uint8_t RECORD_VERSION = 1;
+
+struct ScheduleRecord {
+    uint8_t  version;
+    uint32_t dueUnix;
+    uint16_t crc;
+} __attribute__((packed));
+static_assert(sizeof(ScheduleRecord) == 7, "record layout is persisted");
+
+static uint16_t recordCrc(const ScheduleRecord& r) {
+    return crc16(&r, offsetof(ScheduleRecord, crc));
+}
+
+bool schedule_store_load(uint32_t& dueUnix) {
+    ScheduleRecord r;
+    if (!clock_readNvram(NVRAM_ADDR, (uint8_t*)&r, sizeof(r))) return false;
+    if (r.version != RECORD_VERSION || r.crc != recordCrc(r)) return false;
+    dueUnix = r.dueUnix;
+    return true;
+}
+
+void schedule_store_save(uint32_t dueUnix) {
+    ScheduleRecord r;
+    r.version = RECORD_VERSION;
+    r.dueUnix = dueUnix;
+    r.crc     = recordCrc(r);
+    clock_writeNvram(NVRAM_ADDR, (const uint8_t*)&r, sizeof(r));
+}
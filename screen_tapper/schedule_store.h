@@ -0,0 +1,24 @@
+#pragma once
+#include <stdint.h>
+
+// =============================================================================
+// DS1307 NVRAM Layout
+//
+// Addr  Size  Contents
+// ----  ----  --------
+//  0     1    record version
+//  1-4   4    next tap due time (uint32_t, Unix seconds)
+//  5-6   2    CRC-16 over bytes 0-4
+//  7-55       reserved
+//
+// The deadline is stored as RTC-absolute time so it survives resets and
+// power loss: on boot the app resumes the original deadline instead of
+// restarting the interval from zero.
+// =============================================================================
+
+// Read the persisted next-tap deadline. Returns false if the RTC is
+// unavailable or the record is missing or corrupt.
+bool schedule_store_load(uint32_t& dueUnix);
+
+// Persist the next-tap deadline. Silently skipped without an RTC.
+void schedule_store_save(uint32_t dueUnix);
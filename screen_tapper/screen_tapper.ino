@@ -1,7 +1,6 @@
-#include <Wire.h>
-#include <RTClib.h>
-#include <EEPROM.h>
 #include "config.h"
+#include "hal.h"
+#include "mono_time.h"
 #include "clock.h"
 #include "tapper.h"
 #include "gem_store.h"
@@ -10,6 +9,24 @@
 #include "menu.h"
 #include "display.h"
 #include "settings_store.h"
+#include "eeprom_queue.h"
+#include "power_monitor.h"
+#include "schedule_store.h"
+#include "event_log.h"
+#include "sd_logger.h"
+#include "console.h"
+#include "profiler.h"
+#include "pin_trace.h"
+#include "lcd_mirror.h"
+#include "self_bench.h"
+#include "mem_monitor.h"
+#include "loop_section.h"
+#include "watchdog.h"
+#include "boot_timing.h"
+#include "interval_estimator.h"
+#include "stats.h"
+#include "ui_latency.h"
+#include "housekeeping.h"
 
 // ===========================================================================
 // Application state
@@ -30,9 +47,15 @@ SleepSchedule sched;
 bool deviceEnabled   = true;
 bool testModeEnabled = false;
 bool overrideClock   = false;
+bool adaptiveInterval = false;   // schedule from the learned interval
 
 // Tap scheduling
-unsigned long nextTapTime = 0;
+Deadline nextTap;
+
+// Loop statistics (Diagnostics screen)
+uint32_t uptimeSec   = 0;
+uint16_t loopsPerSec = 0;
+uint32_t maxLoopUs   = 0;
 
 // ===========================================================================
 // Helpers
@@ -44,52 +67,106 @@ static Settings currentSettings() {
     s.sched       = sched;
     s.tapDuration = tapDuration;
     s.tapDuty     = tapDuty;
+    s.intervals   = interval_estimator_history();
+    s.adaptiveInterval = adaptiveInterval;
     return s;
 }
 
+// The learned interval, when adaptive scheduling is on and has enough
+// samples. Test mode always keeps its own interval.
+static bool learnedIntervalMs(uint32_t& ms) {
+    return adaptiveInterval && !testModeEnabled && interval_estimator_estimateMs(ms);
+}
+
+// Interval scheduleNextTap() works from.
+static uint32_t baseIntervalMs() {
+    uint32_t ms;
+    return learnedIntervalMs(ms) ? ms : activeMode.baseIntervalMs;
+}
+
 // ===========================================================================
 // Forward declarations
 // ===========================================================================
 
 void scheduleNextTap();
+static void persistNextTap();
+static void restoreNextTap();
+static void resumeNextTap();
 static void handleMenuAction(const MenuAction& act);
 static MenuView buildMenuView(uint32_t msLeft);
+static ConsoleStatus buildConsoleStatus(uint32_t msLeft, bool awake);
+static void printBootBanner();
 
 // ===========================================================================
 // setup()
 // ===========================================================================
 
+// Only what the first loop() pass needs runs here. The LCD controller is
+// started by the first render and the serial banner goes out once the first
+// frame is on screen, so input is handled within a few tens of ms of reset.
 void setup() {
-    Serial.begin(9600);
+    boot_timing_begin();
+
+    // Gates low before anything else (watchdog_boot() already did it at the
+    // port level; this sets up the PWM pins properly).
+    tapper_begin(AD_GEMS_MOSFET_GATE_PIN, FLOAT_GEMS_MOSFET_GATE_PIN);
+    boot_timing_mark(BootPhase::Safe);
+
+    console_begin();
     randomSeed(analogRead(0));
-    delay(1000);
+    boot_timing_mark(BootPhase::Console);
 
     clock_begin();
+    boot_timing_mark(BootPhase::Clock);
 
     // Load persisted settings before initializing hardware that uses them.
+    eeprom_queue_begin();
     Settings s;
     settings_load(s);
     sched       = s.sched;
     tapDuration = s.tapDuration;
     tapDuty     = s.tapDuty;
-
+    adaptiveInterval = s.adaptiveInterval;
+    interval_estimator_begin(s.intervals);
     tapper_setDuty(tapDuty);
-    tapper_begin(AD_GEMS_MOSFET_GATE_PIN, FLOAT_GEMS_MOSFET_GATE_PIN);
+    boot_timing_mark(BootPhase::Settings);
 
     encoder_begin(ENCODER_CLK, ENCODER_DT, ENCODER_SW);
     button_begin(RESET_BUTTON_PIN);
     menu_begin();
     display_begin();
+    boot_timing_mark(BootPhase::Inputs);
 
     gem_store_begin();
+    stats_begin(hal_millis());
+    boot_timing_mark(BootPhase::GemStore);
+    power_monitor_begin();
+    boot_timing_mark(BootPhase::Power);
+
+    // Reset cause, and where a watchdog reset caught the loop.
+    event_log_add(EventType::Reset, (uint8_t)watchdog_resetCause(),
+                  (uint32_t)watchdog_lastSection());
+    restoreNextTap();
+    boot_timing_mark(BootPhase::Schedule);
+
+    // Armed last, once the blocking init above is done.
+    watchdog_begin();
+}
 
-    Serial.print(F("Lifetime gems: ")); Serial.println(gem_store_read_lifetime());
-    Serial.print(F("Sleep:         ")); Serial.print(sched.sleepHour); Serial.print(':'); Serial.println(sched.sleepMinute);
-    Serial.print(F("Wake:          ")); Serial.print(sched.wakeHour);  Serial.print(':'); Serial.println(sched.wakeMinute);
-    Serial.print(F("Tap duration:  ")); Serial.print(tapDuration); Serial.println(F(" ms"));
-    Serial.print(F("Tap duty:      ")); Serial.println(tapDuty);
-
-    scheduleNextTap();
+// Status lines that used to hold up setup(); sent from the first loop()
+// passes instead, with the boot timing after them.
+static void printBootBanner() {
+    console_printf(PSTR("boot gems=%lu"), (unsigned long)gem_store_read_lifetime());
+    console_printf(PSTR("sleep=%02u:%02u wake=%02u:%02u duration=%u duty=%u"),
+                   (unsigned)sched.sleepHour, (unsigned)sched.sleepMinute,
+                   (unsigned)sched.wakeHour, (unsigned)sched.wakeMinute,
+                   (unsigned)tapDuration, (unsigned)tapDuty);
+
+    char causeName[12], sectionName[12];
+    strcpy_P(causeName, watchdog_causeName(watchdog_resetCause()));
+    strcpy_P(sectionName, loop_section_name(watchdog_lastSection()));
+    console_printf(PSTR("reset cause=%s section=%s"), causeName, sectionName);
+    boot_timing_requestDump();
 }
 
 // ===========================================================================
@@ -97,46 +174,117 @@ void setup() {
 // ===========================================================================
 
 void loop() {
-    uint32_t now = millis();
+    MonoMs   tick = mono_nowMs();
+    uint32_t now  = (uint32_t)tick;   // for modules that only time short spans
+    uint32_t loopStartUs = hal_micros();
+    watchdog_feed();
+    PROFILE_MARK(LoopPeriod);
+    LOOP_SECTION(Loop);
+
+    // --- Loop statistics ---
+    static Deadline nextSecond;
+    static uint16_t loopsThisSecond = 0;
+    loopsThisSecond++;
+    bool secondTick = deadline_reached(nextSecond, tick);
+    if (secondTick) {
+        uint32_t elapsedSec = 1 + (uint32_t)(tick - nextSecond.atMs) / 1000;   // >1 after a long pass
+        nextSecond.atMs += elapsedSec * 1000UL;
+        uptimeSec       += elapsedSec;
+        loopsPerSec     = loopsThisSecond;
+        loopsThisSecond = 0;
+    }
 
     // --- Input: encoder ---
     // Processed before rendering so state changes appear in the same frame.
-    EncoderEvents ev = encoder_poll();
-    bool hadInput = (ev.delta != 0 || ev.pressed);
+    EncoderEvents ev;
+    {
+        LOOP_SECTION(EncoderPoll);
+        ev = encoder_poll();
+        self_bench_takeInput(ev);
+    }
+    bool     hadInput = (ev.delta != 0 || ev.pressed);
+    uint32_t inputUs  = ev.atUs;   // oldest edge this pass, for ui_latency
 
     MenuAction act;
-    bool actionFired = menu_update(ev.delta, ev.pressed, act);
+    bool actionFired;
+    {
+        LOOP_SECTION(MenuUpdate);
+        actionFired = menu_update(ev.delta, ev.pressed, act);
+    }
     if (actionFired) {
         handleMenuAction(act);
     }
+    boot_timing_mark(BootPhase::FirstInput);
 
     // --- Input: reset button ---
     // Reschedules the next tap immediately, regardless of device or sleep state.
+    // The first press after a cycle is also a sample for the adaptive interval.
     if (button_poll()) {
+        if (interval_estimator_ready(now)) settings_save(currentSettings());
         scheduleNextTap();
+        if (!hadInput) inputUs = button_pressUs();
         hadInput = true;
         display_markDirty();
-        Serial.println(F("Reset button: next tap rescheduled"));
+        console_printf(PSTR("reset button: next tap rescheduled"));
     }
 
     // --- Sleep/wake transition ---
+    // Waking (including the first loop after boot) keeps the pending deadline.
+    // Going to sleep queues the nightly housekeeping, which commits pending
+    // settings edits, today's statistics and the partial log block first.
     static bool wasAwake = false;
-    bool awake = overrideClock || clock_isAwake(sched);
-    if (awake && !wasAwake) scheduleNextTap();
+    bool awake = overrideClock;
+    if (!awake) {
+        LOOP_SECTION(ClockIsAwake);
+        awake = clock_isAwake(sched);
+    }
+    stats_blocked(now, !awake || !deviceEnabled, baseIntervalMs());
+    if (awake && !wasAwake) {
+        event_log_add(EventType::Wake);
+        resumeNextTap();
+    }
+    if (!awake && wasAwake) {
+        LOOP_SECTION(Storage);
+        event_log_add(EventType::Sleep);
+        interval_estimator_invalidate();
+        housekeeping_requestAll();
+    }
     wasAwake = awake;
 
+    // --- Deferred settings commit ---
+    {
+        LOOP_SECTION(Storage);
+        settings_update(now);
+        if (secondTick) stats_update(now);
+    }
+
+    // --- Power-fail guard ---
+    // The power-fail interrupt already cut the solenoids; keep them off in
+    // case it landed mid-update, and hold off new cycles until power is back.
+    power_monitor_update(now);
+    bool powerOk = !power_monitor_failing();
+    if (!powerOk) tapper_stop();
+
     // --- Advance tapper state machine ---
-    tapper_update(now);
+    {
+        LOOP_SECTION(TapperUpdate);
+        tapper_update(tick);
+    }
 
     // --- Fire a tap cycle when it's time ---
-    if (!tapper_isActive() && deviceEnabled && awake && (int32_t)(now - nextTapTime) >= 0) {
+    // No new cycles while the self-benchmark runs: the solenoids stay off.
+    bool waitingToTap = !tapper_isActive() && deviceEnabled && awake && powerOk &&
+                        !self_bench_running();
+    if (waitingToTap) deadline_announce(nextTap);
+    if (waitingToTap && deadline_reached(nextTap, tick)) {
         tapper_startCycle(
             activeMode.adGemTaps,
             activeMode.floatGemTaps,
             tapDuration,
             activeMode.pauseBetweenTapsMs,
-            now
+            tick
         );
+        if (!testModeEnabled) interval_estimator_cycleStarted(now);
 
         // Gem accounting: 5 gems per activation, +2 bonus every 6th activation.
         // TODO: refine once earning rates are fully characterized.
@@ -148,19 +296,22 @@ void loop() {
             activationCount = 0;
         }
         gem_store_add_session(earned);
+        stats_cycleFired((uint8_t)earned);
         scheduleNextTap();
     }
 
     // --- Compute msLeft ---
     // When the device is off, force to zero so the display shows 00:00.
-    uint32_t msLeft = 0;
-    if (deviceEnabled) {
-        int32_t dt = (int32_t)(nextTapTime - now);
-        if (dt > 0) msLeft = (uint32_t)dt;
-    }
+    uint32_t msLeft = deviceEnabled ? deadline_leftMs(nextTap, tick) : 0;
 
     // --- Render display ---
-    MenuView v = buildMenuView(msLeft);
+    MenuView v;
+    {
+        LOOP_SECTION(BuildMenuView);
+        v = buildMenuView(msLeft);
+        v.hasInput = hadInput;
+        v.inputUs  = inputUs;
+    }
 
     if (hadInput || actionFired) {
         display_markDirty();
@@ -169,13 +320,67 @@ void loop() {
         static uint32_t lastSecondsLeft = UINT32_MAX;
         static uint32_t lastGems        = UINT32_MAX;
         uint32_t secondsLeft = msLeft / 1000;
-        if (secondsLeft != lastSecondsLeft || v.lifetimeGems != lastGems) {
+        bool diagTick = secondTick && (v.kind == ViewKind::Diagnostics ||
+                                       v.kind == ViewKind::Benchmark ||
+                                       v.kind == ViewKind::Stats);
+        if (secondsLeft != lastSecondsLeft || v.lifetimeGems != lastGems || diagTick) {
             display_markDirty();
             lastSecondsLeft = secondsLeft;
             lastGems        = v.lifetimeGems;
         }
         display_render(v);
     }
+
+    // --- Deferred boot output ---
+    static bool bootReported = false;
+    if (!bootReported && display_framesRendered() > 0) {
+        boot_timing_mark(BootPhase::FirstFrame);
+        printBootBanner();
+        bootReported = true;
+    }
+
+    // --- Serial console ---
+    // Commands change settings through the same handler as the knob. Event
+    // log and LCD mirror frames only go out between console lines.
+    {
+        LOOP_SECTION(Console);
+        MenuAction cmd;
+        if (console_update(now, buildConsoleStatus(msLeft, awake), cmd)) {
+            handleMenuAction(cmd);
+        }
+        if (console_txIdle()) event_log_service();
+        profiler_service();
+        boot_timing_service();
+        pin_trace_service();
+        stats_service();
+        ui_latency_service();
+        lcd_mirror_service();
+    }
+    mem_monitor_update(now);
+    {
+        LOOP_SECTION(SdLogger);
+        // The card is started once the first frame is up, so a slow or
+        // missing card never holds up the first input or frame.
+        static bool sdStarted = false;
+        if (!sdStarted && boot_timing_at(BootPhase::FirstFrame) != 0) {
+            sd_logger_begin();
+            boot_timing_mark(BootPhase::SdLogger);
+            sdStarted = true;
+        }
+        sd_logger_service(now);
+    }
+    {
+        LOOP_SECTION(SelfBench);
+        self_bench_service();
+    }
+    {
+        LOOP_SECTION(Housekeeping);
+        housekeeping_service(!awake && !tapper_isActive());
+    }
+
+    uint32_t loopUs = hal_micros() - loopStartUs;
+    if (loopUs > maxLoopUs) maxLoopUs = loopUs;
+    if (loopUs > kLoopOverrunMs * 1000UL) event_log_add(EventType::LoopOverrun, 0, loopUs);
 }
 
 // ===========================================================================
@@ -186,14 +391,57 @@ void scheduleNextTap() {
     long jitter = random(-(long)activeMode.jitterRangeMs, (long)activeMode.jitterRangeMs);
 
     bool addBreak = !testModeEnabled && (random(12) == 0);
-    unsigned long base = millis() + activeMode.baseIntervalMs;
+    long offsetMs = (long)baseIntervalMs() + jitter;
     if (addBreak) {
-        base += (unsigned long)random(3UL * 60 * 1000, 8UL * 60 * 1000);
+        offsetMs += random(3L * 60 * 1000, 8L * 60 * 1000);
+    }
+    if (offsetMs < 0) offsetMs = 0;
+    nextTap = deadline_in(mono_nowMs(), (uint32_t)offsetMs);
+
+    persistNextTap();
+}
+
+// Mirror nextTap into RTC NVRAM as an absolute deadline.
+static void persistNextTap() {
+    uint32_t nowUnix;
+    if (!clock_nowUnix(nowUnix)) return;
+    uint32_t msLeft = deadline_leftMs(nextTap, mono_nowMs());
+    schedule_store_save(nowUnix + (msLeft + 500) / 1000);
+}
+
+// Boot: pick up the deadline persisted before the reset. An expired deadline
+// is due now; one further out than any interval scheduleNextTap() can produce
+// means the RTC was changed, so a fresh interval is scheduled instead.
+static void restoreNextTap() {
+    uint32_t dueUnix, nowUnix;
+    if (!schedule_store_load(dueUnix) || !clock_nowUnix(nowUnix)) {
+        scheduleNextTap();
+        return;
+    }
+
+    MonoMs now = mono_nowMs();
+    if ((int32_t)(dueUnix - nowUnix) <= 0) {
+        nextTap = deadline_at(now);
+        return;
+    }
+
+    uint32_t secondsLeft = dueUnix - nowUnix;
+    uint32_t maxMs = baseIntervalMs() + activeMode.jitterRangeMs + 8UL * 60 * 1000;
+    if (secondsLeft > maxMs / 1000) {
+        scheduleNextTap();
+        return;
     }
+    nextTap = deadline_in(now, secondsLeft * 1000UL);
+}
 
-    long adjusted = (long)base + jitter;
-    if (adjusted < 0) adjusted = 0;
-    nextTapTime = (unsigned long)adjusted;
+// Wake transition: keep a pending deadline. One that expired during sleep or
+// while powered off fires after a short random delay rather than waiting out
+// a whole new interval.
+static void resumeNextTap() {
+    MonoMs now = mono_nowMs();
+    if (!deadline_reached(nextTap, now)) return;
+    nextTap = deadline_in(now, (uint32_t)random((long)activeMode.jitterRangeMs + 1));
+    persistNextTap();
 }
 
 // ===========================================================================
@@ -201,6 +449,18 @@ void scheduleNextTap() {
 // ===========================================================================
 
 static void handleMenuAction(const MenuAction& act) {
+    // Log every action that changes state: saved editors and one-shot toggles.
+    bool toggle = act.type == MenuActionType::ToggleDeviceEnabled ||
+                  act.type == MenuActionType::ResetNextTap ||
+                  act.type == MenuActionType::ToggleTestMode ||
+                  act.type == MenuActionType::ToggleOverrideSleep ||
+                  act.type == MenuActionType::ToggleAdaptiveInterval;
+    if (act.committed || toggle) {
+        uint32_t value = (act.type == MenuActionType::SetGemCount) ? act.u32
+                       : act.u16a | ((uint32_t)act.u16b << 16);
+        event_log_add(EventType::MenuCommit, (uint8_t)act.type, value);
+    }
+
     switch (act.type) {
 
         case MenuActionType::GoHome:
@@ -212,6 +472,7 @@ static void handleMenuAction(const MenuAction& act) {
             deviceEnabled = !deviceEnabled;
             if (!deviceEnabled) {
                 tapper_stop();
+                interval_estimator_invalidate();
             } else {
                 scheduleNextTap();
             }
@@ -291,6 +552,7 @@ static void handleMenuAction(const MenuAction& act) {
         case MenuActionType::ToggleTestMode:
             testModeEnabled = !testModeEnabled;
             activeMode      = testModeEnabled ? kModeTest : kModeActual;
+            interval_estimator_invalidate();
             scheduleNextTap();
             menu_reset();
             display_markDirty();
@@ -302,6 +564,19 @@ static void handleMenuAction(const MenuAction& act) {
             display_markDirty();
             break;
 
+        case MenuActionType::ToggleAdaptiveInterval:
+            adaptiveInterval = !adaptiveInterval;
+            settings_save(currentSettings());
+            scheduleNextTap();
+            menu_reset();
+            display_markDirty();
+            break;
+
+        case MenuActionType::RunSelfBench:
+            self_bench_start();
+            display_markDirty();
+            break;
+
         default:
             break;
     }
@@ -330,6 +605,47 @@ static MenuView buildMenuView(uint32_t msLeft) {
     v.overrideClock   = overrideClock;
     v.tapDuration     = tapDuration;
     v.testModeEnabled = testModeEnabled;
+    if (!learnedIntervalMs(v.learnedIntervalMs)) v.learnedIntervalMs = 0;
+
+    // Counters are only gathered while the Diagnostics screen is showing.
+    if (v.kind == ViewKind::Diagnostics) {
+        static DiagnosticsData diag;
+        diag.uptimeSec      = uptimeSec;
+        diag.loopsPerSec    = loopsPerSec;
+        diag.maxLoopUs      = maxLoopUs;
+        diag.framesRendered = display_framesRendered();
+        diag.framesSkipped  = display_framesSkipped();
+        diag.rtcFailures    = clock_readFailures();
+        diag.eepromWrites   = eeprom_queue_writes();
+        diag.slotWear       = gem_store_slot_wear();
+        diag.bitmapWear     = gem_store_bitmap_wear();
+        diag.tapCycles      = tapper_cyclesCompleted();
+        diag.ramMinFree     = mem_monitor_minFree();
+        diag.heatPercent[0] = tapper_heatPercent(0);
+        diag.heatPercent[1] = tapper_heatPercent(1);
+        v.diag = &diag;
+    }
 
     return v;
 }
+
+static ConsoleStatus buildConsoleStatus(uint32_t msLeft, bool awake) {
+    ConsoleStatus st;
+    st.msLeft        = msLeft;
+    st.lifetimeGems  = gem_store_total();
+    st.tapDuration   = tapDuration;
+    st.tapDuty       = (uint8_t)tapDuty;
+    st.sleepHour     = sched.sleepHour;
+    st.sleepMinute   = sched.sleepMinute;
+    st.wakeHour      = sched.wakeHour;
+    st.wakeMinute    = sched.wakeMinute;
+    st.deviceEnabled = deviceEnabled;
+    st.awake         = awake;
+    st.tapping       = tapper_isActive();
+    st.testMode      = testModeEnabled;
+    st.overrideClock = overrideClock;
+    st.adaptive      = adaptiveInterval;
+    st.baseIntervalMs  = baseIntervalMs();
+    st.intervalSamples = interval_estimator_history().count;
+    return st;
+}
@@ -0,0 +1,448 @@
+#include "sd_logger.h"
+#include "config.h"
+
+#ifdef SD_LOGGING
+
+#include "block_device.h"
+#include "crc16.h"
+#include "hal.h"
+#include <Arduino.h>
+#include <string.h>
+
+static constexpr uint32_t MAGIC             = 0x474C5453;  // "STLG"
+static constexpr uint8_t  VERSION           = 1;
+static constexpr uint16_t HEADER_SIZE       = 14;
+static constexpr uint8_t  RECORDS_PER_BLOCK = (BLOCK_SIZE - HEADER_SIZE - 2) / sizeof(EventRecord);
+static constexpr uint16_t CRC_OFFSET        = BLOCK_SIZE - 2;
+static constexpr uint8_t  MAX_RETRIES       = 3;
+
+static_assert(HEADER_SIZE + RECORDS_PER_BLOCK * sizeof(EventRecord) == CRC_OFFSET,
+              "block layout must fill the block exactly");
+static_assert(BLOCK_SIZE % kSdSliceBytes == 0, "slices must tile the block");
+
+// Two block buffers: one fills from event_log_add() while the other is sent
+// to the card. A buffer is sealed when full (or synced) and only returns to
+// the filling side once its write has completed.
+static uint8_t          s_buf[2][BLOCK_SIZE];
+static volatile uint8_t s_count[2];
+static volatile bool    s_sealed[2];
+static volatile uint8_t s_fill      = 0;   // buffer receiving records
+static uint32_t         s_fillStart = 0;   // time of its first record
+static volatile uint16_t s_dropped  = 0;
+
+enum class WriteState : uint8_t { Idle, Sending, Programming };
+static WriteState s_state   = WriteState::Idle;
+static uint8_t    s_next    = 0;   // next buffer to write (sealed in order)
+static uint16_t   s_offset  = 0;   // bytes of the block sent so far
+static uint16_t   s_crc     = 0;
+static uint8_t    s_retries = 0;
+
+static bool     s_active     = false;
+static uint32_t s_firstBlock = 0;
+static uint32_t s_blockCount = 0;
+static uint32_t s_index      = 0;  // next block within the region
+static uint32_t s_seq        = 0;  // sequence number of that block
+
+// Boot-time scan, one block read per sd_logger_service() call: the FAT walk
+// that sizes the region, then the search for the resume point.
+enum class ScanState : uint8_t { Off, Chain, ResumeFirst, ResumeSearch };
+static ScanState s_scan = ScanState::Off;
+static uint32_t  s_seq0 = 0;       // sequence number of region block 0
+static uint32_t  s_lo   = 0;       // newest block known to be current
+static uint32_t  s_hi   = 0;       // first block known not to be
+
+// ---------------------------------------------------------------------------
+// Little-endian helpers
+// ---------------------------------------------------------------------------
+
+static uint16_t get16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get32(const uint8_t* p) {
+    return (uint32_t)get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+// ---------------------------------------------------------------------------
+// Region lookup
+// ---------------------------------------------------------------------------
+
+#ifdef SD_LOG_RAW
+
+static bool findRegion(uint8_t*) {
+    s_firstBlock = kSdRawFirstBlock;
+    s_blockCount = kSdRawBlockCount;
+    s_scan       = ScanState::ResumeFirst;
+    return true;
+}
+
+// The raw range needs no FAT walk.
+static bool chainStep(uint8_t*) {
+    return true;
+}
+
+#else
+
+struct FatVolume {
+    uint32_t fatStart;
+    uint32_t dataStart;
+    uint32_t rootStart;     // FAT16: first root-directory block
+    uint32_t rootBlocks;    // FAT16: root-directory length; FAT32: one cluster
+    uint32_t rootCluster;   // FAT32 only
+    uint8_t  blocksPerCluster;
+    bool     fat32;
+};
+
+static bool isBootSector(const uint8_t* b) {
+    return (b[0] == 0xEB || b[0] == 0xE9) && get16(b + 11) == BLOCK_SIZE &&
+           b[13] != 0 && b[16] != 0;
+}
+
+static bool mountVolume(uint8_t* buf, FatVolume& v) {
+    if (!blockdev_read(0, buf) || get16(buf + 510) != 0xAA55) return false;
+
+    // Superfloppy cards have the boot sector at block 0, others an MBR.
+    uint32_t start = 0;
+    if (!isBootSector(buf)) {
+        start = get32(buf + 0x1BE + 8);  // first partition
+        if (!blockdev_read(start, buf) || !isBootSector(buf)) return false;
+    }
+
+    uint16_t reserved   = get16(buf + 14);
+    uint8_t  fats       = buf[16];
+    uint16_t rootEnts   = get16(buf + 17);
+    uint32_t fatBlocks  = get16(buf + 22) ? get16(buf + 22) : get32(buf + 36);
+    uint32_t rootBlocks = ((uint32_t)rootEnts * 32 + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+    v.blocksPerCluster = buf[13];
+    v.fat32      = rootEnts == 0;
+    v.fatStart   = start + reserved;
+    v.rootStart  = v.fatStart + fats * fatBlocks;
+    v.dataStart  = v.rootStart + rootBlocks;
+    v.rootBlocks = rootBlocks;
+    if (v.fat32) {
+        v.rootCluster = get32(buf + 44);
+        v.rootStart   = v.dataStart + (v.rootCluster - 2) * v.blocksPerCluster;
+        v.rootBlocks  = v.blocksPerCluster;
+    }
+    return true;
+}
+
+static FatVolume s_vol;
+static uint32_t  s_firstCluster = 0;
+static uint32_t  s_maxClusters  = 0;   // LOG.BIN's size in clusters
+static uint32_t  s_run          = 0;   // contiguous clusters confirmed so far
+
+static uint32_t fatEntriesPerBlock() {
+    return s_vol.fat32 ? BLOCK_SIZE / 4 : BLOCK_SIZE / 2;
+}
+
+// FAT entry of cluster from buf, which holds the FAT block containing it.
+// 0 at the end of the chain.
+static uint32_t fatEntry(const uint8_t* buf, uint32_t cluster) {
+    uint16_t i = (uint16_t)(cluster % fatEntriesPerBlock());
+    uint32_t next = s_vol.fat32 ? get32(buf + i * 4) & 0x0FFFFFFF : get16(buf + i * 2);
+    uint32_t eoc  = s_vol.fat32 ? 0x0FFFFFF8 : 0xFFF8;
+    return (next < 2 || next >= eoc) ? 0 : next;
+}
+
+// Follows the chain through one FAT block: a single read covers 128 (FAT32)
+// or 256 (FAT16) clusters. Returns true once the run has ended and
+// s_blockCount is set; a read error leaves the region empty.
+static bool chainStep(uint8_t* buf) {
+    uint32_t c        = s_firstCluster + s_run - 1;   // last confirmed cluster
+    uint32_t fatBlock = c / fatEntriesPerBlock();
+    bool     ended    = !blockdev_read(s_vol.fatStart + fatBlock, buf);
+    if (ended) s_run = 0;
+    while (!ended && s_run < s_maxClusters && c / fatEntriesPerBlock() == fatBlock) {
+        if (fatEntry(buf, c) != c + 1) {
+            ended = true;
+        } else {
+            s_run++;
+            c++;
+        }
+    }
+    if (!ended && s_run < s_maxClusters) return false;
+    s_blockCount = s_run * s_vol.blocksPerCluster;
+    return true;
+}
+
+// Uses the contiguous leading run of LOG.BIN's clusters. Only the first
+// root-directory cluster is searched on FAT32, which is where the file lands
+// when created on a fresh card. Mounts and finds the file; chainStep()
+// measures the run.
+static bool findRegion(uint8_t* buf) {
+    FatVolume& v = s_vol;
+    if (!mountVolume(buf, v)) return false;
+
+    uint32_t cluster = 0, size = 0;
+    for (uint32_t b = 0; b < v.rootBlocks && cluster == 0; ++b) {
+        if (!blockdev_read(v.rootStart + b, buf)) return false;
+        for (uint16_t e = 0; e < BLOCK_SIZE; e += 32) {
+            const uint8_t* d = buf + e;
+            if (d[0] == 0x00) return false;  // end of directory
+            if (d[0] == 0xE5 || (d[11] & 0x18)) continue;  // deleted, dir, label
+            if (memcmp(d, "LOG     BIN", 11) != 0) continue;
+            cluster = ((uint32_t)get16(d + 20) << 16) | get16(d + 26);
+            size    = get32(d + 28);
+            break;
+        }
+    }
+    if (cluster < 2) return false;
+
+    s_firstCluster = cluster;
+    s_maxClusters  = size / BLOCK_SIZE / v.blocksPerCluster;
+    s_run          = 1;
+    s_firstBlock   = v.dataStart + (cluster - 2) * v.blocksPerCluster;
+    s_scan         = ScanState::Chain;
+    return s_maxClusters > 0;
+}
+
+#endif
+
+// ---------------------------------------------------------------------------
+// Resume point
+// ---------------------------------------------------------------------------
+
+// Reads region block i and returns its sequence number if it is a valid
+// log block, else false.
+static bool readBlockSeq(uint8_t* buf, uint32_t i, uint32_t& seq) {
+    if (!blockdev_read(s_firstBlock + i, buf)) return false;
+    if (get32(buf) != MAGIC || buf[13] != VERSION) return false;
+    if (crc16(buf, CRC_OFFSET) != get16(buf + CRC_OFFSET)) return false;
+    seq = get32(buf + 4);
+    return true;
+}
+
+// Blocks of the current pass through the ring satisfy seq == seq0 + i, where
+// seq0 belongs to block 0; blocks left over from the previous pass are
+// exactly blockCount behind and fail the test. The newest block is the last
+// one that passes, found by binary search, one probe per call. Returns true
+// once s_index and s_seq are set.
+static bool resumeStep(uint8_t* buf) {
+    if (s_scan == ScanState::ResumeFirst) {
+        if (!readBlockSeq(buf, 0, s_seq0)) {
+            s_index = 0;
+            s_seq   = 0;
+            return true;
+        }
+        s_lo   = 0;
+        s_hi   = s_blockCount;
+        s_scan = ScanState::ResumeSearch;
+        return false;
+    }
+
+    if (s_hi - s_lo > 1) {
+        uint32_t mid = s_lo + (s_hi - s_lo) / 2;
+        uint32_t seq;
+        if (readBlockSeq(buf, mid, seq) && seq - s_seq0 == mid) s_lo = mid;
+        else                                                    s_hi = mid;
+        return false;
+    }
+    s_index = (s_lo + 1) % s_blockCount;
+    s_seq   = s_seq0 + s_lo + 1;
+    return true;
+}
+
+// Advances the boot-time scan by one block read; the logger goes active
+// when it completes. The scan borrows the first block buffer, which stays
+// empty until then.
+static void scanStep() {
+    uint8_t* buf = s_buf[0];
+    if (s_scan == ScanState::Chain) {
+        if (!chainStep(buf)) return;
+        if (s_blockCount == 0) {
+            s_scan = ScanState::Off;
+            return;
+        }
+        s_scan = ScanState::ResumeFirst;
+        return;
+    }
+    if (!resumeStep(buf)) return;
+    s_scan   = ScanState::Off;
+    s_active = true;
+}
+
+// ---------------------------------------------------------------------------
+// Buffer handling
+// ---------------------------------------------------------------------------
+
+// Call with interrupts disabled.
+static void seal() {
+    s_sealed[s_fill] = true;
+    s_fill ^= 1;
+}
+
+static void releaseBuffer(uint8_t i) {
+    uint8_t sreg = SREG;
+    cli();
+    s_count[i]  = 0;
+    s_sealed[i] = false;
+    SREG = sreg;
+}
+
+// Fills in the header and zeroes unused record slots of a sealed buffer.
+static void prepareBlock(uint8_t i) {
+    uint8_t* b = s_buf[i];
+    uint8_t  n = s_count[i];
+    put32(b, MAGIC);
+    put32(b + 4, s_seq);
+    b[12] = n;
+    b[13] = VERSION;
+    memset(b + HEADER_SIZE + n * sizeof(EventRecord), 0,
+           (RECORDS_PER_BLOCK - n) * sizeof(EventRecord));
+}
+
+// The CRC is accumulated slice by slice; the final slice carries it.
+static bool sendSlice() {
+    uint8_t* b   = s_buf[s_next];
+    uint16_t end = s_offset + kSdSliceBytes;
+    s_crc = crc16(b + s_offset, (end > CRC_OFFSET ? CRC_OFFSET : end) - s_offset, s_crc);
+    if (end == BLOCK_SIZE) {
+        b[CRC_OFFSET]     = (uint8_t)(s_crc & 0xFF);
+        b[CRC_OFFSET + 1] = (uint8_t)(s_crc >> 8);
+    }
+    if (!blockdev_writeData(b + s_offset, kSdSliceBytes)) return false;
+    s_offset = end;
+    return true;
+}
+
+static void writeFailed() {
+    s_state = WriteState::Idle;
+    if (++s_retries >= MAX_RETRIES) s_active = false;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+void sd_logger_begin() {
+    s_active = false;
+    s_scan   = ScanState::Off;
+    s_fill   = 0;
+    s_next   = 0;
+    s_state  = WriteState::Idle;
+    for (uint8_t i = 0; i < 2; ++i) {
+        s_count[i]  = 0;
+        s_sealed[i] = false;
+    }
+
+    s_blockCount = 0;
+    if (!blockdev_begin() || !findRegion(s_buf[0])) s_scan = ScanState::Off;
+}
+
+void sd_logger_append(const EventRecord& r, uint32_t baseMs) {
+    if (!s_active) return;
+    uint8_t i = s_fill;
+    if (s_sealed[i]) {
+        if (s_dropped < 0xFFFF) s_dropped++;
+        return;
+    }
+
+    uint8_t  n = s_count[i];
+    uint8_t* b = s_buf[i];
+    if (n == 0) {
+        put32(b + 8, baseMs);
+        s_fillStart = r.type == EventType::TimeSync ? r.a32 : baseMs + r.dtMs;
+    }
+    memcpy(b + HEADER_SIZE + n * sizeof(EventRecord), &r, sizeof(r));
+    s_count[i] = ++n;
+    if (n == RECORDS_PER_BLOCK) seal();
+}
+
+void sd_logger_sync() {
+    uint8_t sreg = SREG;
+    cli();
+    if (s_active && !s_sealed[s_fill] && s_count[s_fill] > 0) seal();
+    SREG = sreg;
+}
+
+void sd_logger_service(uint32_t nowMs) {
+    if (!s_active) {
+        if (s_scan == ScanState::Off) return;
+        // Keep the host simulator stepping instead of skipping to the next deadline.
+        hal_deadline(nowMs);
+        scanStep();
+        return;
+    }
+
+    if (nowMs - s_fillStart >= kSdSyncMs) sd_logger_sync();
+    else if (s_count[s_fill] > 0) hal_deadline(s_fillStart + kSdSyncMs);
+    if (s_state != WriteState::Idle || s_sealed[s_next]) hal_deadline(nowMs);
+
+    switch (s_state) {
+    case WriteState::Idle:
+        if (!s_sealed[s_next]) return;
+        prepareBlock(s_next);
+        if (!blockdev_writeBegin(s_firstBlock + s_index)) {
+            writeFailed();
+            return;
+        }
+        s_offset = 0;
+        s_crc    = 0xFFFF;
+        s_state  = WriteState::Sending;
+        return;
+
+    case WriteState::Sending:
+        if (!sendSlice()) {
+            writeFailed();
+            return;
+        }
+        if (s_offset < BLOCK_SIZE) return;
+        if (!blockdev_writeEnd()) {
+            writeFailed();
+            return;
+        }
+        s_state = WriteState::Programming;
+        return;
+
+    case WriteState::Programming:
+        switch (blockdev_poll()) {
+        case BlockStatus::Busy:
+            return;
+        case BlockStatus::Error:
+            writeFailed();
+            return;
+        case BlockStatus::Ready:
+            break;
+        }
+        releaseBuffer(s_next);
+        s_next ^= 1;
+        s_seq++;
+        s_index   = (s_index + 1) % s_blockCount;
+        s_retries = 0;
+        s_state   = WriteState::Idle;
+        return;
+    }
+}
+
+bool sd_logger_active() {
+    return s_active;
+}
+
+uint32_t sd_logger_regionBlocks() {
+    return s_active ? s_blockCount : 0;
+}
+
+uint16_t sd_logger_dropped() {
+    return s_dropped;
+}
+
+#else
+
+void sd_logger_begin() {}
+void sd_logger_append(const EventRecord&, uint32_t) {}
+void sd_logger_sync() {}
+void sd_logger_service(uint32_t) {}
+bool sd_logger_active() { return false; }
+uint32_t sd_logger_regionBlocks() { return 0; }
+uint16_t sd_logger_dropped() { return 0; }
+
+#endif
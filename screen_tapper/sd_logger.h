@@ -0,0 +1,47 @@
+#pragma once
+#include <stdint.h>
+#include "event_log.h"
+
+// Streams event-log records to an SD card (or any block_device.h backend).
+//
+// Records are packed into 512-byte blocks in RAM and written as whole blocks
+// into a preallocated region: LOG.BIN in the root of a FAT card, or a raw
+// block range with SD_LOG_RAW. The filesystem is only read at boot; logging
+// itself never touches it. Each block is sent a slice per loop(), so card
+// latency never stalls the tapper or the encoder. The boot-time scan is
+// sliced the same way, one block read per loop(); records logged before it
+// finishes stay in the RAM ring only.
+//
+// The region is used as a ring. Every block carries a sequence number, and
+// logging resumes after the newest block on the next boot.
+//
+// Everything here is a no-op unless SD_LOGGING is defined in config.h.
+
+// Block layout, little-endian:
+//   magic 'STLG' u32, seq u32, baseMs u32, count u8, version u8,
+//   62 EventRecords, crc16 over the preceding 510 bytes.
+// baseMs is the time the first record's dtMs is relative to.
+
+// Start the card and find LOG.BIN (boot sector and root directory reads).
+// Blocking; call once. sd_logger_service() then sizes the region and finds
+// the resume point.
+void sd_logger_begin();
+
+// Copy a record into the block being filled. Called by event_log_add() with
+// interrupts disabled; baseMs is the time the record's dtMs is relative to.
+void sd_logger_append(const EventRecord& r, uint32_t baseMs);
+
+// Close the block being filled so it is written out even if not full.
+void sd_logger_sync();
+
+// Advance the block write by one slice. Call once per loop().
+void sd_logger_service(uint32_t nowMs);
+
+// True while the card is found and writable.
+bool sd_logger_active();
+
+// Blocks in the log region once active, else 0.
+uint32_t sd_logger_regionBlocks();
+
+// Records lost because both block buffers were waiting on the card.
+uint16_t sd_logger_dropped();
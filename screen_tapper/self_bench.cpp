@@ -0,0 +1,234 @@
+// Purpose: time hardware primitives on the board itself (see self_bench.h).
+
+#include "self_bench.h"
+#include "config.h"
+#include "hal.h"
+#include "menu.h"
+#include "display.h"
+#include "clock.h"
+#include "eeprom_queue.h"
+#include "encoder.h"
+#include "tapper.h"
+#include "console.h"
+#include <Arduino.h>
+
+static constexpr uint8_t CASES = (uint8_t)SelfBenchCase::Count;
+
+static const char NAME_LCD[]      PROGMEM = "lcd send";
+static const char NAME_HOME[]     PROGMEM = "view home";
+static const char NAME_LIST[]     PROGMEM = "view list";
+static const char NAME_NUMBER[]   PROGMEM = "view number";
+static const char NAME_TIME[]     PROGMEM = "view time";
+static const char NAME_DIAG[]     PROGMEM = "view diag";
+static const char NAME_RTC[]      PROGMEM = "rtc minutes";
+static const char NAME_EEPROM[]   PROGMEM = "eeprom update";
+static const char NAME_PIN[]      PROGMEM = "pin read";
+static const char NAME_ENCODER[]  PROGMEM = "encoder poll";
+static const char NAME_PWM[]      PROGMEM = "pwm write";
+
+// Calls per case, and calls between clock checks: cheap primitives run in
+// groups so the micros() reads don't dominate what is being measured.
+struct CaseSpec {
+    const char* name;
+    uint16_t    calls;
+    uint8_t     group;
+};
+
+// Knob events picked up by the EncoderPoll case, for self_bench_takeInput().
+static EncoderEvents s_heldInput;
+static bool          s_hasHeldInput = false;
+
+static int8_t addDelta(int8_t a, int8_t b) {
+    int d = a + b;
+    return (int8_t)(d > 127 ? 127 : d < -128 ? -128 : d);
+}
+
+static const CaseSpec kCases[CASES] PROGMEM = {
+    { NAME_LCD,     20,   1  },
+    { NAME_HOME,    50,   1  },
+    { NAME_LIST,    50,   1  },
+    { NAME_NUMBER,  50,   1  },
+    { NAME_TIME,    50,   1  },
+    { NAME_DIAG,    50,   1  },
+    { NAME_RTC,     50,   1  },
+    { NAME_EEPROM,  16,   1  },
+    { NAME_PIN,     2048, 16 },
+    { NAME_ENCODER, 2048, 16 },
+    { NAME_PWM,     2048, 16 },
+};
+
+static SelfBenchResult s_results[CASES];
+static bool            s_running = false;
+static uint8_t         s_case    = 0;
+static uint8_t         s_eeValue = 0x55;
+
+// ---------------------------------------------------------------------------
+// Sample views
+// ---------------------------------------------------------------------------
+
+static const char* const kSampleItems[] = {
+    "Return to Home", "Toggle On/Off", "Reset Next Tap",
+    "Set Tap Duration", "Set Tap Duty", "Set Sleep Time",
+};
+
+static MenuView sampleView(SelfBenchCase c) {
+    static DiagnosticsData diag;
+    MenuView v;
+    v.lifetimeGems = 1234567;
+    v.msLeft       = 599000;
+    v.tapDuration  = 160;
+    switch (c) {
+        case SelfBenchCase::ViewList:
+            v.kind      = ViewKind::List;
+            v.title     = "Settings";
+            v.items     = kSampleItems;
+            v.itemCount = sizeof(kSampleItems) / sizeof(kSampleItems[0]);
+            break;
+        case SelfBenchCase::ViewEditNumber:
+            v.kind    = ViewKind::EditNumber;
+            v.title   = "Gem Count";
+            v.value   = 1234567;
+            v.maxVal  = GEMS_MAX;
+            v.editing = true;
+            break;
+        case SelfBenchCase::ViewEditTime:
+            v.kind        = ViewKind::EditTime;
+            v.title       = "Sleep Time";
+            v.hh          = 23;
+            v.mm          = 59;
+            v.editingTime = true;
+            break;
+        case SelfBenchCase::ViewDiagnostics:
+            diag.uptimeSec = 987654;
+            diag.maxLoopUs = 3412;
+            v.kind  = ViewKind::Diagnostics;
+            v.title = "Diagnostics";
+            v.diag  = &diag;
+            break;
+        default:
+            v.kind  = ViewKind::Home;
+            v.title = "Home";
+            break;
+    }
+    return v;
+}
+
+// ---------------------------------------------------------------------------
+// Cases
+// ---------------------------------------------------------------------------
+
+static void runOnce(SelfBenchCase c, const MenuView& v) {
+    switch (c) {
+        case SelfBenchCase::LcdSend:
+            hal_lcdSend();
+            break;
+        case SelfBenchCase::RtcMinutes:
+            clock_nowMinutes();
+            break;
+        case SelfBenchCase::EepromUpdate:
+            // Alternating patterns force an erase + write every time.
+            s_eeValue = (uint8_t)~s_eeValue;
+            eeprom_queue_write(kSelfBenchEepromAddr, s_eeValue);
+            eeprom_queue_flush();
+            break;
+        case SelfBenchCase::PinRead:
+            hal_pinRead(ENCODER_SW);
+            break;
+        case SelfBenchCase::EncoderPoll: {
+            EncoderEvents e = encoder_poll();
+            if (e.delta == 0 && !e.pressed) break;
+            if (!s_hasHeldInput) s_heldInput.atUs = e.atUs;
+            s_heldInput.delta    = addDelta(s_heldInput.delta, e.delta);
+            s_heldInput.pressed |= e.pressed;
+            s_hasHeldInput       = true;
+            break;
+        }
+        case SelfBenchCase::PwmWrite:
+            hal_pwmWrite(AD_GEMS_MOSFET_GATE_PIN, 0);
+            break;
+        default:
+            display_compose(v);
+            break;
+    }
+}
+
+static void report(uint8_t c) {
+    char name[16];
+    strcpy_P(name, self_bench_name((SelfBenchCase)c));
+    uint32_t t = self_bench_tenthsUs((SelfBenchCase)c);
+    console_printf(PSTR("B %s n=%u us=%lu.%lu"), name, s_results[c].calls,
+                   (unsigned long)(t / 10), (unsigned long)(t % 10));
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+void self_bench_start() {
+    tapper_stop();
+    for (uint8_t i = 0; i < CASES; ++i) s_results[i] = SelfBenchResult();
+    s_case    = 0;
+    s_running = true;
+    console_printf(PSTR("B start"));
+}
+
+bool self_bench_running() {
+    return s_running;
+}
+
+void self_bench_service() {
+    if (!s_running) return;
+
+    SelfBenchCase   c = (SelfBenchCase)s_case;
+    SelfBenchResult& r = s_results[s_case];
+    uint16_t calls = pgm_read_word(&kCases[s_case].calls);
+    uint8_t  group = pgm_read_byte(&kCases[s_case].group);
+    MenuView v     = sampleView(c);
+
+    // Writes the rest of the loop queued would otherwise be timed as well.
+    if (c == SelfBenchCase::EepromUpdate) eeprom_queue_flush();
+
+    uint32_t start = hal_micros();
+    uint32_t now   = start;
+    while (r.calls < calls && now - start < kSelfBenchSliceMs * 1000UL) {
+        for (uint8_t i = 0; i < group; ++i) runOnce(c, v);
+        r.calls += group;
+        now = hal_micros();
+    }
+    r.totalUs += now - start;
+
+    if (r.calls < calls) return;
+    report(s_case);
+    if (++s_case >= CASES) {
+        s_running = false;
+        console_printf(PSTR("B done"));
+        display_markDirty();
+    }
+}
+
+void self_bench_takeInput(EncoderEvents& ev) {
+    if (!s_hasHeldInput) return;
+    ev.delta    = addDelta(ev.delta, s_heldInput.delta);
+    ev.pressed |= s_heldInput.pressed;
+    ev.atUs     = s_heldInput.atUs;   // held edges came first
+    s_heldInput    = EncoderEvents();
+    s_hasHeldInput = false;
+}
+
+uint8_t self_bench_done() {
+    return s_running ? s_case : (s_results[0].calls ? CASES : 0);
+}
+
+const SelfBenchResult& self_bench_result(SelfBenchCase c) {
+    return s_results[(uint8_t)c];
+}
+
+const char* self_bench_name(SelfBenchCase c) {
+    return (const char*)pgm_read_ptr(&kCases[(uint8_t)c].name);
+}
+
+uint32_t self_bench_tenthsUs(SelfBenchCase c) {
+    const SelfBenchResult& r = s_results[(uint8_t)c];
+    if (r.calls == 0) return 0;
+    return (r.totalUs * 10 + r.calls / 2) / r.calls;
+}
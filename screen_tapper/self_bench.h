@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include "encoder.h"
+
+// On-device self-benchmark. Times the board's own primitives (software SPI
+// to the LCD, each view's layout, the DS1307 over I2C, an EEPROM byte
+// program, pin reads, the encoder poll, PWM writes) so every unit reports a
+// comparable hardware fingerprint. Started from Settings > Self Benchmark
+// or "bench" on the console; results show on the Benchmark screen and go
+// out as "B" console lines.
+//
+// The solenoids are stopped when a run starts and the sketch holds off new
+// cycles until it ends. Work is done in slices of about kSelfBenchSliceMs
+// per loop(), so the watchdog keeps being fed.
+
+enum class SelfBenchCase : uint8_t {
+    LcdSend,          // full-frame hal_lcdSend()
+    ViewHome,         // layout of each view into the frame buffer
+    ViewList,
+    ViewEditNumber,
+    ViewEditTime,
+    ViewDiagnostics,
+    RtcMinutes,       // clock_nowMinutes()
+    EepromUpdate,     // one byte programmed at kSelfBenchEepromAddr
+    PinRead,          // hal_pinRead()
+    EncoderPoll,      // encoder_poll() on the real knob; see self_bench_takeInput()
+    PwmWrite,         // hal_pwmWrite(), duty 0 so the gate stays off
+    Count
+};
+
+struct SelfBenchResult {
+    uint16_t calls   = 0;
+    uint32_t totalUs = 0;
+};
+
+// Reset the results and start a run. Stops the tapper.
+void self_bench_start();
+
+// True from self_bench_start() until the last case finishes.
+bool self_bench_running();
+
+// Run one slice of the current case. Call once per loop().
+void self_bench_service();
+
+// The EncoderPoll case polls the real knob, so it sees any turn or press
+// made during its slices. Adds what it saw since the last call to ev, so
+// that input still reaches the menu. Call right after encoder_poll().
+void self_bench_takeInput(EncoderEvents& ev);
+
+// Cases finished in the current (or last) run.
+uint8_t self_bench_done();
+
+const SelfBenchResult& self_bench_result(SelfBenchCase c);
+const char*            self_bench_name(SelfBenchCase c);   // string in flash
+
+// Mean time per call in tenths of a microsecond; 0 if the case hasn't run.
+uint32_t self_bench_tenthsUs(SelfBenchCase c);
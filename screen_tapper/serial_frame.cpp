@@ -0,0 +1,18 @@
+#include "serial_frame.h"
+#include "crc16.h"
+#include "hal.h"
+
+static constexpr uint8_t SYNC0 = 0xA5;
+static constexpr uint8_t SYNC1 = 0x5A;
+
+void serial_frame_send(uint8_t type, const uint8_t* payload, uint8_t len) {
+    uint16_t crc = crc16_update(0xFFFF, type);
+    crc = crc16_update(crc, len);
+    crc = crc16(payload, len, crc);
+
+    uint8_t head[4] = { SYNC0, SYNC1, type, len };
+    hal_serialWrite(head, sizeof(head));
+    if (len) hal_serialWrite(payload, len);
+    uint8_t tail[2] = { (uint8_t)(crc & 0xFF), (uint8_t)(crc >> 8) };
+    hal_serialWrite(tail, sizeof(tail));
+}
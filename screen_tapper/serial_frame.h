@@ -0,0 +1,16 @@
+#pragma once
+#include <stdint.h>
+
+// CRC-framed binary messages on the serial port, between console lines:
+//
+//   0xA5 0x5A  type  len  payload[len]  crc16 (LE, over type..payload)
+//
+// Each sender owns its type letters (event_log.cpp: H R T, lcd_mirror.cpp:
+// D F) and waits for console_txIdle() and hal_serialWriteRoom() before
+// sending, so a frame never splits a text line and never blocks.
+
+constexpr uint8_t SERIAL_FRAME_OVERHEAD = 6;
+
+// Writes one whole frame. The caller has checked there is room for
+// len + SERIAL_FRAME_OVERHEAD bytes.
+void serial_frame_send(uint8_t type, const uint8_t* payload, uint8_t len);
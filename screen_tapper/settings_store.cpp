@@ -1,7 +1,15 @@
 #include "settings_store.h"
-#include <EEPROM.h>
+#include "eeprom_queue.h"
+#include "crc16.h"
+#include "event_log.h"
+#include "hal.h"
+#include <Arduino.h>
 
-// EEPROM addresses within the settings region (bytes 2-255)
+// Record copies within the settings region (bytes 2-250)
+static constexpr uint16_t ADDR_RECORD_A = 16;
+static constexpr uint16_t ADDR_RECORD_B = 40;
+
+// Legacy per-field addresses (schema 0, before the CRC record)
 static constexpr uint16_t ADDR_SLEEP_HOUR    = 2;
 static constexpr uint16_t ADDR_SLEEP_MINUTE  = 3;
 static constexpr uint16_t ADDR_WAKE_HOUR     = 4;
@@ -9,50 +17,198 @@ static constexpr uint16_t ADDR_WAKE_MINUTE   = 5;
 static constexpr uint16_t ADDR_TAP_DURATION  = 6;  // 2 bytes (uint16_t)
 static constexpr uint16_t ADDR_TAP_DUTY      = 8;  // 1 byte  (uint8_t)
 
+static constexpr uint8_t  SCHEMA_VERSION = 2;
+
+static constexpr uint8_t  FLAG_ADAPTIVE = 0x01;
+
+// Edits within this window of each other are coalesced into one commit.
+static constexpr uint32_t COMMIT_DELAY_MS = 5000;
+
+struct SettingsRecord {
+    uint8_t  version;
+    uint8_t  sequence;
+    uint8_t  sleepHour;
+    uint8_t  sleepMinute;
+    uint8_t  wakeHour;
+    uint8_t  wakeMinute;
+    uint16_t tapDuration;
+    uint8_t  tapDuty;
+    uint8_t  flags;                          // v2: FLAG_ADAPTIVE
+    uint16_t intervalSec[kIntervalWindow];   // v2: IntervalHistory samples
+    uint8_t  intervalCount;                  // v2
+    uint8_t  spare[1];    // zero; room for later schema versions
+    uint16_t crc;
+};
+static_assert(sizeof(SettingsRecord) == 24, "record layout is persisted");
+static_assert(kIntervalWindow == 5, "the interval window is part of the record layout");
+
+static Settings s_current;
+static uint8_t  s_sequence   = 0;
+static bool     s_nextIsB    = false;  // copy the next commit goes to
+static bool     s_dirty      = false;
+static uint32_t s_lastSaveMs = 0;
+
+// ---------------------------------------------------------------------------
+// Internal helpers
+// ---------------------------------------------------------------------------
+
 static bool validHour(uint8_t v)        { return v <= 23; }
 static bool validMinute(uint8_t v)      { return v <= 59; }
 static bool validDuration(uint16_t v)   { return v >= 1 && v <= 1000; }
-// tapDuty is uint8_t, so any value 0-255 is valid; 0xFF is the only
-// uninitialized sentinel we need to detect. We treat 0xFF as uninitialized
-// since a duty of 255 can be stored as 0xFF -- but 255 is a valid setting.
-// To disambiguate, we rely on duration validity: if duration is valid, we
-// trust the duty byte as-is (including 255). If duration is invalid, we
-// skip both tap settings together, keeping compiled-in defaults.
 
-void settings_load(Settings& s) {
-    // --- Sleep/wake schedule ---
-    uint8_t sh = EEPROM.read(ADDR_SLEEP_HOUR);
-    uint8_t sm = EEPROM.read(ADDR_SLEEP_MINUTE);
-    uint8_t wh = EEPROM.read(ADDR_WAKE_HOUR);
-    uint8_t wm = EEPROM.read(ADDR_WAKE_MINUTE);
+static uint16_t recordCrc(const SettingsRecord& r) {
+    return crc16(&r, offsetof(SettingsRecord, crc));
+}
+
+// Upgrades an older record in place to SCHEMA_VERSION. Each future schema
+// bump adds a case that fills its new fields and falls through to the next.
+// Returns false for versions this firmware does not understand.
+static bool migrate(SettingsRecord& r) {
+    switch (r.version) {
+        case 1:
+            // v2 took the flags and interval samples from the zeroed spare
+            // bytes, so they read as adaptive off with no samples.
+            r.version = 2;
+            // fall through
+        case SCHEMA_VERSION:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool readRecord(uint16_t addr, SettingsRecord& r) {
+    eeprom_queue_get(addr, r);
+    if (r.crc != recordCrc(r)) return false;
+    if (!migrate(r)) return false;
+    // Values are range-checked even with a good CRC, so a record written by
+    // buggy firmware cannot push the hardware out of bounds.
+    return validHour(r.sleepHour) && validMinute(r.sleepMinute) &&
+           validHour(r.wakeHour)  && validMinute(r.wakeMinute) &&
+           validDuration(r.tapDuration) && r.intervalCount <= kIntervalWindow;
+}
+
+static void applyRecord(const SettingsRecord& r, Settings& s) {
+    s.sched.sleepHour   = r.sleepHour;
+    s.sched.sleepMinute = r.sleepMinute;
+    s.sched.wakeHour    = r.wakeHour;
+    s.sched.wakeMinute  = r.wakeMinute;
+    s.tapDuration       = r.tapDuration;
+    s.tapDuty           = r.tapDuty;
+    s.adaptiveInterval  = (r.flags & FLAG_ADAPTIVE) != 0;
+    s.intervals.count   = r.intervalCount;
+    memcpy(s.intervals.sec, r.intervalSec, sizeof(r.intervalSec));
+}
+
+// Reads the per-field layout used before the CRC record. There is no way to
+// tell an uninitialized duty byte from a stored 255, so duty is trusted only
+// when the duration next to it is in range. Returns true if anything loaded.
+static bool loadLegacy(Settings& s) {
+    bool loaded = false;
+
+    uint8_t sh = eeprom_queue_read(ADDR_SLEEP_HOUR);
+    uint8_t sm = eeprom_queue_read(ADDR_SLEEP_MINUTE);
+    uint8_t wh = eeprom_queue_read(ADDR_WAKE_HOUR);
+    uint8_t wm = eeprom_queue_read(ADDR_WAKE_MINUTE);
 
     if (validHour(sh) && validMinute(sm) && validHour(wh) && validMinute(wm)) {
         s.sched.sleepHour   = sh;
         s.sched.sleepMinute = sm;
         s.sched.wakeHour    = wh;
         s.sched.wakeMinute  = wm;
+        loaded = true;
     }
 
-    // --- Tap duration and duty ---
-    // Both are loaded or neither is — if duration is out of range the EEPROM
-    // is uninitialized or corrupt, so we leave both at compiled-in defaults.
     uint16_t dur = 0;
-    EEPROM.get(ADDR_TAP_DURATION, dur);
+    eeprom_queue_get(ADDR_TAP_DURATION, dur);
     if (validDuration(dur)) {
         s.tapDuration = dur;
-        s.tapDuty     = EEPROM.read(ADDR_TAP_DUTY);
-        // tapDuty has no invalid range (0-255 are all valid), so we accept
-        // whatever is stored once we know the duration slot is initialized.
+        s.tapDuty     = eeprom_queue_read(ADDR_TAP_DUTY);
+        loaded = true;
     }
+    return loaded;
+}
+
+// The record for s_current under the given sequence number.
+static void buildRecord(SettingsRecord& r, uint8_t sequence) {
+    memset(&r, 0, sizeof(r));
+    r.version     = SCHEMA_VERSION;
+    r.sequence    = sequence;
+    r.sleepHour   = s_current.sched.sleepHour;
+    r.sleepMinute = s_current.sched.sleepMinute;
+    r.wakeHour    = s_current.sched.wakeHour;
+    r.wakeMinute  = s_current.sched.wakeMinute;
+    r.tapDuration = s_current.tapDuration;
+    r.tapDuty     = s_current.tapDuty;
+    r.flags       = s_current.adaptiveInterval ? FLAG_ADAPTIVE : 0;
+    r.intervalCount = s_current.intervals.count;
+    memcpy(r.intervalSec, s_current.intervals.sec, sizeof(r.intervalSec));
+    r.crc         = recordCrc(r);
+}
+
+static void commit() {
+    SettingsRecord r;
+    buildRecord(r, ++s_sequence);
+    eeprom_queue_put(s_nextIsB ? ADDR_RECORD_B : ADDR_RECORD_A, r);
+    s_nextIsB = !s_nextIsB;
+    s_dirty   = false;
+    event_log_add(EventType::EepromFlush, kFlushSettings, r.sequence);
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+void settings_load(Settings& s) {
+    SettingsRecord a, b;
+    bool okA = readRecord(ADDR_RECORD_A, a);
+    bool okB = readRecord(ADDR_RECORD_B, b);
+
+    if (okA || okB) {
+        // Sequence numbers wrap; the newer copy is "ahead" by a small step.
+        bool useB = okB && (!okA || (int8_t)(b.sequence - a.sequence) > 0);
+        const SettingsRecord& r = useB ? b : a;
+        applyRecord(r, s);
+        s_sequence = r.sequence;
+        s_nextIsB  = !useB;
+        s_current  = s;
+        s_dirty    = false;
+        return;
+    }
+
+    // No valid record: migrate the legacy layout (or keep defaults) and
+    // write the first record after the usual quiet period.
+    bool legacy = loadLegacy(s);
+    s_current  = s;
+    s_sequence = 0;
+    s_nextIsB  = false;
+    if (legacy) settings_save(s);
 }
 
 void settings_save(const Settings& s) {
-    // EEPROM.update() skips the physical write when the stored byte already
-    // matches, protecting the ~100,000 write-cycle lifetime of each cell.
-    EEPROM.update(ADDR_SLEEP_HOUR,   s.sched.sleepHour);
-    EEPROM.update(ADDR_SLEEP_MINUTE, s.sched.sleepMinute);
-    EEPROM.update(ADDR_WAKE_HOUR,    s.sched.wakeHour);
-    EEPROM.update(ADDR_WAKE_MINUTE,  s.sched.wakeMinute);
-    EEPROM.put(ADDR_TAP_DURATION,    s.tapDuration);  // put() handles uint16_t
-    EEPROM.update(ADDR_TAP_DUTY,     s.tapDuty);
+    s_current    = s;
+    s_dirty      = true;
+    s_lastSaveMs = hal_millis();
+}
+
+void settings_update(uint32_t nowMs) {
+    if (!s_dirty) return;
+    if (nowMs - s_lastSaveMs >= COMMIT_DELAY_MS) settings_flush();
+    else hal_deadline(s_lastSaveMs + COMMIT_DELAY_MS);
+}
+
+void settings_flush() {
+    if (!s_dirty) return;
+    commit();
+}
+
+bool settings_verify() {
+    if (s_dirty) return false;
+    SettingsRecord want, stored;
+    buildRecord(want, s_sequence);
+    eeprom_queue_get(s_nextIsB ? ADDR_RECORD_A : ADDR_RECORD_B, stored);
+    if (memcmp(&want, &stored, sizeof(want)) == 0) return false;
+
+    commit();
+    return true;
 }
@@ -1,19 +1,28 @@
 #pragma once
 #include "config.h"
+#include "interval_estimator.h"
 #include <stdint.h>
 
 // =============================================================================
-// EEPROM Settings Region  (bytes 2–255, 254 bytes available)
+// EEPROM Settings Region  (bytes 2–250, 249 bytes available)
 //
-// Addr  Size  Contents
-// ----  ----  --------
-//  2     1    sleep hour        (0-23)
-//  3     1    sleep minute      (0-59)
-//  4     1    wake hour         (0-23)
-//  5     1    wake minute       (0-59)
-//  6-7   2    tap duration (ms) (uint16_t, 1-1000)
-//  8     1    tap duty          (uint8_t,  0-255)
-//  9-255       reserved for future settings
+// Addr    Size  Contents
+// -----   ----  --------
+//  2-8     7    legacy per-field settings (read once to migrate old units)
+// 16-39   24    settings record, copy A
+// 40-63   24    settings record, copy B
+// 64-250        reserved for future settings
+//
+// Record layout (see SettingsRecord in settings_store.cpp):
+//  0      u8    schema version
+//  1      u8    sequence number; the valid copy with the newer one wins
+//  2-21         payload (sleep/wake times, tap duration, tap duty, adaptive
+//               interval flag and samples, spare)
+// 22-23   u16   CRC-16 over bytes 0-21
+//
+// Commits alternate between the two copies, so a write torn by a reset
+// leaves the other copy intact. Schema 1 records (before the adaptive
+// interval) load with it off and no samples.
 // =============================================================================
 
 // Holds all persisted runtime settings in one place.
@@ -21,13 +30,29 @@ struct Settings {
     SleepSchedule sched;
     uint16_t tapDuration = 160;  // solenoid on-time per tap (ms)
     uint8_t  tapDuty     = 160;  // solenoid PWM drive level (0-255)
+    bool     adaptiveInterval = false;  // schedule from the learned interval
+    IntervalHistory intervals;          // reset-button samples (interval_estimator.h)
 };
 
-// Load all settings from EEPROM. Any value that is uninitialized or out of
-// its valid range is left at the struct default, so a fresh EEPROM is safe.
+// Load settings with one block read per record copy. Falls back to the
+// legacy per-field layout, then to the struct defaults, so a fresh or
+// corrupt EEPROM is safe. Call after eeprom_queue_begin().
 void settings_load(Settings& s);
 
-// Persist all settings to EEPROM. Uses EEPROM.update() internally so only
-// bytes that actually changed are written, protecting write-cycle lifetime.
-// Only call this when a value has been confirmed changed by the user.
+// Record new settings. Nothing is written yet: the record is committed once
+// no further save has arrived for a short quiet period, so a burst of edits
+// costs a single record write.
 void settings_save(const Settings& s);
+
+// Commit a pending save once its quiet period has elapsed. Call once per loop().
+void settings_update(uint32_t nowMs);
+
+// Commit a pending save immediately (e.g. before sleeping). Not called on
+// power loss: the hold-up time is kept for the gem count, and a record torn
+// by the brown-out leaves the other copy valid.
+void settings_flush();
+
+// Re-read the newest record and commit the settings again if it no longer
+// matches them (bad CRC, flipped bit, older schema). Returns true if it
+// rewrote the record. For housekeeping; does nothing while a save is pending.
+bool settings_verify();
@@ -0,0 +1,193 @@
+#include "stats.h"
+#include "clock.h"
+#include "console.h"
+#include "crc16.h"
+#include "eeprom_queue.h"
+#include "hal.h"
+#include <Arduino.h>
+
+// =============================================================================
+// EEPROM layout: kStatsDays records of 12 bytes from kStatsEepromAddr. Day
+// number d (seconds / 86400) lives in slot d % kStatsDays, stamped with d so
+// a slot left over from an earlier lap of the ring reads as empty. No index
+// is stored, so there is nothing to tear: a bad CRC only loses that day.
+// =============================================================================
+
+struct StatsRecord {
+    StatsBin bin;
+    uint16_t day;   // low 16 bits of the day number
+    uint16_t crc;   // CRC-16 over bin and day
+};
+static_assert(sizeof(StatsRecord) == 12, "record layout is persisted");
+static_assert(kStatsEepromAddr + kStatsDays * sizeof(StatsRecord) <= kSelfBenchEepromAddr,
+              "stats records overlap the self-benchmark byte");
+
+static constexpr uint32_t SEC_PER_HOUR = 3600;
+static constexpr uint32_t SEC_PER_DAY  = 86400;
+
+static StatsBin s_hours[kStatsHours];
+static uint8_t  s_hourHead = 0;       // bin of the current hour
+static uint32_t s_hourNo   = 0;       // seconds / 3600 of the current hour
+static StatsBin s_today;
+static uint32_t s_dayNo    = 0;
+static bool     s_dayIsRtc = false;   // s_dayNo is an RTC day, so it may be persisted
+static uint32_t s_lastPersistMs = 0;
+
+static bool     s_blocked     = false;
+static uint32_t s_blockedMark = 0;    // start of the interval being skipped
+
+// Dump progress: one line per stats_service() call.
+static bool    s_dumping  = false;
+static uint8_t s_dumpNext = 0;
+
+// ---------------------------------------------------------------------------
+// Internal helpers
+// ---------------------------------------------------------------------------
+
+static void addSat(uint16_t& field, uint32_t v) {
+    uint32_t sum = (uint32_t)field + v;
+    field = sum > 0xFFFF ? 0xFFFF : (uint16_t)sum;
+}
+
+static uint16_t recordAddr(uint32_t day) {
+    return (uint16_t)(kStatsEepromAddr + (day % kStatsDays) * sizeof(StatsRecord));
+}
+
+static uint16_t recordCrc(const StatsRecord& r) {
+    return crc16(&r, offsetof(StatsRecord, crc));
+}
+
+static bool readDay(uint32_t day, StatsBin& out) {
+    StatsRecord r;
+    eeprom_queue_get(recordAddr(day), r);
+    if (r.crc != recordCrc(r) || r.day != (uint16_t)day) return false;
+    out = r.bin;
+    return true;
+}
+
+// Days counted from boot would land in the same slots on every boot, so
+// only RTC days are written.
+static void writeToday() {
+    if (!s_dayIsRtc) return;
+    StatsRecord r;
+    r.bin = s_today;
+    r.day = (uint16_t)s_dayNo;
+    r.crc = recordCrc(r);
+    eeprom_queue_put(recordAddr(s_dayNo), r);
+}
+
+// Seconds on the RTC, or since boot without one (fromRtc false).
+static uint32_t nowSeconds(uint32_t nowMs, bool& fromRtc) {
+    uint32_t rtc;
+    fromRtc = clock_nowUnix(rtc);
+    return fromRtc ? rtc : nowMs / 1000;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+void stats_begin(uint32_t nowMs) {
+    uint32_t sec = nowSeconds(nowMs, s_dayIsRtc);
+    s_hourNo = sec / SEC_PER_HOUR;
+    s_dayNo  = sec / SEC_PER_DAY;
+    if (!s_dayIsRtc || !readDay(s_dayNo, s_today)) s_today = {};
+    s_lastPersistMs = nowMs;
+}
+
+void stats_cycleFired(uint8_t gems) {
+    StatsBin& h = s_hours[s_hourHead];
+    addSat(h.cycles, 1);
+    addSat(h.gems, gems);
+    addSat(s_today.cycles, 1);
+    addSat(s_today.gems, gems);
+}
+
+void stats_cycleEnded(uint32_t durationMs) {
+    uint32_t s = (durationMs + 500) / 1000;
+    addSat(s_hours[s_hourHead].busyS, s);
+    addSat(s_today.busyS, s);
+}
+
+void stats_blocked(uint32_t nowMs, bool blocked, uint32_t intervalMs) {
+    if (!blocked) {
+        s_blocked = false;
+        return;
+    }
+    if (!s_blocked) {
+        s_blocked     = true;
+        s_blockedMark = nowMs;
+    } else if (nowMs - s_blockedMark >= intervalMs) {
+        s_blockedMark += intervalMs;
+        addSat(s_hours[s_hourHead].skipped, 1);
+        addSat(s_today.skipped, 1);
+    }
+}
+
+void stats_update(uint32_t nowMs) {
+    bool     rtc;
+    uint32_t sec  = nowSeconds(nowMs, rtc);
+    uint32_t hour = sec / SEC_PER_HOUR;
+    uint32_t day  = sec / SEC_PER_DAY;
+
+    // A clock set backwards keeps counting into the current bins.
+    if (hour > s_hourNo) {
+        uint32_t n = hour - s_hourNo;
+        if (n > kStatsHours) n = kStatsHours;
+        while (n--) {
+            s_hourHead = (uint8_t)((s_hourHead + 1) % kStatsHours);
+            s_hours[s_hourHead] = {};
+        }
+        s_hourNo = hour;
+    }
+    if (day > s_dayNo) {
+        writeToday();
+        s_dayNo    = day;
+        s_dayIsRtc = rtc;
+        s_today    = {};
+        s_lastPersistMs = nowMs;
+    }
+    if (nowMs - s_lastPersistMs >= kStatsPersistMs) stats_flush();
+}
+
+void stats_flush() {
+    writeToday();
+    s_lastPersistMs = hal_millis();
+}
+
+StatsBin stats_hour(uint8_t ago) {
+    if (ago >= kStatsHours) return StatsBin{};
+    return s_hours[(s_hourHead + kStatsHours - ago) % kStatsHours];
+}
+
+StatsBin stats_day(uint8_t ago) {
+    if (ago == 0) return s_today;
+    StatsBin b = {};
+    if (s_dayIsRtc && ago < kStatsDays && ago <= s_dayNo) readDay(s_dayNo - ago, b);
+    return b;
+}
+
+void stats_requestDump() {
+    s_dumping  = true;
+    s_dumpNext = 0;
+}
+
+// Lines:  Y h <ago> c=<cycles> g=<gems> skip=<n> busy=<s>    hours, oldest first
+//         Y d <ago> ...                                     then days
+//         Y end
+void stats_service() {
+    if (!s_dumping || !console_txIdle()) return;
+
+    uint8_t i = s_dumpNext++;
+    if (i >= kStatsHours + kStatsDays) {
+        console_printf(PSTR("Y end"));
+        s_dumping = false;
+        return;
+    }
+    bool     hourly = i < kStatsHours;
+    uint8_t  ago    = hourly ? (uint8_t)(kStatsHours - 1 - i)
+                             : (uint8_t)(kStatsDays - 1 - (i - kStatsHours));
+    StatsBin b      = hourly ? stats_hour(ago) : stats_day(ago);
+    console_printf(PSTR("Y %c %u c=%u g=%u skip=%u busy=%u"), hourly ? 'h' : 'd', ago,
+                   b.cycles, b.gems, b.skipped, b.busyS);
+}
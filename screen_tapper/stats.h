@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+#include "config.h"
+
+// Yield statistics in constant memory. Every event is added to the current
+// bin of two rings: kStatsHours hourly bins in RAM and kStatsDays daily bins
+// in EEPROM (today's is kept in RAM and written back every kStatsPersistMs).
+// Bins roll over on RTC hour and day boundaries; without an RTC they count
+// hours and days since boot and the daily ring is neither read nor written.
+// "stats" on the console prints every bin and the Statistics screen draws
+// gems per bin as a sparkline.
+
+struct StatsBin {
+    uint16_t cycles;    // tap cycles fired
+    uint16_t gems;      // gems credited
+    uint16_t skipped;   // intervals that passed asleep or disabled
+    uint16_t busyS;     // seconds spent in cycles; mean = busyS / cycles
+};
+
+// Pick up today's persisted bin. Call after eeprom_queue_begin() and
+// clock_begin().
+void stats_begin(uint32_t nowMs);
+
+// A cycle fired and credited gems.
+void stats_cycleFired(uint8_t gems);
+
+// A cycle finished after durationMs.
+void stats_cycleEnded(uint32_t durationMs);
+
+// Call every loop(). While blocked (asleep or disabled) one skipped cycle
+// is counted per intervalMs.
+void stats_blocked(uint32_t nowMs, bool blocked, uint32_t intervalMs);
+
+// Roll bins over and write today's back when due. Call once per second.
+void stats_update(uint32_t nowMs);
+
+// Write today's bin now (e.g. before sleeping).
+void stats_flush();
+
+// Bins counted back from the current one (0 = this hour / today). Days
+// older than today are read from EEPROM; a slot not written for that day
+// reads as zero.
+StatsBin stats_hour(uint8_t ago);
+StatsBin stats_day(uint8_t ago);
+
+// Print every bin through the console, oldest first.
+void stats_requestDump();
+
+// Emit pending dump lines while the console is idle. Call once per loop().
+void stats_service();
@@ -1,5 +1,8 @@
 #include "tapper.h"
-#include <Arduino.h>
+#include "event_log.h"
+#include "stats.h"
+#include "config.h"
+#include "hal.h"
 
 static uint8_t s_adPin    = 0;
 static uint8_t s_floatPin = 0;
@@ -13,13 +16,65 @@ static uint8_t  s_floatTaps  = 0;
 static uint8_t  s_currentTap = 0;
 
 static bool     s_solenoidOn  = false;
-static uint32_t s_phaseStart  = 0;
+static Deadline s_phaseEnd;              // current pulse or pause ends
 static uint16_t s_tapDuration = 10;
-static uint16_t s_pause       = 1000;
+static uint16_t s_pause       = 1000;   // nominal; see pauseFor()
 static uint8_t  s_solenoidDuty = 255;
 
-static void driveLow(uint8_t pin)  { analogWrite(pin, 0); }
-static void driveHigh(uint8_t pin) { analogWrite(pin, s_solenoidDuty); }
+static MonoMs   s_cycleStart   = 0;   // for the CycleEnd log record
+static uint32_t s_pulseStartUs = 0;   // measured on-time for TapPulse records
+static uint32_t s_cyclesDone   = 0;
+
+// ---------------------------------------------------------------------------
+// Thermal budget
+// ---------------------------------------------------------------------------
+// Heat is kept in ms x duty (255 = 1 ms at full drive) as of `at`, and is
+// cooled lazily in steps of 1/32 of the time constant.
+
+static constexpr uint32_t HEAT_LIMIT   = kThermalLimitMs * 255;
+static constexpr uint32_t COOL_STEP_MS = kThermalTauMs / 32;
+static_assert(1000UL * 255 <= HEAT_LIMIT, "a longest full-duty pulse must fit the budget");
+
+struct Channel {
+    uint32_t heat = 0;
+    MonoMs   at   = 0;
+};
+
+static Channel s_channel[2];          // 0 = ad, 1 = float, as in TapPulse
+static uint8_t s_peakPercent = 0;     // this cycle, for the CycleEnd record
+
+static Channel& currentChannel() { return s_channel[s_inAd ? 0 : 1]; }
+
+static void cool(Channel& c, MonoMs nowMs) {
+    MonoMs dt = mono_sinceMs(c.at, nowMs);
+    if (dt >= 8 * kThermalTauMs) {        // within e^-8 of cold
+        c.heat = 0;
+        c.at   = nowMs;
+        return;
+    }
+    uint16_t steps = (uint16_t)((uint32_t)dt / COOL_STEP_MS);
+    c.at += (uint32_t)steps * COOL_STEP_MS;
+    while (steps--) c.heat -= c.heat >> 5;   // x (1 - 1/32), about e^(-1/32)
+}
+
+static uint8_t heatPercent(uint32_t heat) {
+    uint32_t pct = heat / (HEAT_LIMIT / 100);
+    return pct > 255 ? 255 : (uint8_t)pct;
+}
+
+// Pause before the next pulse on c: kTapPauseMinMs while cold, growing to
+// the nominal pause as c nears its limit. A nominal pause shorter than the
+// minimum is kept as is.
+static uint16_t pauseFor(Channel& c, MonoMs nowMs) {
+    cool(c, nowMs);
+    if (s_pause <= kTapPauseMinMs) return s_pause;
+    uint8_t pct = heatPercent(c.heat);
+    if (pct > 100) pct = 100;
+    return (uint16_t)(kTapPauseMinMs + (uint32_t)(s_pause - kTapPauseMinMs) * pct / 100);
+}
+
+static void driveLow(uint8_t pin)  { hal_pwmWrite(pin, 0); }
+static void driveHigh(uint8_t pin) { hal_pwmWrite(pin, s_solenoidDuty); }
 
 void tapper_setDuty(uint8_t duty) {
     s_solenoidDuty = duty;
@@ -28,8 +83,8 @@ void tapper_setDuty(uint8_t duty) {
 void tapper_begin(uint8_t adPin, uint8_t floatPin) {
     s_adPin    = adPin;
     s_floatPin = floatPin;
-    pinMode(s_adPin,    OUTPUT);
-    pinMode(s_floatPin, OUTPUT);
+    hal_pinOutput(s_adPin);
+    hal_pinOutput(s_floatPin);
     driveLow(s_adPin);
     driveLow(s_floatPin);
     s_active = false;
@@ -40,7 +95,7 @@ void tapper_startCycle(
     uint8_t  floatTaps,
     uint16_t tapDurationMs,
     uint16_t pauseMs,
-    uint32_t nowMs
+    MonoMs   nowMs
 ) {
     s_adTaps      = adTaps;
     s_floatTaps   = floatTaps;
@@ -51,52 +106,74 @@ void tapper_startCycle(
     s_currentPin = s_adPin;
     s_currentTap = 0;
     s_solenoidOn = false;
-    s_phaseStart = nowMs;
+    s_phaseEnd   = deadline_in(nowMs, pauseFor(currentChannel(), nowMs));
+    s_cycleStart = nowMs;
+    s_peakPercent = 0;
 
     driveLow(s_adPin);
     driveLow(s_floatPin);
 
     s_active = (adTaps > 0) || (floatTaps > 0);
+    if (s_active) event_log_add(EventType::CycleStart, adTaps, floatTaps);
 }
 
 static uint8_t targetTapsForStage() {
     return s_inAd ? s_adTaps : s_floatTaps;
 }
 
-bool tapper_update(uint32_t nowMs) {
+bool tapper_update(MonoMs nowMs) {
     if (!s_active) return false;
+    deadline_announce(s_phaseEnd);
+    if (!deadline_reached(s_phaseEnd, nowMs)) return false;
 
     if (!s_solenoidOn) {
-        if (nowMs - s_phaseStart >= s_pause) {
-            driveHigh(s_currentPin);
-            s_solenoidOn = true;
-            s_phaseStart = nowMs;
+        // Hold the pulse while it would push the channel over its budget.
+        Channel& c = currentChannel();
+        cool(c, nowMs);
+        if (c.heat + (uint32_t)s_tapDuration * s_solenoidDuty > HEAT_LIMIT) {
+            s_phaseEnd = deadline_in(nowMs, COOL_STEP_MS);
+            return false;
         }
+        driveHigh(s_currentPin);
+        s_pulseStartUs = hal_micros();
+        s_solenoidOn = true;
+        s_phaseEnd   = deadline_in(nowMs, s_tapDuration);
         return false;
     }
 
-    if (nowMs - s_phaseStart >= s_tapDuration) {
-        driveLow(s_currentPin);
-        s_solenoidOn = false;
-        s_phaseStart = nowMs;
-        s_currentTap++;
-
-        if (s_currentTap >= targetTapsForStage()) {
-            if (s_inAd && s_floatTaps > 0) {
-                // Advance to float-gem stage
-                s_inAd       = false;
-                s_currentPin = s_floatPin;
-                s_currentTap = 0;
-                return false;
-            } else {
-                // Cycle complete
-                s_active = false;
-                driveLow(s_adPin);
-                driveLow(s_floatPin);
-                return true;
-            }
+    // Pulse over: drop the gate, charge its heat, then pause or move on.
+    driveLow(s_currentPin);
+    uint32_t onUs = hal_micros() - s_pulseStartUs;
+    event_log_add(EventType::TapPulse, s_inAd ? 0 : 1, onUs);
+    Channel& c = currentChannel();
+    cool(c, nowMs);
+    c.heat += onUs * s_solenoidDuty / 1000;
+    uint8_t pct = heatPercent(c.heat);
+    if (pct > s_peakPercent) s_peakPercent = pct;
+    s_solenoidOn = false;
+    s_currentTap++;
+
+    if (s_currentTap >= targetTapsForStage()) {
+        if (s_inAd && s_floatTaps > 0) {
+            // Advance to float-gem stage
+            s_inAd       = false;
+            s_currentPin = s_floatPin;
+            s_currentTap = 0;
+            s_phaseEnd   = deadline_in(nowMs, pauseFor(currentChannel(), nowMs));
+            return false;
+        } else {
+            // Cycle complete
+            s_active = false;
+            driveLow(s_adPin);
+            driveLow(s_floatPin);
+            s_cyclesDone++;
+            uint32_t durationMs = (uint32_t)mono_sinceMs(s_cycleStart, nowMs);
+            event_log_add(EventType::CycleEnd, s_peakPercent, durationMs);
+            stats_cycleEnded(durationMs);
+            return true;
         }
     }
+    s_phaseEnd = deadline_in(nowMs, pauseFor(c, nowMs));
     return false;
 }
 
@@ -108,3 +185,11 @@ void tapper_stop() {
 }
 
 bool tapper_isActive() { return s_active; }
+
+uint32_t tapper_cyclesCompleted() { return s_cyclesDone; }
+
+uint8_t tapper_heatPercent(uint8_t channel) {
+    Channel& c = s_channel[channel ? 1 : 0];
+    cool(c, mono_nowMs());
+    return heatPercent(c.heat);
+}
@@ -1,16 +1,20 @@
 #pragma once
 #include <stdint.h>
+#include "mono_time.h"
 
 // Initialize solenoid output pins.
 void tapper_begin(uint8_t adPin, uint8_t floatPin);
 
-// Start a full tap cycle (ad-gem taps, then float-gem taps).
+// Start a full tap cycle (ad-gem taps, then float-gem taps). pauseMs is the
+// nominal pause between taps: each channel's thermal budget shortens it to
+// kTapPauseMinMs while the channel is cold and holds a pulse back while it
+// would exceed kThermalLimitMs (see config.h).
 void tapper_startCycle(
     uint8_t  adTaps,
     uint8_t  floatTaps,
     uint16_t tapDurationMs,
     uint16_t pauseMs,
-    uint32_t nowMs
+    MonoMs   nowMs
 );
 
 // Set solenoid drive strength (0–255 PWM).
@@ -18,10 +22,17 @@ void tapper_setDuty(uint8_t duty);
 
 // Advance the tapper state machine. Call once per loop().
 // Returns true exactly once when the full cycle completes.
-bool tapper_update(uint32_t nowMs);
+bool tapper_update(MonoMs nowMs);
 
 // Immediately cut power to both solenoids and clear state.
 void tapper_stop();
 
 // True while any tap stage is running.
 bool tapper_isActive();
+
+// Tap cycles run to completion since boot (stopped cycles don't count).
+uint32_t tapper_cyclesCompleted();
+
+// Thermal budget used by a channel (0 = ad, 1 = float) right now, in percent
+// of kThermalLimitMs.
+uint8_t tapper_heatPercent(uint8_t channel);
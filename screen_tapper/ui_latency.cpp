@@ -0,0 +1,60 @@
+#include "ui_latency.h"
+#include "console.h"
+#include <Arduino.h>
+
+static uint16_t s_hist[kLatencyBuckets];   // saturating
+static uint32_t s_count = 0;
+static uint32_t s_maxUs = 0;
+static bool     s_dumpPending = false;
+
+void ui_latency_record(uint32_t us) {
+    uint32_t b = us / kLatencyBucketUs;
+    if (b >= kLatencyBuckets) b = kLatencyBuckets - 1;
+    if (s_hist[b] < 0xFFFF) s_hist[b]++;
+    s_count++;
+    if (us > s_maxUs) s_maxUs = us;
+}
+
+void ui_latency_reset() {
+    memset(s_hist, 0, sizeof(s_hist));
+    s_count = 0;
+    s_maxUs = 0;
+}
+
+uint32_t ui_latency_percentileUs(uint8_t pct) {
+    uint32_t total = 0;
+    for (uint8_t b = 0; b < kLatencyBuckets; ++b) total += s_hist[b];
+    if (total == 0) return 0;
+
+    uint32_t need = (total * pct + 99) / 100;
+    uint32_t seen = 0;
+    for (uint8_t b = 0; b < kLatencyBuckets; ++b) {
+        seen += s_hist[b];
+        if (seen >= need) {
+            // The open-ended last bucket has no upper edge; the max does.
+            if (b == kLatencyBuckets - 1) return s_maxUs;
+            uint32_t edge = (uint32_t)(b + 1) * kLatencyBucketUs;
+            return edge < s_maxUs ? edge : s_maxUs;
+        }
+    }
+    return s_maxUs;
+}
+
+uint32_t ui_latency_count() { return s_count; }
+uint32_t ui_latency_maxUs() { return s_maxUs; }
+
+void ui_latency_requestDump() {
+    s_dumpPending = true;
+}
+
+// Line:  L n=<count> p50=<us> p90=<us> p99=<us> max=<us>
+void ui_latency_service() {
+    if (!s_dumpPending || !console_txIdle()) return;
+    s_dumpPending = false;
+    console_printf(PSTR("L n=%lu p50=%lu p90=%lu p99=%lu max=%lu"),
+                   (unsigned long)s_count,
+                   (unsigned long)ui_latency_percentileUs(50),
+                   (unsigned long)ui_latency_percentileUs(90),
+                   (unsigned long)ui_latency_percentileUs(99),
+                   (unsigned long)s_maxUs);
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <stdint.h>
+#include "config.h"
+
+// Input-to-display latency. The encoder and reset button stamp each edge
+// when loop() samples it; the stamp rides in MenuView to the frame that
+// shows the result, and the delay from edge to the end of hal_lcdSend() is
+// binned here (kLatencyBuckets of kLatencyBucketUs).
+//
+// The input pins (40, 42, 44, 31) have no pin-change interrupt on the
+// Mega, so edges are polled and the true edge time is unknown. The stamp is
+// the previous poll's time instead, which adds one pass's duration as the
+// bound on the sampling delay: the figures are upper bounds, high by up to
+// one loop() pass.
+// "latency" on the console prints the count and percentiles,
+// "latency reset" clears them.
+
+// Add one edge-to-frame delay.
+void ui_latency_record(uint32_t us);
+
+void ui_latency_reset();
+
+// Smallest delay that at least pct percent of the samples stay within,
+// rounded up to a bucket edge. 0 with no samples.
+uint32_t ui_latency_percentileUs(uint8_t pct);
+
+uint32_t ui_latency_count();
+uint32_t ui_latency_maxUs();
+
+// Print the summary line through the console.
+void ui_latency_requestDump();
+
+// Emit the pending line while the console is idle. Call once per loop().
+void ui_latency_service();
@@ -0,0 +1,169 @@
+#include "watchdog.h"
+#include "config.h"
+#include <Arduino.h>
+
+#ifdef __AVR__
+
+#include "tapper.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/wdt.h>
+
+// The .init3 hook drives the gates through the port registers directly.
+static_assert(AD_GEMS_MOSFET_GATE_PIN == 9 && FLOAT_GEMS_MOSFET_GATE_PIN == 11,
+              "gate pins moved: update the port bits in watchdog_boot()");
+
+static constexpr uint16_t MAGIC    = 0x5744;   // "WD"
+static constexpr uint8_t  NO_CAUSE = 0xFF;
+
+// WDTCSR prescaler bits for kWatchdogMs; WDP3 is not next to WDP2.
+static constexpr uint8_t wdto(uint16_t ms) {
+    return ms == 15   ? WDTO_15MS  : ms == 30   ? WDTO_30MS  :
+           ms == 60   ? WDTO_60MS  : ms == 120  ? WDTO_120MS :
+           ms == 250  ? WDTO_250MS : ms == 500  ? WDTO_500MS :
+           ms == 1000 ? WDTO_1S    : ms == 2000 ? WDTO_2S    :
+           ms == 4000 ? WDTO_4S    : ms == 8000 ? WDTO_8S    : 0xFF;
+}
+static_assert(wdto(kWatchdogMs) != 0xFF, "kWatchdogMs must be a watchdog period");
+static constexpr uint8_t PRESCALE =
+    (uint8_t)((wdto(kWatchdogMs) & 0x07) | ((wdto(kWatchdogMs) & 0x08) ? _BV(WDP3) : 0));
+
+// Survives a reset; garbage after power-up, which the magic catches.
+struct ResetRecord {
+    uint16_t magic;
+    uint8_t  cause;     // ResetCause::Watchdog once the timeout interrupt ran
+    uint8_t  section;   // LoopSection executing right now
+};
+static volatile ResetRecord s_record __attribute__((section(".noinit")));
+
+// What the last reset looked like. Also .noinit: .bss is cleared after
+// .init3 runs.
+static uint8_t s_bootCause   __attribute__((section(".noinit")));
+static uint8_t s_bootSection __attribute__((section(".noinit")));
+
+static bool     s_armed      = false;
+static uint16_t s_nearMisses = 0;
+
+// Runs from .init3, before .data/.bss are set up and before any
+// constructor: reset flags are read, the watchdog (left running at 15 ms
+// after a watchdog reset) is stopped, and both gates are pulled low before
+// anything can drive them.
+//
+// MCUSR is normally already zero here because the bootloader cleared it;
+// its flags are only seen when the sketch is flashed without one. Then the
+// record decides: a valid record that saw the timeout interrupt means a
+// watchdog reset, any other valid record a reset-pin press (or a brown-out
+// short enough to keep RAM). A hang with interrupts disabled resets without
+// running the interrupt and also reads as external.
+void watchdog_boot() __attribute__((naked, used, section(".init3")));
+void watchdog_boot() {
+    uint8_t mcusr = MCUSR;
+    MCUSR = 0;
+    wdt_disable();
+
+    PORTH &= (uint8_t)~_BV(PH6);   // D9
+    DDRH  |= _BV(PH6);
+    PORTB &= (uint8_t)~_BV(PB5);   // D11
+    DDRB  |= _BV(PB5);
+
+    bool valid = s_record.magic == MAGIC && s_record.section < (uint8_t)LoopSection::Count;
+    ResetCause cause;
+    if      (mcusr & _BV(PORF))  cause = ResetCause::PowerOn;
+    else if (mcusr & _BV(BORF))  cause = ResetCause::BrownOut;
+    else if (mcusr & _BV(WDRF))  cause = ResetCause::Watchdog;
+    else if (mcusr & _BV(EXTRF)) cause = ResetCause::External;
+    else if (!valid)             cause = ResetCause::PowerOn;
+    else if (s_record.cause == (uint8_t)ResetCause::Watchdog) cause = ResetCause::Watchdog;
+    else                         cause = ResetCause::External;
+
+    s_bootCause   = (uint8_t)cause;
+    s_bootSection = (valid && cause == ResetCause::Watchdog)
+                  ? s_record.section : (uint8_t)LoopSection::Setup;
+
+    s_record.magic   = MAGIC;
+    s_record.cause   = NO_CAUSE;
+    s_record.section = (uint8_t)LoopSection::Setup;
+}
+
+// First timeout: loop() has not fed the watchdog for kWatchdogMs. Make the
+// outputs safe and leave the record for the next boot; the hardware has
+// cleared WDIE, so the next timeout resets.
+ISR(WDT_vect) {
+    tapper_stop();
+    s_record.cause = (uint8_t)ResetCause::Watchdog;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+LoopSection loop_section_current() {
+    return (LoopSection)s_record.section;
+}
+
+void loop_section_set(LoopSection section) {
+    s_record.section = (uint8_t)section;
+}
+
+void watchdog_begin() {
+    uint8_t sreg = SREG;
+    cli();
+    wdt_reset();
+    WDTCSR = _BV(WDCE) | _BV(WDE);               // timed sequence: 4 cycles
+    WDTCSR = _BV(WDIE) | _BV(WDE) | PRESCALE;
+    SREG = sreg;
+    s_armed = true;
+}
+
+void watchdog_feed() {
+    if (!s_armed) return;
+    wdt_reset();
+    // WDIE clear means the interrupt ran but this pass finished in time.
+    // WDIE may be set again without the timed sequence.
+    if (!(WDTCSR & _BV(WDIE))) {
+        WDTCSR |= _BV(WDIE);
+        s_record.cause = NO_CAUSE;
+        if (s_nearMisses < 0xFFFF) s_nearMisses++;
+    }
+}
+
+ResetCause watchdog_resetCause() {
+    return (ResetCause)s_bootCause;
+}
+
+LoopSection watchdog_lastSection() {
+    return (LoopSection)s_bootSection;
+}
+
+uint16_t watchdog_nearMisses() {
+    return s_nearMisses;
+}
+
+#else
+
+static LoopSection s_section = LoopSection::Setup;
+
+LoopSection loop_section_current() { return s_section; }
+void loop_section_set(LoopSection section) { s_section = section; }
+void watchdog_begin() {}
+void watchdog_feed() {}
+ResetCause watchdog_resetCause() { return ResetCause::PowerOn; }
+LoopSection watchdog_lastSection() { return LoopSection::Setup; }
+uint16_t watchdog_nearMisses() { return 0; }
+
+#endif
+
+static const char CAUSE_POWER_ON[] PROGMEM = "power-on";
+static const char CAUSE_EXTERNAL[] PROGMEM = "external";
+static const char CAUSE_BROWNOUT[] PROGMEM = "brown-out";
+static const char CAUSE_WATCHDOG[] PROGMEM = "watchdog";
+
+const char* watchdog_causeName(ResetCause cause) {
+    switch (cause) {
+        case ResetCause::PowerOn:  return CAUSE_POWER_ON;
+        case ResetCause::External: return CAUSE_EXTERNAL;
+        case ResetCause::BrownOut: return CAUSE_BROWNOUT;
+        case ResetCause::Watchdog: return CAUSE_WATCHDOG;
+    }
+    return CAUSE_POWER_ON;
+}
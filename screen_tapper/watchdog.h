@@ -0,0 +1,41 @@
+#pragma once
+#include <stdint.h>
+#include "loop_section.h"
+
+// Watchdog supervision.
+//
+// The AVR watchdog runs in interrupt-then-reset mode with a kWatchdogMs
+// timeout. loop() feeds it once per pass. If a pass hangs, the first
+// timeout interrupt cuts both solenoids and records the LoopSection that
+// was executing; the second timeout resets the board.
+//
+// The record lives in .noinit RAM, which survives a reset. The Mega's
+// bootloader clears MCUSR before the sketch starts, so the record is also
+// how a watchdog reset is told apart from the reset button. An early .init3
+// hook drives both MOSFET gates low before anything else runs, so a reset
+// never leaves a solenoid energized through startup.
+
+enum class ResetCause : uint8_t {
+    PowerOn  = 0,
+    External = 1,   // reset pin (or a brown-out that kept RAM, see .cpp)
+    BrownOut = 2,
+    Watchdog = 3,
+};
+
+// Arm the watchdog. Call at the end of setup(), after slow initialization.
+void watchdog_begin();
+
+// Restart the timeout. Call once per loop().
+void watchdog_feed();
+
+// Why the board last reset, and the section running when a watchdog reset
+// hit (LoopSection::Setup otherwise).
+ResetCause  watchdog_resetCause();
+LoopSection watchdog_lastSection();
+
+// Short lowercase name, for reports.
+const char* watchdog_causeName(ResetCause cause);   // string in flash
+
+// Timeout interrupts that fired but were followed by a feed in time to
+// avoid the reset.
+uint16_t watchdog_nearMisses();
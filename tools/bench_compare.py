@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+"""Compare two screen_tapper_bench reports.
+
+Run the benchmark on each commit and compare the JSON files:
+
+    screen_tapper_bench --label "$(git rev-parse --short HEAD)" --out new.json
+    bench_compare.py base.json new.json
+    bench_compare.py --threshold 5 base.json new.json
+
+Every case in either report is listed with both medians and the change in
+percent. A case is flagged as a regression when its median grew by more
+than the threshold (default 10%) or it started allocating; the exit status
+is 1 if any case regressed. Host timings are noisy, so compare runs from
+the same machine and rerun before trusting a small change.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        report = json.load(f)
+    if report.get("schema") != 1:
+        sys.exit(f"{path}: unsupported report schema {report.get('schema')}")
+    return report.get("label", ""), {r["name"]: r for r in report["results"]}
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("base", help="report of the reference commit")
+    ap.add_argument("new", help="report of the commit under test")
+    ap.add_argument("--threshold", type=float, default=10.0,
+                    help="median slowdown in percent that counts as a regression")
+    args = ap.parse_args()
+
+    base_label, base = load(args.base)
+    new_label, new = load(args.new)
+    print(f"base: {base_label or args.base}   new: {new_label or args.new}")
+    print(f"{'case':22} {'base ns':>10} {'new ns':>10} {'change':>8}  allocs")
+
+    regressions = 0
+    for name in list(base) + [n for n in new if n not in base]:
+        b, n = base.get(name), new.get(name)
+        if b is None or n is None:
+            side = "new" if b is None else "base"
+            print(f"{name:22} {'':>10} {'':>10} {'':>8}  only in {side}")
+            continue
+        change = (n["median"] / b["median"] - 1) * 100 if b["median"] else 0.0
+        allocs = f"{b['allocs_per_call']:.3f} -> {n['allocs_per_call']:.3f}"
+        flag = ""
+        if change > args.threshold or n["allocs_per_call"] > b["allocs_per_call"]:
+            flag = "  REGRESSION"
+            regressions += 1
+        print(f"{name:22} {b['median']:10.1f} {n['median']:10.1f} {change:+7.1f}%  {allocs}{flag}")
+
+    if regressions:
+        print(f"{regressions} case(s) regressed")
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
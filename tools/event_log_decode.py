@@ -0,0 +1,252 @@
+#!/usr/bin/env python3
+"""Decode screen tapper event-log dumps into CSV.
+
+The firmware streams its RAM event log as CRC-framed binary when asked
+(see screen_tapper/event_log.cpp). Capture the serial port to a file, or
+let this tool request and read the dump itself (needs pyserial):
+
+    event_log_decode.py capture.bin > events.csv
+    event_log_decode.py --port /dev/ttyACM0 --follow > events.csv
+
+Opening the port resets the Mega, which clears the RAM ring, so a one-shot
+--port read only returns what was logged since that reset. --follow keeps
+the port open and requests a dump every --interval seconds; records leave
+the ring as they are sent, so each poll prints only new ones. The ring
+holds kEventLogSize records (screen_tapper/config.h), a little over two
+tap cycles, so any interval shorter than the tap interval loses nothing.
+
+With SD_LOGGING the same records are also written to the card in 512-byte
+blocks (see screen_tapper/sd_logger.h). Give --sd a copy of LOG.BIN or an
+image of the whole card; blocks are found by their magic and CRC:
+
+    event_log_decode.py --sd LOG.BIN > events.csv
+
+Console text the firmware prints between frames is skipped.
+"""
+
+import argparse
+import csv
+import struct
+import sys
+import time
+
+SYNC = b"\xa5\x5a"
+RECORD = struct.Struct("<BBHI")
+
+EVENTS = [
+    "TimeSync", "CycleStart", "TapPulse", "CycleEnd", "Wake", "Sleep",
+    "MenuCommit", "EepromFlush", "LoopOverrun", "Reset",
+]
+
+RESET_CAUSES = ["power-on", "external", "brown-out", "watchdog"]
+
+LOOP_SECTIONS = [
+    "setup", "loop", "period", "encoder", "menu", "awake", "tapper",
+    "storage", "view", "draw", "lcd", "console", "sd", "bench", "housekeep",
+]
+
+MENU_ACTIONS = [
+    "None", "GoHome", "ToggleDeviceEnabled", "ResetNextTap", "SetTapDuration",
+    "SetTapDuty", "EnterSleepTimeEditor", "SetSleepTime", "EnterWakeTimeEditor",
+    "SetWakeTime", "SetGemCount", "ToggleTestMode", "ToggleOverrideSleep",
+    "RunSelfBench", "ToggleAdaptiveInterval",
+]
+
+FLUSH_SOURCES = ["gems", "gem_base", "settings"]
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE, matching screen_tapper/crc16.h."""
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def frames(buf):
+    """Yield (type, payload) for every valid frame in buf."""
+    i = 0
+    while True:
+        i = buf.find(SYNC, i)
+        if i < 0 or i + 6 > len(buf):
+            return
+        ftype, length = buf[i + 2], buf[i + 3]
+        end = i + 4 + length
+        if end + 2 > len(buf):
+            return
+        payload = buf[i + 4:end]
+        (crc,) = struct.unpack_from("<H", buf, end)
+        if crc16(bytes([ftype, length]) + payload) == crc:
+            yield chr(ftype), payload
+            i = end + 2
+        else:
+            i += 1
+
+
+def describe(name, a8, a32):
+    if name == "CycleStart":
+        return f"ad_taps={a8} float_taps={a32}"
+    if name == "TapPulse":
+        return f"channel={'ad' if a8 == 0 else 'float'} on_us={a32}"
+    if name == "CycleEnd":
+        return f"duration_ms={a32} peak_heat={a8}%"
+    if name == "MenuCommit":
+        action = MENU_ACTIONS[a8] if a8 < len(MENU_ACTIONS) else str(a8)
+        if action in ("SetSleepTime", "SetWakeTime"):
+            return f"{action} {a32 & 0xFFFF:02d}:{a32 >> 16:02d}"
+        if action in ("SetTapDuration", "SetTapDuty"):
+            return f"{action} {a32 & 0xFFFF}"
+        if action == "SetGemCount":
+            return f"{action} {a32}"
+        return action
+    if name == "EepromFlush":
+        src = FLUSH_SOURCES[a8] if a8 < len(FLUSH_SOURCES) else str(a8)
+        return f"{src} value={a32}"
+    if name == "LoopOverrun":
+        return f"loop_us={a32}"
+    if name == "Reset":
+        cause = RESET_CAUSES[a8] if a8 < len(RESET_CAUSES) else a8
+        section = LOOP_SECTIONS[a32] if a32 < len(LOOP_SECTIONS) else a32
+        return f"cause={cause} section={section}"
+    return ""
+
+
+def decode(buf, writer, raw=False):
+    rows = 0
+    for ftype, payload in [("R", buf)] if raw else frames(buf):
+        if ftype == "H":
+            dropped, count = struct.unpack_from("<HB", payload)
+            if dropped:
+                print(f"warning: {dropped} records dropped before this dump",
+                      file=sys.stderr)
+        elif ftype == "R":
+            (t,) = struct.unpack_from("<I", payload)
+            for off in range(4, len(payload), RECORD.size):
+                etype, a8, dt, a32 = RECORD.unpack_from(payload, off)
+                name = EVENTS[etype] if etype < len(EVENTS) else f"Unknown{etype}"
+                if name == "TimeSync":
+                    t = a32
+                    continue
+                t += dt
+                writer.writerow([t, name, a8, a32, describe(name, a8, a32)])
+                rows += 1
+    return rows
+
+
+BLOCK_SIZE = 512
+BLOCK_MAGIC = b"STLG"
+BLOCK_HEADER = struct.Struct("<4sIIBB")
+
+
+def decode_blocks(buf, writer):
+    blocks = []
+    for off in range(0, len(buf) - BLOCK_SIZE + 1, BLOCK_SIZE):
+        block = buf[off:off + BLOCK_SIZE]
+        if block[:4] != BLOCK_MAGIC:
+            continue
+        (crc,) = struct.unpack_from("<H", block, BLOCK_SIZE - 2)
+        if crc16(block[:BLOCK_SIZE - 2]) != crc:
+            continue
+        _, seq, base, count, version = BLOCK_HEADER.unpack_from(block)
+        if version == 1:
+            blocks.append((seq, base, block[BLOCK_HEADER.size:
+                                           BLOCK_HEADER.size + count * RECORD.size]))
+
+    rows = 0
+    prev = None
+    for seq, base, records in sorted(blocks):
+        if prev is not None and seq != prev + 1:
+            print(f"warning: blocks {prev + 1}..{seq - 1} missing", file=sys.stderr)
+        prev = seq
+        rows += decode(struct.pack("<I", base) + records, writer, raw=True)
+    return rows
+
+
+def open_port(port, baud):
+    import serial  # pyserial
+
+    ser = serial.Serial(port, baud, timeout=0.2)
+    time.sleep(2.0)  # opening the port resets the Mega
+    ser.reset_input_buffer()
+    return ser
+
+
+def request_dump(ser, timeout):
+    ser.write(b"dump\n")
+    buf = bytearray()
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        buf += ser.read(256)
+        # The trailer frame ('T', empty payload) ends the dump.
+        if b"\xa5\x5aT\x00" in buf:
+            buf += ser.read(2)
+            break
+    return bytes(buf)
+
+
+def read_port(port, baud, timeout):
+    with open_port(port, baud) as ser:
+        return request_dump(ser, timeout)
+
+
+def follow_port(port, baud, timeout, interval, writer):
+    """Poll for dumps until interrupted; returns the number of rows."""
+    rows = 0
+    with open_port(port, baud) as ser:
+        try:
+            while True:
+                rows += decode(request_dump(ser, timeout), writer)
+                sys.stdout.flush()
+                time.sleep(interval)
+        except KeyboardInterrupt:
+            pass
+    return rows
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("capture", nargs="?", help="raw serial capture file")
+    ap.add_argument("--sd", metavar="IMAGE",
+                    help="decode log blocks from LOG.BIN or a card image")
+    ap.add_argument("--port", help="read a fresh dump from this serial port")
+    ap.add_argument("--baud", type=int, default=250000)
+    ap.add_argument("--timeout", type=float, default=10.0)
+    ap.add_argument("--follow", action="store_true",
+                    help="with --port, keep the port open and poll until Ctrl-C")
+    ap.add_argument("--interval", type=float, default=5.0,
+                    help="seconds between --follow polls (default 5)")
+    ap.add_argument("--no-header", action="store_true",
+                    help="omit the CSV header (for appending)")
+    args = ap.parse_args()
+    if args.follow and not args.port:
+        ap.error("--follow needs --port")
+
+    writer = csv.writer(sys.stdout)
+    if not args.no_header:
+        writer.writerow(["time_ms", "event", "a8", "a32", "detail"])
+
+    if args.follow:
+        rows = follow_port(args.port, args.baud, args.timeout, args.interval, writer)
+        print(f"{rows} records", file=sys.stderr)
+        return
+
+    if args.sd:
+        with open(args.sd, "rb") as f:
+            buf = f.read()
+    elif args.port:
+        buf = read_port(args.port, args.baud, args.timeout)
+    elif args.capture:
+        with open(args.capture, "rb") as f:
+            buf = f.read()
+    else:
+        ap.error("give a capture file, --sd or --port")
+
+    rows = decode_blocks(buf, writer) if args.sd else decode(buf, writer)
+    print(f"{rows} records", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
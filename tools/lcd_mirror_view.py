@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+"""Rebuild the screen tapper's LCD from its mirror stream.
+
+With LCD_MIRROR defined the firmware sends the 128x64 screen over the
+serial port as changed 8x8 tiles (see screen_tapper/lcd_mirror.h). Watch a
+unit live (needs pyserial), or replay a capture of the port:
+
+    lcd_mirror_view.py --port /dev/ttyACM0
+    lcd_mirror_view.py capture.bin            # last screen in the capture
+    lcd_mirror_view.py --all capture.bin      # every screen
+    lcd_mirror_view.py --record frames/ capture.bin
+
+--record writes every screen as a PBM image named after its millis()
+stamp, which most image viewers open and ffmpeg can turn into a video.
+Console text and event-log frames in the stream are skipped.
+"""
+
+import argparse
+import os
+import struct
+import sys
+import time
+
+from event_log_decode import SYNC, crc16, frames
+
+WIDTH, HEIGHT = 128, 64
+COLS = WIDTH // 8
+RUN_FLAG = 0x80
+
+
+class Screen:
+    def __init__(self):
+        self.fb = bytearray(WIDTH * HEIGHT // 8)    # 16 bytes per row, MSB left
+        self.tiles = 0
+        self.bytes = 0
+
+    def apply(self, payload):
+        """Apply one 'D' frame."""
+        self.bytes += len(payload) + 6
+        i = 0
+        while i < len(payload):
+            head = payload[i]
+            if head & RUN_FLAG:
+                if i + 3 > len(payload):
+                    return
+                fill, n = payload[i + 1], payload[i + 2]
+                for t in range(head & 0x7F, min((head & 0x7F) + n, COLS * 8)):
+                    self.put(t, bytes([fill]) * 8)
+                    self.tiles += 1
+                i += 3
+            else:
+                if i + 9 > len(payload):
+                    return
+                self.put(head, payload[i + 1:i + 9])
+                self.tiles += 1
+                i += 9
+
+    def put(self, tile, rows):
+        base = (tile // COLS) * 8 * COLS + tile % COLS
+        for r in range(8):
+            self.fb[base + r * COLS] = rows[r]
+
+    def pixel(self, x, y):
+        return self.fb[y * COLS + x // 8] & (0x80 >> (x & 7))
+
+    def text(self):
+        """Two pixel rows per line with half-block characters."""
+        blocks = " ▀▄█"
+        lines = []
+        for y in range(0, HEIGHT, 2):
+            lines.append("".join(blocks[(1 if self.pixel(x, y) else 0) |
+                                        (2 if self.pixel(x, y + 1) else 0)]
+                                 for x in range(WIDTH)))
+        return "\n".join(lines)
+
+    def pbm(self):
+        return b"P4\n%d %d\n" % (WIDTH, HEIGHT) + bytes(self.fb)
+
+
+def show(screen, ms, live):
+    if live:
+        sys.stdout.write("\x1b[H\x1b[2J")
+    border = "+" + "-" * WIDTH + "+"
+    print(f"{ms / 1000:.3f} s   {screen.tiles} tiles, {screen.bytes} bytes")
+    print(border)
+    for line in screen.text().splitlines():
+        print("|" + line + "|")
+    print(border)
+    sys.stdout.flush()
+
+
+def handle(screen, ftype, payload, args, live):
+    """Apply a frame; returns the screen's millis() at the end of a screen."""
+    if ftype == "D":
+        screen.apply(payload)
+    elif ftype == "F" and len(payload) == 4:
+        (ms,) = struct.unpack("<I", payload)
+        if args.record:
+            with open(os.path.join(args.record, f"screen_{ms:010d}.pbm"), "wb") as f:
+                f.write(screen.pbm())
+        if live or args.all:
+            show(screen, ms, live)
+        screen.tiles = screen.bytes = 0
+        return ms
+    return None
+
+
+def replay(path, args):
+    with open(path, "rb") as f:
+        buf = f.read()
+    screen, last, count = Screen(), None, 0
+    for ftype, payload in frames(buf):
+        ms = handle(screen, ftype, payload, args, live=False)
+        if ms is not None:
+            last, count = ms, count + 1
+    if last is None:
+        sys.exit("no mirror frames found (is LCD_MIRROR defined?)")
+    if not args.all:
+        show(screen, last, live=False)
+    print(f"{count} screens", file=sys.stderr)
+
+
+def take_frames(buf):
+    """Split buf into its complete frames and the unfinished tail."""
+    out, i, keep = [], 0, 0
+    while True:
+        i = buf.find(SYNC, i)
+        if i < 0:
+            return out, buf[max(keep, len(buf) - 1):]
+        if i + 6 > len(buf) or i + 6 + buf[i + 3] > len(buf):
+            return out, buf[i:]
+        end = i + 4 + buf[i + 3]
+        payload = buf[i + 4:end]
+        (crc,) = struct.unpack_from("<H", buf, end)
+        if crc16(buf[i + 2:end]) == crc:
+            out.append((chr(buf[i + 2]), payload))
+            i = keep = end + 2
+        else:
+            i += 1
+
+
+def watch(port, args):
+    import serial  # pyserial
+
+    screen = Screen()
+    with serial.Serial(port, args.baud, timeout=0.2) as ser:
+        time.sleep(2.0)  # opening the port resets the Mega
+        ser.write(b"mirror on\n")
+        buf = b""
+        while True:
+            found, buf = take_frames(buf + ser.read(256))
+            for ftype, payload in found:
+                handle(screen, ftype, payload, args, live=True)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("capture", nargs="?", help="raw serial capture file")
+    ap.add_argument("--port", help="watch this serial port live")
+    ap.add_argument("--baud", type=int, default=250000)
+    ap.add_argument("--all", action="store_true", help="print every screen, not just the last")
+    ap.add_argument("--record", metavar="DIR", help="write every screen to DIR as PBM")
+    args = ap.parse_args()
+
+    if args.record:
+        os.makedirs(args.record, exist_ok=True)
+    if args.port:
+        try:
+            watch(args.port, args)
+        except KeyboardInterrupt:
+            pass
+    elif args.capture:
+        replay(args.capture, args)
+    else:
+        ap.error("give a capture file or --port")
+
+
+if __name__ == "__main__":
+    main()
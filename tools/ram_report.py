@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+"""Report static SRAM (.data + .bss) by module for a screen tapper build.
+
+Point it at the Arduino build directory (File > Preferences > "Show verbose
+output during compilation" prints it, or use arduino-cli's --build-path):
+
+    ram_report.py /tmp/arduino/sketches/XXXX
+    ram_report.py --nm avr-nm --top 5 build/
+
+Every object file under the directory is listed with its .data and .bss
+bytes, largest first. Sketch modules, libraries and the core are reported
+separately, and the total is compared with the ATmega2560's 8 KB of SRAM so
+the headroom left for the stack is visible. Symbol sizes come from nm.
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+
+SRAM_BYTES = 8192
+DATA_TYPES = "dD"   # initialized data (also costs flash for its image)
+BSS_TYPES = "bB"    # zero-initialized
+
+
+def object_files(root):
+    for dirpath, _, files in os.walk(root):
+        for name in files:
+            if name.endswith(".o"):
+                yield os.path.join(dirpath, name)
+
+
+def symbol_sizes(nm, path):
+    """Yield (type, size, name) for every sized data/bss symbol in path."""
+    out = subprocess.run([nm, "-S", "-C", "--size-sort", path],
+                         capture_output=True, text=True, check=False).stdout
+    for line in out.splitlines():
+        parts = line.split(None, 3)
+        if len(parts) == 4 and parts[2] in DATA_TYPES + BSS_TYPES:
+            yield parts[2], int(parts[1], 16), parts[3]
+
+
+def group_of(root, path):
+    rel = os.path.relpath(path, root).replace(os.sep, "/")
+    if rel.startswith("core/"):
+        return "core"
+    if rel.startswith("libraries/"):
+        return "library"
+    return "sketch"
+
+
+def module_name(path):
+    name = os.path.basename(path)
+    for suffix in (".o", ".cpp", ".c", ".S", ".ino"):
+        if name.endswith(suffix):
+            name = name[: -len(suffix)]
+    return name
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("build_dir", help="Arduino build directory")
+    ap.add_argument("--nm", default="avr-nm", help="nm binary (default avr-nm)")
+    ap.add_argument("--top", type=int, default=3,
+                    help="largest symbols to list per module (default 3)")
+    args = ap.parse_args()
+
+    rows = []
+    for path in object_files(args.build_dir):
+        syms = list(symbol_sizes(args.nm, path))
+        data = sum(s for t, s, _ in syms if t in DATA_TYPES)
+        bss = sum(s for t, s, _ in syms if t in BSS_TYPES)
+        if data or bss:
+            biggest = sorted(syms, key=lambda x: -x[1])[: args.top]
+            rows.append((group_of(args.build_dir, path), module_name(path),
+                         data, bss, biggest))
+
+    if not rows:
+        sys.exit(f"no data/bss symbols found under {args.build_dir}")
+
+    rows.sort(key=lambda r: -(r[2] + r[3]))
+    print(f"{'group':8} {'module':24} {'data':>6} {'bss':>6} {'total':>6}  largest")
+    totals = {}
+    for group, name, data, bss, biggest in rows:
+        top = ", ".join(f"{sym}={size}" for _, size, sym in biggest)
+        print(f"{group:8} {name:24} {data:6} {bss:6} {data + bss:6}  {top}")
+        g = totals.setdefault(group, [0, 0])
+        g[0] += data
+        g[1] += bss
+
+    print()
+    grand = 0
+    for group, (data, bss) in sorted(totals.items()):
+        print(f"{group:8} {'':24} {data:6} {bss:6} {data + bss:6}")
+        grand += data + bss
+    print(f"{'total':8} {'':24} {'':6} {'':6} {grand:6}  "
+          f"({SRAM_BYTES - grand} of {SRAM_BYTES} left for heap and stack)")
+
+
+if __name__ == "__main__":
+    main()